@@ -242,7 +242,6 @@ function do_squat {
     #pre-Q report
     echo "Generate pre-assembly reports" | tee -a ${SEQDIR}/${DATA}.log
     ${EXECDIR}/library/preQ/readQdist ${ECVLOC} ${SEQDIR}/pre_report 2>&1 > /dev/null
-    cp -r ${EXECDIR}/library/preQ/link ${SEQDIR}/
     
     #analysis modules
     echo "Generate post-assembly reports" | tee -a ${SEQDIR}/${DATA}.log
@@ -266,7 +265,7 @@ function do_squat {
         rm ${DATA}_report.zip &> /dev/null
     fi
     mkdir -p ${DATA}_report/${DATA}; cp ${DATA}.html ${DATA}_report/
-    cp -r ${DATA}/*report.htm* ${DATA}/link ${DATA}_report/${DATA}/ 2>&1 > /dev/null
+    cp -r ${DATA}/*report.htm* ${DATA}_report/${DATA}/ 2>&1 > /dev/null
     zip ${DATA}_report.zip -r9 ${DATA}_report &> /dev/null
     rm -r ${DATA}_report &> /dev/null
 }
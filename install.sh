@@ -34,4 +34,14 @@ cp ${INSTDIR}/library/quast_code/* ${INSTDIR}/quast/quast_libs
 #build readQdist
 echo "build files for generating pre-assembly quality report"
 cd ${INSTDIR}/library/preQ
-bash ${INSTDIR}/library/preQ/_build.sh
\ No newline at end of file
+bash ${INSTDIR}/library/preQ/_build.sh
+
+#build native map_proc utilities
+echo "build native utilities for mapping post-processing"
+cd ${INSTDIR}/library/map_proc/utils
+bash ${INSTDIR}/library/map_proc/utils/_build.sh
+
+#build native assembly statistics (GC content hook of quast)
+echo "build native assembly statistics"
+cd ${INSTDIR}/library/asmQ
+bash ${INSTDIR}/library/asmQ/_build.sh
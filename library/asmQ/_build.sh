@@ -0,0 +1,2 @@
+echo "g++ -O3 -pthread asmStats.cpp -o asmStats"
+g++ -O3 -pthread asmStats.cpp -o asmStats
@@ -0,0 +1,374 @@
+/*
+== Assembly statistics: GC-window and per-contig GC histograms, N50/L50 and N content; update: 2026/10
+The FASTA file is memory-mapped and the contigs are processed in parallel;
+results are written as JSON for the GC_content hook of quast_code/basic_stats.py
+*/
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+#define MIN(x,y) ((x < y) ? x : y)
+#define MAX(x,y) ((x > y) ? x : y)
+
+//=============================================================================
+// same defaults as quast (qconfig.GC_bin_size, qconfig.GC_contig_bin_size)
+#define WINDOW_SIZE 100
+#define GC_BIN_SIZE 1.0
+#define GC_CONTIG_BIN_SIZE 1.0
+
+struct Contig
+{
+	const char *name; // header without '>'
+	size_t NameLen;
+	const char *beg, *end; // sequence lines
+	uint64_t len, Ns, GC;
+};
+
+struct Hist
+{
+	vector<uint64_t> window, contig;
+};
+
+static uint64_t WindowSize = WINDOW_SIZE;
+static double GCBinSize = GC_BIN_SIZE, GCContigBinSize = GC_CONTIG_BIN_SIZE;
+
+//=============================================================================
+// Count G/C and N (either case) in s[0..n)
+static inline void CountGCN(const char *s, size_t n, uint64_t &gc, uint64_t &nn)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	const __m128i lower = _mm_set1_epi8(0x20);
+	const __m128i g = _mm_set1_epi8('g'), c = _mm_set1_epi8('c'), N = _mm_set1_epi8('n');
+	for (; i+16 <= n; i += 16)
+	{
+		__m128i b = _mm_or_si128(_mm_loadu_si128((const __m128i *)(s+i)), lower);
+		unsigned mgc = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, g), _mm_cmpeq_epi8(b, c)));
+		unsigned mn = _mm_movemask_epi8(_mm_cmpeq_epi8(b, N));
+		gc += __builtin_popcount(mgc);
+		nn += __builtin_popcount(mn);
+	}
+#endif
+	for (; i<n; i++)
+	{
+		char b = s[i] | 0x20;
+		gc += (b == 'g' || b == 'c');
+		nn += (b == 'n');
+	}
+}
+
+// Window of ACGT_len bases with GC_len G/C; windows with less than half ACGT letters are skipped
+static inline void AddWindow(Hist &h, uint64_t len, uint64_t gc, uint64_t nn)
+{
+	uint64_t ACGTlen = len - nn;
+	if ((double)ACGTlen < (double)WindowSize/2)
+		return;
+	double GCpct = 100.0 * gc / ACGTlen;
+	size_t idx = (size_t)((double)(int)(GCpct / GCBinSize) * GCBinSize);
+	if (idx < h.window.size())
+		h.window[idx]++;
+}
+
+//=============================================================================
+// Walk the sequence lines of one contig, cutting them into non-overlapping windows
+void ContigStats(Contig &ctg, Hist &h)
+{
+	uint64_t wlen = 0, wgc = 0, wn = 0;
+	const char *p = ctg.beg;
+
+	while (p < ctg.end)
+	{
+		const char *eol = (const char *)memchr(p, '\n', ctg.end-p);
+		if (eol == NULL)
+			eol = ctg.end;
+		size_t n = eol - p;
+		if (n > 0 && p[n-1] == '\r')
+			n--;
+
+		while (n > 0)
+		{
+			size_t chunk = MIN(n, (size_t)(WindowSize - wlen));
+			uint64_t gc = 0, nn = 0;
+			CountGCN(p, chunk, gc, nn);
+			wlen += chunk; wgc += gc; wn += nn;
+			ctg.len += chunk; ctg.GC += gc; ctg.Ns += nn;
+			p += chunk; n -= chunk;
+			if (wlen == WindowSize)
+			{
+				AddWindow(h, wlen, wgc, wn);
+				wlen = wgc = wn = 0;
+			}
+		}
+		p = eol + 1;
+	}
+	if (wlen > 0)
+		AddWindow(h, wlen, wgc, wn);
+
+	uint64_t ACGTlen = ctg.len - ctg.Ns;
+	if (ACGTlen > 0)
+	{
+		double GCpct = 100.0 * ctg.GC / ACGTlen;
+		size_t idx = (size_t)(GCpct / GCContigBinSize);
+		if (idx < h.contig.size())
+			h.contig[idx]++;
+	}
+}
+
+//=============================================================================
+// Split the mapped file into contigs; '>' only occurs in header lines
+bool ScanContigs(const char *buf, size_t size, vector<Contig> &contigs)
+{
+	const char *p = buf, *end = buf + size;
+
+	while (p < end)
+	{
+		const char *h = (const char *)memchr(p, '>', end-p);
+		if (h == NULL)
+			break;
+		if (h != buf && h[-1] != '\n')
+		{
+			p = h + 1;
+			continue;
+		}
+		if (contigs.empty() && h != buf)
+		{
+			for (const char *q=buf; q<h; q++)
+			{
+				if (!isspace(*q))
+				{
+					printf("FASTA file format error: sequence before the first header\n");
+					return false;
+				}
+			}
+		}
+		if (!contigs.empty())
+			contigs.back().end = h;
+
+		const char *eol = (const char *)memchr(h, '\n', end-h);
+		if (eol == NULL)
+			eol = end;
+		Contig ctg;
+		memset(&ctg, 0, sizeof(ctg));
+		ctg.name = h + 1;
+		while (ctg.name + ctg.NameLen < eol && !isspace(ctg.name[ctg.NameLen]))
+			ctg.NameLen++;
+		ctg.beg = MIN(eol + 1, end);
+		ctg.end = end;
+		contigs.push_back(ctg);
+		p = ctg.beg;
+	}
+	return true;
+}
+
+// N50/L50 of the contig lengths
+void NxStats(vector<uint64_t> lens, uint64_t total, uint64_t &N50, uint64_t &L50)
+{
+	sort(lens.begin(), lens.end(), greater<uint64_t>());
+	uint64_t sum = 0;
+	N50 = L50 = 0;
+	for (size_t i=0; i<lens.size(); i++)
+	{
+		sum += lens[i];
+		if (sum*2 >= total)
+		{
+			N50 = lens[i];
+			L50 = i+1;
+			break;
+		}
+	}
+}
+
+void PutJSONString(FILE *fp, const char *s, size_t n)
+{
+	fputc('"', fp);
+	for (size_t i=0; i<n; i++)
+	{
+		if (s[i] == '"' || s[i] == '\\')
+			fputc('\\', fp);
+		if ((unsigned char)s[i] >= 0x20)
+			fputc(s[i], fp);
+	}
+	fputc('"', fp);
+}
+
+void PutJSONArray(FILE *fp, const char *key, const vector<uint64_t> &v)
+{
+	fprintf(fp, "  \"%s\": [", key);
+	for (size_t i=0; i<v.size(); i++)
+		fprintf(fp, "%s%lu", i ? ", " : "", v[i]);
+	fprintf(fp, "],\n");
+}
+
+//=============================================================================
+bool AsmStats(const char *in, const char *out, int threads)
+{
+	int fd = open(in, O_RDONLY);
+	if (fd < 0)
+	{
+		printf("Read FASTA File Error!\n");
+		return false;
+	}
+	struct stat st;
+	fstat(fd, &st);
+	size_t size = st.st_size;
+	const char *buf = NULL;
+	if (size > 0)
+	{
+		buf = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (buf == MAP_FAILED)
+		{
+			printf("Map FASTA File Error!\n");
+			close(fd);
+			return false;
+		}
+		madvise((void *)buf, size, MADV_WILLNEED);
+	}
+
+	vector<Contig> contigs;
+	if (!ScanContigs(buf, size, contigs))
+		return false;
+
+	// contigs are claimed one at a time, so a few huge chromosomes do not stall the rest
+	size_t GCbins = (size_t)(100 / GCBinSize) + 1, GCcontigBins = (size_t)(100 / GCContigBinSize) + 1;
+	threads = MAX(1, MIN(threads, (int)contigs.size()));
+	vector<Hist> hists(threads);
+	atomic<size_t> next(0);
+	vector<thread> workers;
+	for (int t=0; t<threads; t++)
+	{
+		hists[t].window.assign(GCbins, 0);
+		hists[t].contig.assign(GCcontigBins, 0);
+		workers.push_back(thread([&, t]() {
+			size_t i;
+			while ((i = next++) < contigs.size())
+				ContigStats(contigs[i], hists[t]);
+		}));
+	}
+	for (size_t t=0; t<workers.size(); t++)
+		workers[t].join();
+
+	Hist total;
+	total.window.assign(GCbins, 0);
+	total.contig.assign(GCcontigBins, 0);
+	for (int t=0; t<threads; t++)
+	{
+		for (size_t i=0; i<GCbins; i++)
+			total.window[i] += hists[t].window[i];
+		for (size_t i=0; i<GCcontigBins; i++)
+			total.contig[i] += hists[t].contig[i];
+	}
+
+	uint64_t TotalLen = 0, TotalNs = 0, TotalGC = 0, N50, L50;
+	vector<uint64_t> lens(contigs.size());
+	for (size_t i=0; i<contigs.size(); i++)
+	{
+		lens[i] = contigs[i].len;
+		TotalLen += contigs[i].len;
+		TotalNs += contigs[i].Ns;
+		TotalGC += contigs[i].GC;
+	}
+	NxStats(lens, TotalLen, N50, L50);
+
+	FILE *fp = (out == NULL || strcmp(out, "-") == 0) ? stdout : fopen(out, "wt");
+	if (fp == NULL)
+	{
+		printf("Open OUT JSON File Error!\n");
+		return false;
+	}
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"window_size\": %lu,\n", WindowSize);
+	fprintf(fp, "  \"gc_bin_size\": %g,\n", GCBinSize);
+	fprintf(fp, "  \"gc_contig_bin_size\": %g,\n", GCContigBinSize);
+	fprintf(fp, "  \"contig_count\": %lu,\n", contigs.size());
+	fprintf(fp, "  \"total_length\": %lu,\n", TotalLen);
+	fprintf(fp, "  \"total_Ns\": %lu,\n", TotalNs);
+	fprintf(fp, "  \"total_GC_bases\": %lu,\n", TotalGC);
+	if (TotalLen > TotalNs)
+		fprintf(fp, "  \"GC_percent\": %.6f,\n", 100.0 * TotalGC / (TotalLen - TotalNs));
+	else
+		fprintf(fp, "  \"GC_percent\": null,\n");
+	fprintf(fp, "  \"N50\": %lu,\n", N50);
+	fprintf(fp, "  \"L50\": %lu,\n", L50);
+	PutJSONArray(fp, "GC_windows", total.window);
+	PutJSONArray(fp, "GC_contigs", total.contig);
+	fprintf(fp, "  \"contigs\": [");
+	for (size_t i=0; i<contigs.size(); i++)
+	{
+		fprintf(fp, "%s\n    [", i ? "," : "");
+		PutJSONString(fp, contigs[i].name, contigs[i].NameLen);
+		fprintf(fp, ", %lu, %lu, %lu]", contigs[i].len, contigs[i].Ns, contigs[i].GC);
+	}
+	fprintf(fp, "\n  ]\n}\n");
+	if (fp != stdout)
+		fclose(fp);
+
+	if (buf != NULL)
+		munmap((void *)buf, size);
+	close(fd);
+	return true;
+}
+
+
+
+//=============================================================================
+int main(int argc, char **argv)
+{
+//=============================================================================
+	const char *out = NULL;
+	int threads = (int)thread::hardware_concurrency();
+	vector<char *> args;
+
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+			out = argv[++i];
+		else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0 && i+1 < argc)
+			WindowSize = strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "-b") == 0 && i+1 < argc)
+			GCBinSize = atof(argv[++i]);
+		else if (strcmp(argv[i], "-B") == 0 && i+1 < argc)
+			GCContigBinSize = atof(argv[++i]);
+		else
+			args.push_back(argv[i]);
+	}
+
+	if (args.size() != 1 || WindowSize == 0 || GCBinSize <= 0 || GCContigBinSize <= 0)
+	{
+		printf("=== asmStats: GC distribution, N50/L50 and N content of an assembly ===\n\n");
+		printf("Usage: asmStats contigs.fa [-o out.json] [-t threads] [-w window] [-b binSize] [-B contigBinSize]\n");
+		printf(" -o: Optional. JSON output, default stdout\n");
+		printf(" -t: Optional. Number of threads, default all cores\n");
+		printf(" -w: Optional. Size of the non-overlapping GC windows, default %d\n", WINDOW_SIZE);
+		printf(" -b/-B: Optional. GC%% bin size of the window/contig histograms, default %g/%g\n", GC_BIN_SIZE, GC_CONTIG_BIN_SIZE);
+		printf("Verson: 1.0 (2026/10) \n\n");
+
+		return 1;
+	}
+
+//=============================================================================
+	if (!AsmStats(args[0], out, threads))
+		return 1;
+
+//=============================================================================
+	return 0;
+}
@@ -3,10 +3,7 @@ import optparse
 import os
 import re
 import numpy as np 
-import matplotlib; matplotlib.use('pdf')
-import matplotlib.pyplot as plt
-import pickle
-import shutil
+import subprocess
 import plotter
 
 from importlib import reload
@@ -15,7 +12,7 @@ def build_subset(subset_label, label_list, in_fpath, out_fpath):
 	id_list = []
 	
 	for label in subset_label:
-		id_list = id_list + list(np.where(label_list == label)[0])
+		id_list = id_list + list(plotter.label_ids(label_list, label))
 	id_list.sort()
 
 	if len(id_list) == 0:
@@ -41,115 +38,149 @@ def build_subset(subset_label, label_list, in_fpath, out_fpath):
 					read_id += 1
 
 
-def extract_sam_info(data, read_size, sam_file):
-	"""Extract most information from sam file."""
+def build_subset_native(outputs, info_fpath, in_fpath, exec_fpath):
+	"""Extract the subsets with labelSubset in one pass over the offset index of the reads;
+	outputs lists (labels, out_fpath). Returns False if the tool is not built."""
+	tool = exec_fpath + '/library/map_proc/utils/labelSubset'
+	if not os.access(tool, os.X_OK):
+		return False
 
-	from collections import defaultdict
-	#array indexed by read ID
-	align_array = np.array([defaultdict(list) for i in range(read_size)])
+	cmd = [tool, in_fpath, info_fpath]
+	index_fpath = os.path.splitext(in_fpath)[0] + '.fqi'
+	if os.path.isfile(index_fpath):
+		cmd += ['-x', index_fpath]
+	for labels, out_fpath in outputs:
+		cmd += ['-o', '{0}={1}'.format(labels, out_fpath)]
 
-	with open(sam_file, 'r') as infile:
-		crt_id = None
-		idx = -1
-		for line in infile:
-			#skip header
-			if re.search('^(?!@)', line):
-				line = line.split('\t')
-				[_id, flag, scaffold, pos, mapQ, cigar, _, _, _, seq, _] = line[:11]
-				if _id != crt_id:
-					idx += 1
-					crt_id = _id
-				#_id = int(_id)
-				align_array[idx]['id'].append(_id)
-				align_array[idx]['flag'].append(int(flag))
-				align_array[idx]['scaffold'].append(scaffold)
-				align_array[idx]['pos'].append(pos)
-				align_array[idx]['mapQ'].append(int(mapQ))
-				align_array[idx]['cigar'].append(cigar)
-				align_array[idx]['seq'].append(seq)
-				for col in line:
-					if re.search('^NM:i:[0-9]+$', col):
-						num_NM = int(col.split(':')[-1])
-						align_array[idx]['num_mismatch'].append(num_NM)
-					if re.search('^AS:i:-*[0-9]+$', col):
-						AS = int(col.split(':')[-1])
-						align_array[idx]['AS'].append(AS)
-
-	#assert _id + 1 == read_size
-	return align_array
+	output = subprocess.check_output(cmd).decode()
+	if int(output.split('\n')[0].split('\t')[1]) == 0:
+		raise ValueError("Subset size is zero.")
+	return True
 
 
 def extract_sam_info_primary(data, read_size, sam_file):
-	"""Extract most information from sam file."""
-
-	from collections import defaultdict
-	#array indexed by read ID
-	align_array = np.array([{} for i in range(read_size)])
+	"""Extract the columns of the primary alignments needed by the plots, one array per field indexed by read."""
+
+	align_array = {
+		'flag': np.zeros(read_size, dtype=np.int32),
+		'mapQ': np.zeros(read_size, dtype=np.uint8),
+		'num_mismatch': np.zeros(read_size, dtype=np.int32),
+		'AS': np.zeros(read_size, dtype=np.int32),
+		'seq_len': np.zeros(read_size, dtype=np.int32),
+		'n_count': np.zeros(read_size, dtype=np.int32),
+		#cigar: total length, soft clips and I/D/P/=/X
+		'cigar_len': np.zeros(read_size, dtype=np.int32),
+		'clip': np.zeros(read_size, dtype=np.int32),
+		'other': np.zeros(read_size, dtype=np.int32),
+	}
+	cigar_op = re.compile('(\\d+)([MIDNSHP=X])')
 
 	with open(sam_file, 'r') as infile:
 		crt_id = None
 		idx = -1
 		for line in infile:
 			#skip header
-			if re.search('^(?!@)', line):
-				line = line.split('\t')
-				[_id, flag, scaffold, pos, mapQ, cigar, _, _, _, seq, _] = line[:11]
-				if _id != crt_id:
-					idx += 1
-					crt_id = _id
-					#_id = int(_id)
-					align_array[idx]['id'] = int(_id)
-					align_array[idx]['flag'] = int(flag)
-					align_array[idx]['scaffold'] = scaffold
-					align_array[idx]['pos'] = pos
-					align_array[idx]['mapQ'] = int(mapQ)
-					align_array[idx]['cigar'] = cigar
-					align_array[idx]['seq'] = seq
-					for col in line:
-						if re.search('^NM:i:[0-9]+$', col):
-							num_NM = int(col.split(':')[-1])
-							align_array[idx]['num_mismatch'] = num_NM
-						if re.search('^AS:i:-*[0-9]+$', col):
-							AS = int(col.split(':')[-1])
-							align_array[idx]['AS'] = AS
+			if line[0] == '@':
+				continue
+			line = line.split('\t')
+			[_id, flag, scaffold, pos, mapQ, cigar, _, _, _, seq, _] = line[:11]
+			if _id == crt_id:
+				continue
+			idx += 1
+			crt_id = _id
+			align_array['flag'][idx] = int(flag)
+			align_array['mapQ'][idx] = int(mapQ)
+			align_array['seq_len'][idx] = len(seq)
+			align_array['n_count'][idx] = seq.count('N')
+			length, clip_size, o_size = 0, 0, 0
+			for num, op in cigar_op.findall(cigar):
+				length += int(num)
+				if op == 'S':
+					clip_size += int(num)
+				elif op in 'IDP=X':
+					o_size += int(num)
+			align_array['cigar_len'][idx] = length
+			align_array['clip'][idx] = clip_size
+			align_array['other'][idx] = o_size
+			for col in line[11:]:
+				if col.startswith('NM:i:'):
+					align_array['num_mismatch'][idx] = int(col[5:])
+				elif col.startswith('AS:i:'):
+					align_array['AS'][idx] = int(col[5:])
 
 	#assert _id + 1 == read_size
 	return align_array
 
 
-def get_label_distribution(labels, aln_tool_list, src_dir, data, read_size):
-	num_label = len(labels)
+def load_align_info(data, read_size, sam_file):
+	"""Alignment columns, cached next to the sam file."""
+	path = '/'.join(sam_file.split('/')[:-1])+'/align_info.npz'
+	try:
+		with np.load(path) as cache:
+			return {key: cache[key] for key in cache.files}
+	except (IOError, ValueError):
+		align_array = extract_sam_info_primary(data, read_size, sam_file)
+		np.savez(path, **align_array)
+		return align_array
+
+
+def get_label_distribution(labels, label_dict, aln_tool_list, read_size):
 	stats = {aln_tool: {key: None for key in labels} for aln_tool in aln_tool_list}
 
 	#stats[aln_tool][label] = #reads / #total: 4*8
 	for aln_tool in aln_tool_list:
-		with open('{0}/{1}/ids/{2}_0_reads.cnt'.format(src_dir, aln_tool, data), 'r') as infile:
-			for i in range(num_label):
-				[num_reads, name] = infile.readline().strip().split()
-				#if 'backtrack' in aln_tool and labels[i] == 'C':
-				#	stats[aln_tool][labels[i]]	= 'N/A'
-				stats[aln_tool][labels[i]] = int(num_reads) / read_size
+		counts = plotter.label_counts(label_dict[aln_tool])
+		for i, label in enumerate(labels):
+			stats[aln_tool][label] = int(counts[i]) / read_size
 
 	return stats
 
 
-def draw_label_dis_bar(label_dict, align_info_dict, src_dir, aln_tool_list, plot_figures):
+def get_label_confusion(label_dict, aln_tool_list, src_dir):
+	"""Read counts by the labels of each pair of aligners, written to label_dis/label_confusion.csv."""
+	num_codes = len(plotter.labels) + 1
+	confusion = {}
+	dirname='{}/label_dis'.format(src_dir)
+	if not os.path.isdir(dirname):
+		os.makedirs(dirname)
+
+	with open('{}/label_confusion.csv'.format(dirname), 'w') as w:
+		for i, tool1 in enumerate(aln_tool_list):
+			for tool2 in aln_tool_list[i+1:]:
+				size = min(len(label_dict[tool1]), len(label_dict[tool2]))
+				pair = label_dict[tool1][:size].astype(np.int64) * num_codes + label_dict[tool2][:size]
+				matrix = np.bincount(pair, minlength=num_codes*num_codes).reshape(num_codes, num_codes)[:-1, :-1]
+				confusion[(tool1, tool2)] = matrix
+				w.write('{0} \\ {1},{2}\n'.format(tool1, tool2, ','.join(plotter.labels)))
+				for label, row in zip(plotter.labels, matrix):
+					w.write('{0},{1}\n'.format(label, ','.join(str(v) for v in row)))
+				w.write('\n')
+
+	return confusion
+
+
+def get_label_dis_bar(label_dict, align_info_dict, aln_tool_list):
 	neg_vals = {'F': [], 'S': [], 'C': [], 'O': [], 'N': []}
-	cigar_dict, poor_pct_list = {}, np.zeros(len(aln_tool_list))
-	fig = plt.figure(figsize=(15, 10))
-	ymax, ymin = 0, 0
-	ax_list = [None] * len(aln_tool_list)
+	cigar_dict, poor_pct_list, bar_list = {}, np.zeros(len(aln_tool_list)), []
 
 	for i, aln_tool in enumerate(aln_tool_list):
-		ax_list[i] = fig.add_subplot(len(aln_tool_list) / 2, 2, i+1)
-		cigar_dict[aln_tool], poor_pct_list[i], ax_ymax, ax_ymin= plotter.do_label_dis_bar(ax_list[i], align_info_dict[aln_tool], aln_tool, label_dict[aln_tool], thre, neg_vals)
-		#x-axis
-		ax_list[i].axhline(color='black')
-		ymax = ax_ymax if ymax < ax_ymax else ymax
-		ymin = ax_ymin if ymin > ax_ymin else ymin
+		cigar_dict[aln_tool], poor_pct_list[i], bar_data = plotter.label_dis_bar_data(align_info_dict[aln_tool], aln_tool, label_dict[aln_tool], thre, neg_vals)
+		bar_list.append(bar_data)
+
+	avg_poor_pct = np.sum(poor_pct_list) / len(poor_pct_list)
+	return bar_list, cigar_dict, avg_poor_pct, neg_vals
+
 
+def draw_label_dis_bar(bar_list, plot_figures):
+	plt = plotter.plt
+	fig = plt.figure(figsize=(15, 10))
+	ymin, ymax = plotter.bar_range(bar_list)
 
-	for ax in ax_list:
+	for i, bar_data in enumerate(bar_list):
+		ax = fig.add_subplot(len(bar_list) // 2, 2, i+1)
+		plotter.do_label_dis_bar(ax, bar_data)
+		#x-axis
+		ax.axhline(color='black')
 		ax.set_ylim([ymin - 10, ymax + 10])
 	
 	#add footnote under the barplot
@@ -158,19 +189,17 @@ def draw_label_dis_bar(label_dict, align_info_dict, src_dir, aln_tool_list, plot
 				"2. Bar below the x-axis: portion of poorly-mapped reads"
 				)
 	plt.figtext(0.1, 0.05, footnote, va="bottom", ha="left")
-	fig.savefig('{}/images/label_dis_bar.png'.format(src_dir))
 	plot_figures.append(fig)
 	plt.close()
-	avg_poor_pct = "{:.1%}".format(np.sum(poor_pct_list) / len(poor_pct_list))
-	return cigar_dict, avg_poor_pct, neg_vals
 
 
-def draw_label_dis(label_distribution, aln_tool_list, src_dir, data, read_size, ecv_fpath, plot_figures):
+def draw_label_dis(label_distribution, pie_data, aln_tool_list, src_dir, plot_figures):
 	plotter.do_label_dis_table(label_distribution, src_dir, aln_tool_list, plot_figures)
-	plotter.do_label_piechart(label_distribution, src_dir, aln_tool_list, plot_figures)
+	plotter.do_label_piechart(pie_data, plot_figures)
 
 
-def draw_genome_eval_table(stats, src_dir, plot_figures):
+def draw_genome_eval_table(stats, plot_figures):
+	plt = plotter.plt
 	new_stats = list(stats)
 	new_stats.insert(0, ["Reference sequence assembly", "Value"])
 	fig = plt.figure(figsize=(15, 10))
@@ -179,25 +208,25 @@ def draw_genome_eval_table(stats, src_dir, plot_figures):
 	fig.patch.set_visible(False)
 	ax.axis('off')
 	ax.axis('tight')
-	#draw table and savefig
+	#draw table
 	ax.table(cellText=new_stats, cellLoc='center', loc='center', fontsize=15, bbox=(0.25, 0.25, 0.5, 0.5))
 	ax.set_title('Genome evaluation stats', y = 0.8)
 	#fig.tight_layout()
-	fig.savefig('{}/images/eval_table.png'.format(src_dir))
 	plot_figures.insert(0, fig)
 
 
-def draw_dis_graph(aln_tool, label_array, align_array, src_dir, read_size, cigar_dict, plot_figures):
+def get_dis_graph(aln_tool, label_array, align_array, read_size, cigar_dict):
+	dis_list = []
 
 	#mismatch ratio
 	nm_list = cigar_dict['S']
 	if len(nm_list):
-		plotter.plot_sam_dis(src_dir, nm_list, aln_tool, label_array, read_size, plot_figures, xlabel='Mismatch%', label='S', thre=thre['MR'])
+		dis_list.append(plotter.sam_dis_data(nm_list, aln_tool, label_array, read_size, xlabel='Mismatch%', label='S', thre=thre['MR']))
 
 	#clip ratio
 	cr_list = cigar_dict['C']
 	if len(cr_list):
-		plotter.plot_sam_dis(src_dir, cr_list, aln_tool, label_array, read_size, plot_figures, xlabel='Clip%', label='C', thre=thre['CR'])
+		dis_list.append(plotter.sam_dis_data(cr_list, aln_tool, label_array, read_size, xlabel='Clip%', label='C', thre=thre['CR']))
 	
 	#aln score
 	#bwa-backtrack records no AS field
@@ -205,20 +234,27 @@ def draw_dis_graph(aln_tool, label_array, align_array, src_dir, read_size, cigar
 		for label in (['P', 'S', 'C']):
 			as_list = plotter.do_as(align_array, label_array, label)
 			if len(as_list):
-				plotter.plot_sam_dis(src_dir, as_list, aln_tool, label_array, read_size, plot_figures, xlabel='Alignment Score', label=label)
-		
+				dis_list.append(plotter.sam_dis_data(as_list, aln_tool, label_array, read_size, xlabel='Alignment Score', label=label))
+
+	return dis_list
 
 
 def get_label_dict(data, aln_tool_list, read_size):
+	"""Labels of the reads as uint8 codes (index in plotter.labels), one array per aligner."""
 	label_dict = {}
 	for aln_tool in aln_tool_list:
-		label_dict[aln_tool] = np.array([None for i in range(read_size)])
-		info_file = src_dir + '/{0}/ids/{1}_0_reads.info'.format(aln_tool, data)
-		with open(info_file, 'r') as infile:
-			idx = 0
-			for line in infile:
-				label_dict[aln_tool][idx] = line.split('\t')[1]
-				idx += 1
+		ids_dir = src_dir + '/{0}/ids/'.format(aln_tool)
+		lbl_file = ids_dir + '{0}_0_reads.lbl'.format(data)
+		if os.path.isfile(lbl_file):
+			raw = np.fromfile(lbl_file, dtype=np.uint8)
+		else:
+			raw = np.full(read_size, ord('?'), dtype=np.uint8)
+			with open(ids_dir + '{0}_0_reads.info'.format(data), 'r') as infile:
+				idx = 0
+				for line in infile:
+					raw[idx] = ord(line.split('\t')[1])
+					idx += 1
+		label_dict[aln_tool] = plotter.LABEL_CODES[raw]
 	
 	return label_dict
 
@@ -243,21 +279,50 @@ def fastq_examine(fpath, read_size):
 			next(infile)
 			cnt += 1
 
-	seq_gc = '{:.0%}'.format(gc_count / total_len)
+	seq_gc = gc_count / total_len
 	return len_min, len_max, seq_gc
 
 
 		
-def draw_basic_table(avg_poor_pct, fpath, src_dir, read_size, total_size, plot_figures):
+def get_basic_stats(avg_poor_pct, seq_info, fpath, read_size, total_size):
 	seq_name = fpath.split('/')[-1]
-	len_min, len_max, seq_gc = fastq_examine(fpath, read_size)
+	len_min, len_max, seq_gc = seq_info
 	stats = [
 			["File name", seq_name], ["No. of sequence", '{:,}'.format(total_size)],
 			["Sample size", '{:,}'.format(read_size)],
 			["Sequence length", "{0} - {1}".format(len_min, len_max)],
-			["Avg. poorly mapped sequence%", avg_poor_pct],
-			["GC%", seq_gc]
+			["Avg. poorly mapped sequence%", "{:.1%}".format(avg_poor_pct)],
+			["GC%", '{:.0%}'.format(seq_gc)]
+			]
+	return stats
+
+
+def get_metrics(avg_poor_pct, neg_vals, thre, label_distribution, aln_tool_list, seq_info, genome_stats, read_size, total_size, src_dir):
+	"""Final numbers of the report as (key, value) pairs, see plotter.save_metrics."""
+	len_min, len_max, seq_gc = seq_info
+	metrics = [
+			('total_reads', total_size), ('sample_size', read_size),
+			('min_read_len', len_min), ('max_read_len', len_max), ('gc_pct', 100 * seq_gc),
+			('pm_pct', 100 * avg_poor_pct), ('pm_threshold_pct', 100 * thre['PM']),
+			('pass', round(avg_poor_pct, 3) < thre['PM'])
 			]
+	for label in neg_vals:
+		metrics.append(('pm_type_{}_pct'.format(label.lower()), 100 * np.sum(neg_vals[label]) / len(neg_vals[label])))
+	for key in ['MR', 'CR', 'OR', 'NR']:
+		metrics.append(('{}_threshold_pct'.format(key.lower()), 100 * thre[key]))
+	for aln_tool in aln_tool_list:
+		for label in plotter.labels:
+			metrics.append(('{0}_{1}_pct'.format(plotter.metric_key(aln_tool), label.lower()), 100 * label_distribution[aln_tool][label]))
+	for name, value in genome_stats[1:]:
+		metrics.append(('asm_' + plotter.metric_key(name), value))
+	#pre-assembly numbers of readQdist, so one file holds the whole sample
+	for key, value in plotter.load_metrics(src_dir + '/pre_report.metrics.json').items():
+		metrics.append(('preq_' + key, value))
+	return metrics
+
+
+def draw_basic_table(stats, plot_figures):
+	plt = plotter.plt
 	fig = plt.figure(figsize=(15, 10))
 	ax = fig.add_subplot(111)
 	#hide axes
@@ -265,7 +330,7 @@ def draw_basic_table(avg_poor_pct, fpath, src_dir, read_size, total_size, plot_f
 	ax.axis('off')
 	ax.axis('tight')
 
-	#draw table and savefig
+	#draw table
 	new_stats = list(stats)
 	new_stats.insert(0, ["Seqeuencing reads information", "Value"])
 	the_table = ax.table(cellText=new_stats, 
@@ -273,12 +338,9 @@ def draw_basic_table(avg_poor_pct, fpath, src_dir, read_size, total_size, plot_f
 	the_table.set_fontsize(20)
 	ax.set_title('Sequence basic stats', y=0.8)
 	fig.set_tight_layout(True)
-	fig.savefig('{}/images/basic_stats.png'.format(src_dir))
 	#first page of the report
 	plot_figures.insert(0, fig)
 
-	return stats
-
 
 if __name__ == '__main__':
 	opt_parser = optparse.OptionParser(usage='usage: %prog [options] \"args\"')
@@ -293,6 +355,8 @@ if __name__ == '__main__':
 	opt_parser_group.add_option('-n', dest='sample_size', help = 'sample size, equals to read size if no random sampling')
 	opt_parser_group.add_option('-t', dest='total_size', help = 'the read size of the whole dataset')
 	opt_parser_group.add_option('-s', dest='subset', help = 'Return the subset of sequencing reads according to labels (in capitals, e.g. PSCO)', default = '')
+	opt_parser_group.add_option('-p', '--pdf', dest='pdf', action='store_true', help = 'Also write report.pdf with matplotlib', default = False)
+	opt_parser_group.add_option('-b', '--bulk', dest='bulk', action='store_true', help = 'Only write post_report.metrics.json/.tsv, no html or pdf report', default = False)
 
 	opt_parser.add_option_group(opt_parser_group)
 	(options, args) = opt_parser.parse_args()
@@ -329,55 +393,69 @@ if __name__ == '__main__':
 		thre['OR'] = float(infile.readline().split(':')[1].strip())
 		thre['NR'] = float(infile.readline().split(':')[1].strip())
 
+	#bulk mode only writes the metrics files
+	if options.bulk:
+		options.pdf = False
+	#matplotlib only draws report.pdf, the html charts are rendered from json
+	if options.pdf:
+		plotter.use_matplotlib()
+	charts = {}
+
 	print("Generate label distribution graph")
 	#label distribution table
 	label_dict = get_label_dict(data, aln_tool_list, read_size)
-	label_distribution = get_label_distribution(labels, aln_tool_list, src_dir, data, read_size)
-	draw_label_dis(label_distribution, aln_tool_list, src_dir, data, read_size, ecv_fpath, plot_figures)
+	label_distribution = get_label_distribution(labels, label_dict, aln_tool_list, read_size)
+	get_label_confusion(label_dict, aln_tool_list, src_dir)
+	charts['pie'] = plotter.label_pie_data(label_distribution, aln_tool_list)
+	if options.pdf:
+		draw_label_dis(label_distribution, charts['pie'], aln_tool_list, src_dir, plot_figures)
 
 	
 	#save alignment info for each aligner tool
 	print('Extract alignment information from sam files')
 	for aln_tool in aln_tool_list:
 		sam_file = '{0}/{1}/{2}_ecv_all.sam'.format(src_dir, aln_tool, data)
-		path = '/'.join(sam_file.split('/')[:-1])+'/align_info'
-		try:
-			align_info_dict[aln_tool] = pickle.load(open(path, 'rb'))
-		except:
-			align_info_dict[aln_tool] = extract_sam_info_primary(data, read_size, sam_file)
-			pickle.dump(align_info_dict[aln_tool], open(path, 'wb'))
+		align_info_dict[aln_tool] = load_align_info(data, read_size, sam_file)
 
-	#save label distribution bar and return cigar information
-	cigar_dict, avg_poor_pct, neg_vals = draw_label_dis_bar(label_dict, align_info_dict, src_dir, aln_tool_list, plot_figures)
+	#label distribution bar and cigar information
+	charts['bar'], cigar_dict, avg_poor_pct, neg_vals = get_label_dis_bar(label_dict, align_info_dict, aln_tool_list)
+	if options.pdf:
+		draw_label_dis_bar(charts['bar'], plot_figures)
 
-	#Plot distribution graph in terms of NM, CR, AS
+	#distribution graph in terms of NM, CR, AS
 	print("Plot label distribution graph")
-	for aln_tool in aln_tool_list:
-		dirname = "{0}/{1}/plot".format(src_dir, aln_tool)
-		if not os.path.isdir(dirname):
-			os.makedirs(dirname)
-		else:
-			shutil.rmtree(dirname)
-			os.makedirs(dirname)
-
+	charts['dist'] = {}
+	for aln_tool in ([] if options.bulk else aln_tool_list):
 		align_array = align_info_dict[aln_tool]
-		draw_dis_graph(aln_tool, label_dict[aln_tool], align_array, src_dir, read_size, cigar_dict[aln_tool], plot_figures)
+		charts['dist'][aln_tool] = get_dis_graph(aln_tool, label_dict[aln_tool], align_array, read_size, cigar_dict[aln_tool])
+		if options.pdf:
+			for dis in charts['dist'][aln_tool]:
+				plotter.plot_sam_dis(dis, plot_figures)
 
 	print('Plot genome evaluation table')
-	#draw genome evaluation table
+	#genome evaluation table
 	genome_stats = plotter.get_genome_eval_stat(src_dir, ref_fpath.split('/')[-1])
-	draw_genome_eval_table(genome_stats, src_dir, plot_figures)
+	if options.pdf:
+		draw_genome_eval_table(genome_stats, plot_figures)
 
 	print('Plot basic stats table')
-	#plot basic stats of sequences, put in the front of plot_figures
-	basic_stats = draw_basic_table(avg_poor_pct, ecv_fpath, src_dir, read_size, total_size, plot_figures)
+	#basic stats of sequences, put in the front of plot_figures
+	seq_info = fastq_examine(ecv_fpath, read_size)
+	basic_stats = get_basic_stats(avg_poor_pct, seq_info, ecv_fpath, read_size, total_size)
+	if options.pdf:
+		draw_basic_table(basic_stats, plot_figures)
+
+	#machine-readable numbers, written in every mode
+	metrics = get_metrics(avg_poor_pct, neg_vals, thre, label_distribution, aln_tool_list, seq_info, genome_stats, read_size, total_size, src_dir)
+	plotter.save_metrics(src_dir + '/post_report', 'gen_report', ecv_fpath.split('/')[-1], metrics)
 
 	#make report
 	print('Writing report')
-	all_pdf_fpath = src_dir+'/report.pdf'
 	template_fpath = exec_fpath+'/template/template.html'
-	plotter.save_to_pdf(all_pdf_fpath, plot_figures)
-	plotter.save_to_html(out_dir, template_fpath, data, thre, aln_tool_list, label_distribution, basic_stats, genome_stats, neg_vals)
+	if not options.bulk:
+		plotter.save_to_html(out_dir, template_fpath, data, thre, aln_tool_list, label_distribution, basic_stats, genome_stats, neg_vals, charts)
+	if options.pdf:
+		plotter.save_to_pdf(src_dir+'/report.pdf', plot_figures)
 
 	#output subset reads if specified
 	if options.subset != 'NONE':
@@ -386,7 +464,13 @@ if __name__ == '__main__':
 		if not os.path.isdir(dirname):
 			os.makedirs(dirname)
 
-		subset_labels = [label for label in sys.argv[5]]
+		subset_labels = [label for label in options.subset]
 		for aln_tool in aln_tool_list:
-			out_fpath = '{0}/{1}_{2}.fastq'.format(dirname, aln_tool, sys.argv[5])
-			build_subset(subset_labels, label_dict[aln_tool], ecv_fpath, out_fpath)
\ No newline at end of file
+			out_fpath = '{0}/{1}_{2}.fastq'.format(dirname, aln_tool, options.subset)
+			info_fpath = src_dir + '/{0}/ids/{1}_0_reads.info'.format(aln_tool, data)
+			#one file for all the labels and, for several labels, one per label
+			outputs = [(options.subset, out_fpath)]
+			if len(subset_labels) > 1:
+				outputs += [(label, '{0}/{1}_{2}.fastq'.format(dirname, aln_tool, label)) for label in subset_labels]
+			if not build_subset_native(outputs, info_fpath, ecv_fpath, exec_fpath):
+				build_subset(subset_labels, label_dict[aln_tool], ecv_fpath, out_fpath)
\ No newline at end of file
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+#Automatic exit from bash shell script on error
+set -e
+
+#Persistent bwa index cache keyed by the content of the assembly, shared by
+#aligners, samples and runs. Prints the index directory (prefix scaffolds).
+
+if [ "$#" -lt "2" ]; then
+	echo "Using:" $0 " [SRCDIR] [REFLOC] [CACHEDIR]"
+	echo -e "CACHEDIR defaults to \$SQUAT_INDEX_CACHE, then SRCDIR/index_cache" >&2
+	exit 1
+fi
+
+SRCDIR=$1
+REFLOC=$( readlink -f "$2" )
+CACHEDIR=${3:-${SQUAT_INDEX_CACHE:-${SRCDIR}/index_cache}}
+BWAPATH="${SRCDIR}/bwa"
+
+mkdir -p "${CACHEDIR}" &> /dev/null
+
+#fast content hash; remembered per (path, size, mtime) so unchanged assemblies are not rehashed.
+#the memo is tab-separated, so paths may hold blanks
+function hash_fasta {
+	local stamp=$( stat -c '%s:%Y' "${REFLOC}" )
+	local memo="${CACHEDIR}/hashes"
+	local key
+
+	touch "${memo}"
+	key=$( awk -F '\t' -v F="${REFLOC}" -v S="${stamp}" '$1==F && $2==S {k=$3} END {print k}' "${memo}" )
+	if [ -z "${key}" ]; then
+		if command -v xxhsum &> /dev/null; then
+			key=$( xxhsum -H64 < "${REFLOC}" | cut -d ' ' -f 1 )
+		else
+			key=$( md5sum < "${REFLOC}" | cut -d ' ' -f 1 )
+		fi
+		key="${key}-${stamp%%:*}"
+		(
+			flock 8
+			printf '%s\t%s\t%s\n' "${REFLOC}" "${stamp}" "${key}" >> "${memo}"
+		) 8> "${memo}.lock"
+	fi
+	echo ${key}
+}
+
+KEY=$( hash_fasta )
+IDXDIR="${CACHEDIR}/${KEY}"
+
+#fast path: a complete index needs no lock
+if [ ! -f "${IDXDIR}/.done" ]; then
+	(
+		#only one run builds a given index; the others wait for it here
+		flock 9
+		if [ ! -f "${IDXDIR}/.done" ]; then
+			echo "[index cache] build ${KEY}" >&2
+			TMPDIR="${IDXDIR}.tmp.$$"
+			rm -rf "${TMPDIR}" &> /dev/null
+			mkdir -p "${TMPDIR}"
+			"${BWAPATH}/bwa" index "${REFLOC}" -p "${TMPDIR}/scaffolds" > "${TMPDIR}/build.log" 2>&1
+			echo "${REFLOC}" > "${TMPDIR}/source"
+			rm -rf "${IDXDIR}" &> /dev/null
+			mv "${TMPDIR}" "${IDXDIR}"
+			touch "${IDXDIR}/.done"
+		fi
+	) 9> "${IDXDIR}.lock"
+fi
+
+echo "${IDXDIR}"
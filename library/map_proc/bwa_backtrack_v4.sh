@@ -32,7 +32,7 @@ IDXDIR="${WORKDIR}/index"
 
 BWAPATH="${SRCRDIR}/bwa"
 #SAMPATH="${SRCRDIR}/samtools"
-UTILDIR="${SRCRDIR}/libs/map_proc/utils"
+UTILDIR="${SRCRDIR}/library/map_proc/utils"
 
 function do_mkdir {
 	mkdir -p "${LOGSDIR}" &> /dev/null
@@ -56,8 +56,13 @@ function do_wipe {
 }
 
 function do_build {
-	echo "[bwa] bwt"
-	${BWAPATH}/bwa index ${REFGENOME}.fasta -p index/${REFGENOME} 2>&1 | tee ${LOGSDIR}/${DATANAME}_bwt
+	if [ -f index/${REFGENOME}.bwt ]; then
+		# prebuilt (shared) index
+		echo "[bwa] bwt (reuse index)"
+	else
+		echo "[bwa] bwt"
+		${BWAPATH}/bwa index ${REFGENOME}.fasta -p index/${REFGENOME} 2>&1 | tee ${LOGSDIR}/${DATANAME}_bwt
+	fi
 
 	echo "[bwa] aln"
 	${BWAPATH}/bwa aln ${EDITDIST} -t ${MAXPROC} "index/${REFGENOME}" "${DATANAME}.fastq" -f "${WORKDIR}/${DATANAME}_ecv_all.sai" 2>&1 | tee "${LOGSDIR}/${DATANAME}_aln"
@@ -70,76 +75,13 @@ function do_build {
 function do_extract {
 	echo "[fastq ans ans]"
 
-	LNDESC="\rextract (%s/2): %s processed"
-
-	printf "%s" ""
-	# filter out flags of 256 (not primary alignment) and 2048 (supplementary alignment)
-	# it shall equal to the whole data
-	samtools view -S -h -F 2304 "${WORKDIR}/${DATANAME}_ecv_all.sam" 2> /dev/null | \
-	grep -v "^@" | \
-	awk -v FNAME="${DATADIR}/${DATANAME}.fastq" \
-		-v RNFNAME="${DATADIR}/${DATANAME}_rn.fastq" \
-		-v RNANAME="${DATADIR}/${GSTD%_gstd}_rn_gstd.ans" \
-		-v LNDESC="${LNDESC}" \
-	'BEGIN {
-		printf(LNDESC, "1", NR)
-	}{
-		print "@"$1"\n"$10"\n+\n"$11 > FNAME
-
-		if($10 !~ /N/) {
-			print "@"$1"\n"$10"\n+\n"$11 > RNFNAME
-
-			# filter out flag of 0x4 (read unmapped)
-			if(and($2,0x4)!=0x4) {
-				# we only want the "XT:A:U" tag
-				for(i=12; i<=NF; i++) {
-					if($i == "XT:A:U") {
-						hasNoXAtag = 1
-
-						# check if this record has "XA:Z:" tag
-						for(j=NF; j>=12; j--) {
-							# we do not allow record with this tag
-							if($j ~ /(XA:Z:)/) {
-								hasNoXAtag = 0
-
-								break
-							}
-						}
-
-						if(hasNoXAtag == 1) {
-							# the gold standard shall only have CIGAR flag M
-							if($6 !~ /I|D|N|S|H|P|=|X/) {
-								# find out the answer and export it
-								for(j=12; j<=NF; j++) {
-									if($j ~ /(MD:Z:)/) {
-										print $1"\t"substr($j, 6) > RNANAME
-
-										break
-									}
-								}
-							}
-						}
-
-						break
-					}
-				}
-			}
-		}
-
-		# line count indicator
-		if(NR%100000==0) {
-			printf(LNDESC, "1", NR)
-		}
-	} END {
-		printf(LNDESC, "1", NR)
-		printf(" and %s completed", NR)
-	}'
-	printf '\n'
-
-	printf "%s" "extract (2/2):"
-
-	printf "%s" " convert"
-	bash ${UTILDIR}/FastqToSfq.sh "${DATADIR}/${DATANAME}.fastq" > "${DATADIR}/${DATANAME}.sfq"
+	# one pass over the sam: reads, reads without N, gold-standard answers with
+	# their MD statistics, and sfq (secondary and supplementary alignments are skipped)
+	${UTILDIR}/samExtract "${WORKDIR}/${DATANAME}_ecv_all.sam" -m backtrack \
+		-f "${DATADIR}/${DATANAME}.fastq" \
+		-n "${DATADIR}/${DATANAME}_rn.fastq" \
+		-a "${DATADIR}/${GSTD%_gstd}_rn_gstd.ans" -t "${LOGSDIR}/${GSTD%_gstd}_rn_gstd_ans_stats" \
+		-q "${DATADIR}/${DATANAME}.sfq" -s "${LOGSDIR}/${DATANAME}_stats"
 	printf '\n'
 }
 
@@ -281,6 +223,8 @@ function do_ids {
 
 	printf "%s" " list"
 	sort -k1 -n "${IDLSDIR}/${RAW}_0_reads.info.tmp" 2> /dev/null > "${IDLSDIR}/${RAW}_0_reads.info"
+	# one label byte per read, in read order, for the report generator
+	cut -f 2 "${IDLSDIR}/${RAW}_0_reads.info" | tr -d '\n' > "${IDLSDIR}/${RAW}_0_reads.lbl"
 	rm "${IDLSDIR}/${RAW}_0_reads.info.tmp" 2> /dev/null
 
 	printf "%s" " count"
@@ -296,10 +240,20 @@ function do_stats {
 	echo "[stats]"
 
 	printf "%-15s:\t" "${GSTD}_ans"
-	java -cp ${UTILDIR} goldstdStats "${DATADIR}/${GSTD}.ans" | tee "${LOGSDIR}/${GSTD}_ans_stats"
+	# the statistics are computed by samExtract while the sam is streamed in do_extract
+	if [ -s "${LOGSDIR}/${GSTD}_ans_stats" ] && [ "${LOGSDIR}/${GSTD}_ans_stats" -nt "${DATADIR}/${GSTD}.ans" ]; then
+		cat "${LOGSDIR}/${GSTD}_ans_stats"
+	else
+		${UTILDIR}/samExtract -A "${DATADIR}/${GSTD}.ans" -t "${LOGSDIR}/${GSTD}_ans_stats"
+	fi
 
 	for d in {${GSTD},${DATANAME}}; do
 		printf "%-15s:\t" "${d}"
+		# reuse the summary written by the native converter if it is up to date
+		if [ -s "${LOGSDIR}/${d}_stats" ] && [ "${LOGSDIR}/${d}_stats" -nt "${DATADIR}/${d}.sfq" ]; then
+			cat "${LOGSDIR}/${d}_stats"
+			continue
+		fi
 		cat "${DATADIR}/${d}.sfq" 2> /duv/null | \
 		awk \
 		'{
@@ -31,7 +31,7 @@ IDXDIR="${WORKDIR}/index"
 
 BWAPATH="${SRCDIR}/bwa"
 SAMPATH="${SRCDIR}/samtools"
-UTILDIR="${SRCDIR}/libs/map_proc/utils"
+UTILDIR="${SRCDIR}/library/map_proc/utils"
 
 function do_mkdir {
 	mkdir -p "${LOGSDIR}" &> /dev/null
@@ -55,8 +55,13 @@ function do_wipe {
 }
 
 function do_build {
-	echo "[bwa] bwt"
-	${BWAPATH}/bwa index ${REFGENOME}.fasta -p index/${REFGENOME} 2>&1 | tee ${LOGSDIR}/${DATANAME}_bwt
+	if [ -f index/${REFGENOME}.bwt ]; then
+		# prebuilt (shared) index
+		echo "[bwa] bwt (reuse index)"
+	else
+		echo "[bwa] bwt"
+		${BWAPATH}/bwa index ${REFGENOME}.fasta -p index/${REFGENOME} 2>&1 | tee ${LOGSDIR}/${DATANAME}_bwt
+	fi
 
 	echo "[bwa] mem"
 	${BWAPATH}/bwa mem ${PARASET} -t ${MAXPROC} -a index/${REFGENOME} "${DATANAME}.fastq" \
@@ -65,29 +70,12 @@ function do_build {
 
 function do_extract {
 	echo "[fastq and ans]"
-	# filter out flags of 256 (not primary alignment) and 2048 (supplementary alignment)
-	# it shall equal to the whole data
-	samtools view -S -h -F 2304 "${WORKDIR}/${DATANAME}_ecv_all.sam" 2> /dev/null | \
-	grep -v "^@" | \
-	awk -v FNAME="${DATADIR}/${DATANAME}.fastq" -v ANAME="${DATADIR}/${GSTD}.ans" '{
-		print "@"$1"\n"$10"\n+\n"$11 > FNAME
-
-		# filter out flag of 0x4 (read unmapped), and the mapping quality shall not be 0
-		if(and($2,0x4)!=0x4 && int($5)>=1) {
-			# the gold standard shall only have CIGAR flag M
-			if($6 !~ /I|D|N|S|H|P|=|X/) {
-				# find out the answer and export it
-				for(i=2; i<=NF; i++) {
-					if($i ~ /(MD:Z:)/) {
-						print $1"\t"substr($i, 6) > ANAME
-					}
-				}
-			}
-		}
-	}'
-
-	echo "[convert to sfq]"
-	bash ${UTILDIR}/FastqToSfq.sh "${DATADIR}/${DATANAME}.fastq" > "${DATADIR}/${DATANAME}.sfq"
+	# one pass over the sam: reads, gold-standard answers with their MD statistics, and sfq
+	# (secondary and supplementary alignments are skipped; it shall equal to the whole data)
+	${UTILDIR}/samExtract "${WORKDIR}/${DATANAME}_ecv_all.sam" -m mem \
+		-f "${DATADIR}/${DATANAME}.fastq" \
+		-a "${DATADIR}/${GSTD}.ans" -t "${LOGSDIR}/${GSTD}_ans_stats" \
+		-q "${DATADIR}/${DATANAME}.sfq" -s "${LOGSDIR}/${DATANAME}_stats"
 }
 
 function do_ids {
@@ -245,6 +233,8 @@ function do_ids {
 
 	printf "%s" " list"
 	sort -k1 -n "${IDLSDIR}/${RAW}_0_reads.info.tmp1" "${IDLSDIR}/${RAW}_0_reads.info.tmp2" 2> /dev/null > "${IDLSDIR}/${RAW}_0_reads.info"
+	# one label byte per read, in read order, for the report generator
+	cut -f 2 "${IDLSDIR}/${RAW}_0_reads.info" | tr -d '\n' > "${IDLSDIR}/${RAW}_0_reads.lbl"
 	rm "${IDLSDIR}/${RAW}_0_reads.info.tmp1" "${IDLSDIR}/${RAW}_0_reads.info.tmp2" 2> /dev/null
 
 	printf "%s" " count"
@@ -260,10 +250,20 @@ function do_stats {
 	echo "[stats]"
 
 	printf "%-15s:\t" "${GSTD}_ans"
-	java -cp ${UTILDIR} goldstdStats "${DATADIR}/${GSTD}.ans" | tee "${LOGSDIR}/${GSTD}_ans_stats"
+	# the statistics are computed by samExtract while the sam is streamed in do_extract
+	if [ -s "${LOGSDIR}/${GSTD}_ans_stats" ] && [ "${LOGSDIR}/${GSTD}_ans_stats" -nt "${DATADIR}/${GSTD}.ans" ]; then
+		cat "${LOGSDIR}/${GSTD}_ans_stats"
+	else
+		${UTILDIR}/samExtract -A "${DATADIR}/${GSTD}.ans" -t "${LOGSDIR}/${GSTD}_ans_stats"
+	fi
 
 	for d in {${GSTD},${DATANAME}}; do
 		printf "%-15s:\t" "${d}"
+		# reuse the summary written by the native converter if it is up to date
+		if [ -s "${LOGSDIR}/${d}_stats" ] && [ "${LOGSDIR}/${d}_stats" -nt "${DATADIR}/${d}.sfq" ]; then
+			cat "${LOGSDIR}/${d}_stats"
+			continue
+		fi
 		cat "${DATADIR}/${d}.sfq" 2> /duv/null | \
 		awk \
 		'{
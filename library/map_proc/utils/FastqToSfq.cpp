@@ -0,0 +1,310 @@
+/*
+== Convert FASTQ to tab-separated SFQ (name, seq, qual per line); update: 2026/10
+Optionally also write a columnar read store (2-bit seq, qual and name streams
+with an offset index) which later passes can memory-map instead of re-parsing text
+*/
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "lineio.h"
+
+using namespace std;
+
+#define MIN(x,y) ((x < y) ? x : y)
+#define MAX(x,y) ((x > y) ? x : y)
+
+//=============================================================================
+#define STORE_MAGIC "SQRS"
+#define STORE_VERSION 1
+
+// Layout of the columnar store <prefix>.*
+//   .idx  : StoreHeader, then one StoreRecord per read
+//   .seq  : 2-bit packed bases (A=0,C=1,G=2,T=3), 4 bases per byte, LSB first
+//   .exc  : non-ACGT bases as StoreException, sorted by position
+//   .qual : raw quality strings, concatenated (offset = base offset)
+//   .name : read names without '@', concatenated
+struct StoreHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t ReadCount;
+	uint64_t BaseCount;
+	uint64_t NameBytes;
+	uint64_t ExcCount;
+};
+
+struct StoreRecord
+{
+	uint64_t NameOff;
+	uint64_t BaseOff;
+	uint32_t NameLen;
+	uint32_t SeqLen;
+};
+
+struct StoreException
+{
+	uint64_t pos;
+	char base;
+	char pad[7];
+};
+
+//=============================================================================
+static unsigned char BaseCode[256];
+
+void InitBaseCode(void)
+{
+	memset(BaseCode, 4, sizeof(BaseCode));
+	BaseCode['A'] = BaseCode['a'] = 0;
+	BaseCode['C'] = BaseCode['c'] = 1;
+	BaseCode['G'] = BaseCode['g'] = 2;
+	BaseCode['T'] = BaseCode['t'] = 3;
+}
+
+FILE *OpenStoreFile(const char *prefix, const char *ext)
+{
+	char fname[1024];
+	sprintf(fname, "%s.%s", prefix, ext);
+	FILE *fp = fopen(fname, "wb");
+	if (fp == NULL)
+		fprintf(stderr, "Open OUT store File (%s) Error!\n", fname);
+	return fp;
+}
+
+//=============================================================================
+bool FastqToSfq(const char *in, const char *out, const char *storePrefix, const char *statsFile)
+{
+	FILE *fpin, *fpout;
+	FILE *fpidx = NULL, *fpseq = NULL, *fpexc = NULL, *fpqual = NULL, *fpname = NULL;
+	size_t ReadCount = 0, TotalLen = 0, GCcnt = 0;
+	size_t MinSeqLen = 0, MaxSeqLen = 0;
+	size_t line = 0;
+
+	fpin = (strcmp(in, "-") == 0) ? stdin : fopen(in, "rb");
+	if (fpin == NULL)
+	{
+		fprintf(stderr, "Read FQ File Error!\n");
+		return false;
+	}
+
+	fpout = (out == NULL || strcmp(out, "-") == 0) ? stdout : fopen(out, "wb");
+	if (fpout == NULL)
+	{
+		fprintf(stderr, "Open OUT SFQ File Error!\n");
+		return false;
+	}
+
+	if (storePrefix != NULL)
+	{
+		fpidx = OpenStoreFile(storePrefix, "idx");
+		fpseq = OpenStoreFile(storePrefix, "seq");
+		fpexc = OpenStoreFile(storePrefix, "exc");
+		fpqual = OpenStoreFile(storePrefix, "qual");
+		fpname = OpenStoreFile(storePrefix, "name");
+		if (!fpidx || !fpseq || !fpexc || !fpqual || !fpname)
+			return false;
+
+		// reserve the header; it is rewritten with the final counts
+		StoreHeader hdr;
+		memset(&hdr, 0, sizeof(hdr));
+		fwrite(&hdr, sizeof(hdr), 1, fpidx);
+	}
+
+	{
+		LineReader reader(fpin);
+		BlockWriter wout(fpout);
+		BlockWriter widx(fpidx), wseq(fpseq), wexc(fpexc), wqual(fpqual), wname(fpname);
+		uint64_t ExcCount = 0;
+		unsigned char packed = 0; // pending 2-bit byte
+		char *s, *seq = NULL, *name = NULL;
+		size_t len, SeqLen = 0, NameLen = 0;
+		string seqCopy, nameCopy;
+
+		while (reader.next(s, len))
+		{
+			line++;
+			switch (line % 4)
+			{
+			case 1: // title
+				if (len == 0 || s[0] != '@')
+				{
+					fprintf(stderr, "FASTQ file format error at line#%lu\n", line);
+					return false;
+				}
+				nameCopy.assign(s+1, len-1);
+				break;
+
+			case 2: // seq
+				seqCopy.assign(s, len);
+				break;
+
+			case 3: // q title
+				if (len == 0 || s[0] != '+')
+				{
+					fprintf(stderr, "FASTQ file format error at line#%lu\n", line);
+					return false;
+				}
+				break;
+
+			case 0: // qual
+				name = &nameCopy[0];
+				NameLen = nameCopy.size();
+				seq = &seqCopy[0];
+				SeqLen = seqCopy.size();
+				if (len != SeqLen)
+				{
+					fprintf(stderr, "FASTQ file format error at line#%lu: incorrect length of Q-string\n", line);
+					return false;
+				}
+
+				wout.put(name, NameLen);
+				wout.put('\t');
+				wout.put(seq, SeqLen);
+				wout.put('\t');
+				wout.put(s, len);
+				wout.put('\n');
+
+				for (size_t i=0; i<SeqLen; i++)
+					GCcnt += (seq[i] == 'G' || seq[i] == 'C');
+				MinSeqLen = (ReadCount == 0) ? SeqLen : MIN(MinSeqLen, SeqLen);
+				MaxSeqLen = MAX(MaxSeqLen, SeqLen);
+
+				if (storePrefix != NULL)
+				{
+					StoreRecord rec;
+					rec.NameOff = wname.size();
+					rec.BaseOff = TotalLen;
+					rec.NameLen = (uint32_t)NameLen;
+					rec.SeqLen = (uint32_t)SeqLen;
+					widx.put((const char *)&rec, sizeof(rec));
+					wname.put(name, NameLen);
+					wqual.put(s, len);
+
+					for (size_t i=0; i<SeqLen; i++)
+					{
+						uint64_t pos = TotalLen+i;
+						unsigned char code = BaseCode[(unsigned char)seq[i]];
+						if (code > 3)
+						{
+							StoreException exc;
+							memset(&exc, 0, sizeof(exc));
+							exc.pos = pos;
+							exc.base = seq[i];
+							wexc.put((const char *)&exc, sizeof(exc));
+							ExcCount++;
+							code = 0;
+						}
+						packed |= code << ((pos & 3) * 2);
+						if ((pos & 3) == 3)
+						{
+							wseq.put((char)packed);
+							packed = 0;
+						}
+					}
+				}
+
+				TotalLen += SeqLen;
+				ReadCount++;
+				break;
+			}
+		}
+		if (line % 4 != 0)
+		{
+			fprintf(stderr, "FASTQ file format error at line#%lu: truncated record\n", line);
+			return false;
+		}
+
+		if (storePrefix != NULL)
+		{
+			if (TotalLen & 3)
+				wseq.put((char)packed);
+
+			StoreHeader hdr;
+			memcpy(hdr.magic, STORE_MAGIC, 4);
+			hdr.version = STORE_VERSION;
+			hdr.ReadCount = ReadCount;
+			hdr.BaseCount = TotalLen;
+			hdr.NameBytes = wname.size();
+			hdr.ExcCount = ExcCount;
+			widx.flush();
+			fseek(fpidx, 0, SEEK_SET);
+			fwrite(&hdr, sizeof(hdr), 1, fpidx);
+		}
+	}
+
+	if (fpin != stdin)
+		fclose(fpin);
+	if (fpout != stdout)
+		fclose(fpout);
+	else
+		fflush(stdout);
+	if (storePrefix != NULL)
+	{
+		fclose(fpidx);
+		fclose(fpseq);
+		fclose(fpexc);
+		fclose(fpqual);
+		fclose(fpname);
+	}
+
+	// same columns as the do_stats summary of the map_proc scripts
+	if (statsFile != NULL)
+	{
+		FILE *fpstats = fopen(statsFile, "wt");
+		if (fpstats == NULL)
+		{
+			fprintf(stderr, "Open OUT stats File Error!\n");
+			return false;
+		}
+		fprintf(fpstats, "%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%.2f%%\n", ReadCount, TotalLen,
+			ReadCount ? TotalLen/ReadCount : 0, MaxSeqLen, MinSeqLen, GCcnt,
+			TotalLen ? 100.0*(double)GCcnt/(double)TotalLen : 0.0);
+		fclose(fpstats);
+	}
+
+	return true;
+}
+
+
+
+//=============================================================================
+int main(int argc, char **argv)
+{
+//=============================================================================
+	const char *storePrefix = NULL, *statsFile = NULL;
+	vector<char *> args;
+
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-c") == 0 && i+1 < argc)
+			storePrefix = argv[++i];
+		else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+			statsFile = argv[++i];
+		else
+			args.push_back(argv[i]);
+	}
+
+	if (args.size() != 1 && args.size() != 2)
+	{
+		printf("=== FastqToSfq: Convert a FASTQ file to SFQ (name<TAB>seq<TAB>qual) ===\n\n");
+		printf("Usage: FastqToSfq in.fq [out.sfq] [-c storePrefix] [-s stats]\n");
+		printf(" -in.fq/out.sfq: '-' for stdin/stdout; out.sfq defaults to stdout\n");
+		printf(" -c: Optional. Also write the columnar read store storePrefix.{idx,seq,exc,qual,name}\n");
+		printf(" -s: Optional. Write #read, #base, avg/max/min length and GC to the stats file\n");
+		printf("Verson: 1.0 (2026/10) \n\n");
+
+		return 1;
+	}
+
+	InitBaseCode();
+
+//=============================================================================
+	if (!FastqToSfq(args[0], args.size() == 2 ? args[1] : NULL, storePrefix, statsFile))
+		return 1;
+
+//=============================================================================
+	return 0;
+}
@@ -8,6 +8,12 @@ elif [ ! -e $1 ]; then
 	exit
 fi
 
+# use the native converter when it has been built (see _build.sh)
+UTILDIR="$( cd "$(dirname "$0")" ; pwd)"
+if [ -x ${UTILDIR}/FastqToSfq ]; then
+	exec ${UTILDIR}/FastqToSfq $1
+fi
+
 #while read line1; do
 #	read line2
 #	read line3
@@ -0,0 +1,14 @@
+echo "g++ -O3 FastqToSfq.cpp -o FastqToSfq"
+g++ -O3 FastqToSfq.cpp -o FastqToSfq
+
+echo "g++ -O3 samExtract.cpp -o samExtract"
+g++ -O3 samExtract.cpp -o samExtract
+
+echo "g++ -O3 labelSubset.cpp -o labelSubset"
+g++ -O3 labelSubset.cpp -o labelSubset
+
+echo "g++ -O3 samConcord.cpp -o samConcord"
+g++ -O3 samConcord.cpp -o samConcord
+
+echo "g++ -O3 -pthread fastMap.cpp -o fastMap"
+g++ -O3 -pthread fastMap.cpp -o fastMap
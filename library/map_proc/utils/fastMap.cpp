@@ -0,0 +1,631 @@
+/*
+== Quick read labels from a built-in minimizer mapper; update: 2026/10
+The assembly is indexed in memory by its minimizers (minimizer.h), the minimizers of a read
+vote for diagonals of the assembly, and the read is aligned around the best few of them by a
+banded DP with bwa-mem scores (match 1, mismatch 4, gap 6+1 per base, clip 5, min score 30),
+SSE2 over the band. The best alignments give the labels of the bwa scripts (P/S/C/O/M/F/N)
+in the same _0_reads.info and _0_reads.lbl files, for a quick triage without bwa; the
+bwa-mem and bwa-backtrack runs stay the reference for the full report.
+*/
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory> // for unique_ptr
+#include <algorithm> // for sort
+#include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "../../preQ/minimizer.h"
+#include "../../preQ/fqbatch.h"
+#include "../../preQ/wsched.h"
+#include "../../preQ/metrics.h"
+
+using namespace std;
+
+#define MIN(x,y) ((x < y) ? x : y)
+#define MAX(x,y) ((x > y) ? x : y)
+
+//=============================================================================
+#define MAP_MATCH 1
+#define MAP_MISMATCH 4
+#define MAP_GAP_OPEN 6
+#define MAP_GAP_EXT 1
+#define MAP_CLIP 5 // per clipped end
+#define MAP_MIN_SCORE 30 // bwa mem -T: lower alignments are not reported
+#define MAP_MAX_OCC 1000 // minimizers more frequent in the assembly are no seeds
+#define MAP_MAX_CAND 16 // diagonals aligned per read
+#define MAP_BAND 48 // DP cells per row, centered on the diagonal; a multiple of 8
+#define MAP_NEG (-16384) // score of cells outside the window
+
+static const char *MapLabels = "PSCOMFN";
+enum { LB_P, LB_S, LB_C, LB_O, LB_M, LB_F, LB_N, LB_SIZE };
+
+//=============================================================================
+// the contigs, concatenated, and the positions of their minimizers by hash
+struct MapIndex
+{
+	string Ref; // all contigs, upper case
+	vector<size_t> Start; // of each contig in Ref, and the end
+	vector<Minimizer> Hit; // by hash then position; Pos is in Ref
+	vector<uint64_t> Key; // open addressing: hash + 1, 0: empty slot
+	vector<uint32_t> Begin, Count; // hits of the slot
+	uint64_t Mask;
+
+	bool Load(const char *fname)
+	{
+		FILE *fp = fopen(fname, "rt");
+		if (fp == NULL)
+		{
+			printf("Open Assembly File Error!\n");
+			return false;
+		}
+		char line[65536];
+		bool lineStart = true;
+		while (fgets(line, sizeof(line), fp) != NULL)
+		{
+			size_t n = strlen(line);
+			bool header = lineStart && line[0] == '>';
+			lineStart = (n > 0 && line[n-1] == '\n');
+			if (header)
+			{
+				Start.push_back(Ref.size());
+				continue;
+			}
+			if (Start.empty())
+				continue;
+			for (size_t i=0; i<n; i++)
+				if (line[i] != '\n' && line[i] != '\r')
+					Ref.push_back((line[i] >= 'a' && line[i] <= 'z') ? line[i] - 'a' + 'A' : line[i]);
+		}
+		fclose(fp);
+		Start.push_back(Ref.size());
+		if (Start.size() < 2 || Ref.size() >= 0xFFFFFFFFULL)
+		{
+			printf("Assembly File (no contig, or 4G bases and more) Error!\n");
+			return false;
+		}
+
+		vector<Minimizer> mz;
+		for (size_t c=0; c+1<Start.size(); c++)
+		{
+			MzSketch(Ref.c_str() + Start[c], Start[c+1] - Start[c], mz);
+			for (size_t i=0; i<mz.size(); i++)
+			{
+				mz[i].Pos += (uint32_t)Start[c];
+				Hit.push_back(mz[i]);
+			}
+		}
+		sort(Hit.begin(), Hit.end(), [](const Minimizer &a, const Minimizer &b) {
+			return a.Hash < b.Hash || (a.Hash == b.Hash && a.Pos < b.Pos);
+		});
+
+		size_t slots = 1024;
+		while (slots < 2*Hit.size())
+			slots <<= 1;
+		Key.assign(slots, 0);
+		Begin.assign(slots, 0);
+		Count.assign(slots, 0);
+		Mask = slots - 1;
+		for (size_t i=0, j; i<Hit.size(); i=j)
+		{
+			for (j=i; j<Hit.size() && Hit[j].Hash == Hit[i].Hash; j++)
+				;
+			size_t s = Slot(Hit[i].Hash);
+			Key[s] = Hit[i].Hash + 1;
+			Begin[s] = (uint32_t)i;
+			Count[s] = (uint32_t)(j - i);
+		}
+		return true;
+	}
+
+	size_t Contigs() const
+	{
+		return Start.size() - 1;
+	}
+
+	// contig of a position of Ref
+	size_t ContigOf(size_t pos) const
+	{
+		return upper_bound(Start.begin(), Start.end(), pos) - Start.begin() - 1;
+	}
+
+	// hits of a minimizer hash: [*b, *b + return)
+	uint32_t Find(uint64_t hash, uint32_t *b) const
+	{
+		size_t s = Slot(hash);
+		if (Key[s] != hash + 1)
+			return 0;
+		*b = Begin[s];
+		return Count[s];
+	}
+
+private:
+	size_t Slot(uint64_t hash) const
+	{
+		size_t s = (size_t)(hash * 0x9E3779B97F4A7C15ULL >> 20) & Mask;
+		while (Key[s] != 0 && Key[s] != hash + 1)
+			s = (s + 1) & Mask;
+		return s;
+	}
+};
+
+//=============================================================================
+// a seed hit: the read (Rev: its reverse complement) starts at Diag of contig Ctg
+struct Anchor
+{
+	bool Rev;
+	uint32_t Ctg;
+	long Diag; // in Ref
+};
+
+// an alignment of the read on one strand of the assembly
+struct MapAln
+{
+	int Score;
+	bool Rev;
+	size_t End; // Ref position after the last aligned base
+	bool Clip, Gap; // clipped ends, indels
+	size_t Mis; // mismatches
+};
+
+// one worker's DP buffers and results
+struct Mapper
+{
+	const MapIndex *Idx;
+	vector<Minimizer> Mz;
+	vector<Anchor> Anchors;
+	vector< pair<size_t, size_t> > Clusters; // anchor ranges
+	vector<MapAln> Alns;
+	string Rc; // reverse complement of the read
+	vector<uint8_t> Dir; // traceback, MAP_BAND per row
+	vector<int> RowMax, RowArg; // best cell of each row
+	// results, merged by read index at the end
+	vector<size_t> Read; // index in the file
+	vector<char> Label;
+	vector<uint32_t> Count; // alignments of M reads, 1 for unique ones
+	string Names; // ids, '\t' after each
+	size_t LabelCount[LB_SIZE];
+
+	void Init(const MapIndex *idx)
+	{
+		Idx = idx;
+		memset(LabelCount, 0, sizeof(LabelCount));
+	}
+
+	// reads [begin, end) of batch b
+	void AddRange(const FqBatch &b, size_t begin, size_t end)
+	{
+		for (size_t r=begin; r<end; r++)
+		{
+			const char *name = b.Name(r);
+			size_t n = (b.NameLen[r] > 0 && name[0] == '@') ? 1 : 0, e = n;
+			while (e < b.NameLen[r] && name[e] != ' ' && name[e] != '\t')
+				e++;
+			Names.append(name + n, e - n);
+			Names.push_back('\t');
+			uint32_t cnt = 0;
+			int lb = Map(b.Seq(r), b.SeqLen[r], cnt);
+			Read.push_back((b.FirstLine - 1)/4 + r);
+			Label.push_back(MapLabels[lb]);
+			Count.push_back(cnt);
+			LabelCount[lb]++;
+		}
+	}
+
+	// label of a read, cnt as the third column of _0_reads.info
+	int Map(const char *seq, size_t len, uint32_t &cnt)
+	{
+		if (memchr(seq, 'N', len) != NULL) // as the bwa scripts: any N first
+			return LB_N;
+		Rc.resize(len);
+		for (size_t i=0; i<len; i++)
+		{
+			char c = seq[len-1-i];
+			Rc[i] = (c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : c == 'T' ? 'A' : c);
+		}
+
+		// seeds: every hit of every minimizer, on the diagonal of the read start
+		Anchors.clear();
+		MzSketch(seq, len, Mz);
+		for (size_t m=0; m<Mz.size(); m++)
+		{
+			uint32_t b = 0, n = Idx->Find(Mz[m].Hash, &b);
+			if (n > MAP_MAX_OCC)
+				continue;
+			for (uint32_t h=b; h<b+n; h++)
+			{
+				const Minimizer &x = Idx->Hit[h];
+				Anchor a;
+				a.Rev = (x.Rev != Mz[m].Rev);
+				a.Diag = (long)x.Pos - (a.Rev ? (long)(len - Mz[m].Pos + MZ_K - 2) : (long)Mz[m].Pos);
+				a.Ctg = (uint32_t)Idx->ContigOf(x.Pos);
+				Anchors.push_back(a);
+			}
+		}
+		sort(Anchors.begin(), Anchors.end(), [](const Anchor &a, const Anchor &b) {
+			return a.Rev != b.Rev ? a.Rev < b.Rev : (a.Ctg != b.Ctg ? a.Ctg < b.Ctg : a.Diag < b.Diag);
+		});
+
+		// clusters of nearby diagonals, the most seeded first
+		Clusters.clear();
+		for (size_t i=0, j; i<Anchors.size(); i=j)
+		{
+			for (j=i+1; j<Anchors.size() && Anchors[j].Rev == Anchors[i].Rev && Anchors[j].Ctg == Anchors[i].Ctg
+				&& Anchors[j].Diag - Anchors[i].Diag <= MAP_BAND/4; j++)
+				;
+			Clusters.push_back(make_pair(i, j));
+		}
+		sort(Clusters.begin(), Clusters.end(), [](const pair<size_t, size_t> &a, const pair<size_t, size_t> &b) {
+			return a.second - a.first > b.second - b.first || (a.second - a.first == b.second - b.first && a.first < b.first);
+		});
+
+		// the alignment around each, the same alignment found twice counted once
+		Alns.clear();
+		for (size_t c=0; c<Clusters.size() && c<MAP_MAX_CAND; c++)
+		{
+			const Anchor &a = Anchors[(Clusters[c].first + Clusters[c].second)/2];
+			MapAln x;
+			if (!Align(a.Rev ? Rc.c_str() : seq, len, a, x) || x.Score < MAP_MIN_SCORE)
+				continue;
+			bool dup = false;
+			for (size_t k=0; k<Alns.size() && !dup; k++)
+				dup = (Alns[k].Rev == x.Rev && Alns[k].End == x.End);
+			if (!dup)
+				Alns.push_back(x);
+		}
+		if (Alns.empty())
+			return LB_F;
+
+		// unique if the best alignment beats all others, as mapping quality >= 1 of bwa
+		size_t best = 0, ties = 0;
+		for (size_t k=1; k<Alns.size(); k++)
+			if (Alns[k].Score > Alns[best].Score)
+				best = k;
+		for (size_t k=0; k<Alns.size(); k++)
+			ties += (Alns[k].Score == Alns[best].Score);
+		if (ties > 1)
+		{
+			cnt = (uint32_t)Alns.size();
+			return LB_M;
+		}
+		cnt = 1;
+		const MapAln &x = Alns[best];
+		return x.Clip ? LB_C : (x.Gap ? LB_O : (x.Mis == 0 ? LB_P : LB_S));
+	}
+
+	// banded DP of q against its contig around the diagonal of a; false if the band misses the contig.
+	// Cell k of row i (read bases [0, i) aligned) is Ref position j-1 with j = i + Lo + k. A row
+	// starts either after the previous row or anew, at the read start for free and further in for
+	// one clip; the alignment ends at the last row, or earlier for one more clip
+	bool Align(const char *q, size_t len, const Anchor &a, MapAln &x)
+	{
+		const string &ref = Idx->Ref;
+		long cb = (long)Idx->Start[a.Ctg], ce = (long)Idx->Start[a.Ctg+1]; // the contig
+		long Lo = a.Diag - MAP_BAND/2 - cb; // j - i of cell 0, in contig coordinates
+		long n = ce - cb;
+		if (Lo + MAP_BAND <= -(long)len || Lo >= n)
+			return false;
+		const char *ctg = ref.c_str() + cb;
+
+		// padded rows: cell MAP_BAND (the cell above-right of the last) is outside the band
+		alignas(16) int16_t H[MAP_BAND+8], E[MAP_BAND+8], Hp[MAP_BAND+8], Ep[MAP_BAND+8];
+		alignas(16) char R[MAP_BAND]; // reference base of each cell, ' ' outside the contig
+		for (int k=0; k<MAP_BAND+8; k++)
+			Hp[k] = Ep[k] = MAP_NEG;
+		Dir.resize((len+1)*MAP_BAND);
+		RowMax.resize(len+1);
+		RowArg.resize(len+1);
+
+		for (size_t i=1; i<=len; i++)
+		{
+			long j0 = (long)i + Lo; // j of cell 0
+			int kmin = (int)MAX(0L, 1 - j0), kmax = (int)MIN((long)MAP_BAND-1, n - j0); // cells in the contig
+			for (int k=0; k<MAP_BAND; k++)
+				R[k] = (k >= kmin && k <= kmax) ? ctg[j0 + k - 1] : ' ';
+			uint8_t *dir = &Dir[i*MAP_BAND];
+			int16_t start = (i == 1 ? 0 : -MAP_CLIP);
+			RowKernel(q[i-1], R, Hp, Ep, start, H, E, dir);
+
+			// deletions run along the row: a scalar pass
+			int16_t F = MAP_NEG;
+			int best = MAP_NEG, arg = 0;
+			for (int k=0; k<MAP_BAND; k++)
+			{
+				if (k < kmin || k > kmax)
+				{
+					H[k] = E[k] = F = MAP_NEG;
+					continue;
+				}
+				if (k > 0)
+				{
+					int16_t fo = H[k-1] - MAP_GAP_OPEN - MAP_GAP_EXT, fe = F - MAP_GAP_EXT;
+					F = MAX(fo, fe);
+					if (fe > fo)
+						dir[k] |= 8;
+					if (F > H[k])
+					{
+						H[k] = F;
+						dir[k] = (dir[k] & ~3) | 2;
+					}
+				}
+				if (H[k] > best)
+				{
+					best = H[k];
+					arg = k;
+				}
+			}
+			RowMax[i] = best;
+			RowArg[i] = arg;
+			memcpy(Hp, H, sizeof(int16_t)*MAP_BAND);
+			memcpy(Ep, E, sizeof(int16_t)*MAP_BAND);
+		}
+
+		// end at the last row, or earlier with the end clipped
+		size_t ei = len;
+		int score = RowMax[len];
+		for (size_t i=1; i<len; i++)
+			if (RowMax[i] - MAP_CLIP > score)
+			{
+				score = RowMax[i] - MAP_CLIP;
+				ei = i;
+			}
+		if (score <= MAP_NEG/2)
+			return false;
+
+		// traceback for the mismatches, indels and the read start
+		x.Score = score;
+		x.Rev = a.Rev;
+		x.End = (size_t)(cb + (long)ei + Lo + RowArg[ei]);
+		x.Clip = (ei < len);
+		x.Gap = false;
+		x.Mis = 0;
+		long i = (long)ei, k = RowArg[ei];
+		int state = 0; // 0: H, 1: E, 2: F
+		while (i > 0)
+		{
+			uint8_t d = Dir[i*MAP_BAND + k];
+			if (state == 0)
+			{
+				int src = d & 3;
+				if (src == 1 || src == 2)
+				{
+					state = src;
+					continue;
+				}
+				x.Mis += (q[i-1] != ctg[i + Lo + k - 1]);
+				if (src == 3) // a new start
+				{
+					x.Clip |= (i > 1);
+					break;
+				}
+				i--;
+			}
+			else if (state == 1) // insertion: a read base
+			{
+				x.Gap = true;
+				state = (d & 4) ? 1 : 0;
+				i--;
+				k++;
+			}
+			else // deletion: a reference base
+			{
+				x.Gap = true;
+				state = (d & 8) ? 2 : 0;
+				k--;
+			}
+		}
+		return true;
+	}
+
+	// one DP row without the deletions: H from the diagonal, a new start or an insertion (E);
+	// dir: 0 diagonal, 1 E, 3 start, +4 if E extends the one above
+	static void RowKernel(char c, const char *R, const int16_t *Hp, const int16_t *Ep, int16_t start,
+		int16_t *H, int16_t *E, uint8_t *dir)
+	{
+		int k = 0;
+#ifdef __SSE2__
+		const __m128i zero = _mm_setzero_si128(), base = _mm_set1_epi16((short)c);
+		const __m128i ma = _mm_set1_epi16(MAP_MATCH + MAP_MISMATCH), mm = _mm_set1_epi16(MAP_MISMATCH);
+		const __m128i st = _mm_set1_epi16(start), oe = _mm_set1_epi16(MAP_GAP_OPEN + MAP_GAP_EXT), ge = _mm_set1_epi16(MAP_GAP_EXT);
+		const __m128i one = _mm_set1_epi16(1), three = _mm_set1_epi16(3), four = _mm_set1_epi16(4);
+		for (; k+8 <= MAP_BAND; k += 8)
+		{
+			__m128i r = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(R+k)), zero);
+			__m128i s = _mm_sub_epi16(_mm_and_si128(_mm_cmpeq_epi16(r, base), ma), mm);
+			__m128i d = _mm_adds_epi16(_mm_load_si128((const __m128i *)(Hp+k)), s);
+			__m128i ns = _mm_adds_epi16(st, s);
+			__m128i isStart = _mm_cmpgt_epi16(ns, d);
+			d = _mm_max_epi16(d, ns);
+			__m128i eo = _mm_subs_epi16(_mm_loadu_si128((const __m128i *)(Hp+k+1)), oe);
+			__m128i ee = _mm_subs_epi16(_mm_loadu_si128((const __m128i *)(Ep+k+1)), ge);
+			__m128i isExt = _mm_cmpgt_epi16(ee, eo);
+			__m128i e = _mm_max_epi16(eo, ee);
+			__m128i isE = _mm_cmpgt_epi16(e, d);
+			__m128i dv = _mm_or_si128(_mm_or_si128(_mm_and_si128(isE, one), _mm_andnot_si128(isE, _mm_and_si128(isStart, three))),
+				_mm_and_si128(isExt, four));
+			_mm_store_si128((__m128i *)(H+k), _mm_max_epi16(d, e));
+			_mm_store_si128((__m128i *)(E+k), e);
+			_mm_storel_epi64((__m128i *)(dir+k), _mm_packus_epi16(dv, zero));
+		}
+#endif
+		for (; k<MAP_BAND; k++)
+		{
+			int16_t s = (R[k] == c) ? MAP_MATCH : -MAP_MISMATCH;
+			int16_t d = MAX(Hp[k] + s, MAP_NEG), ns = start + s;
+			bool isStart = (ns > d);
+			d = MAX(d, ns);
+			int16_t eo = MAX(Hp[k+1] - MAP_GAP_OPEN - MAP_GAP_EXT, MAP_NEG), ee = MAX(Ep[k+1] - MAP_GAP_EXT, MAP_NEG);
+			E[k] = MAX(eo, ee);
+			bool isE = (E[k] > d);
+			H[k] = MAX(d, E[k]);
+			dir[k] = (isE ? 1 : (isStart ? 3 : 0)) | (ee > eo ? 4 : 0);
+		}
+	}
+};
+
+//=============================================================================
+bool FastMap(char *asmFile, char *readFile, char *idsPrefix, const char *outPrjName, int Threads)
+{
+	char fname[1024];
+	time_t t0 = time(NULL);
+	MapIndex idx;
+	if (!idx.Load(asmFile))
+		return false;
+	printf("Index: %lu contigs, %lu bases, %lu minimizers (k=%d, w=%d), %lds\n", idx.Contigs(), idx.Ref.size(),
+		idx.Hit.size(), MZ_K, MZ_W, (long)(time(NULL) - t0));
+
+	FqReader in;
+	if (!in.Open(readFile))
+	{
+		printf("Read FQ File Error!\n");
+		return false;
+	}
+	printf("Threads: %d\n", Threads);
+
+	// every worker maps into its own Mapper, set up on the worker's NUMA node
+	vector< unique_ptr<Mapper> > mp(Threads);
+	FqBatchPool pool(2);
+	WsScheduler *ws = NULL;
+	if (Threads > 1)
+		ws = new WsScheduler(Threads, 2, [&mp, &idx](int w) {
+			mp[w].reset(new Mapper());
+			mp[w]->Init(&idx);
+		}, [&mp](int w, const WsTask &t) {
+			mp[w]->AddRange(*t.b1, t.Begin, t.End);
+		});
+	else
+	{
+		mp[0].reset(new Mapper());
+		mp[0]->Init(&idx);
+	}
+	size_t line = 0, NumRead = 0;
+	for (;;)
+	{
+		FqBatchPool &p = ws ? ws->NextPool() : pool;
+		FqBatch *b = p.Get();
+		if (!b->Fill(in, line))
+		{
+			delete ws;
+			return false;
+		}
+		if (b->Count == 0)
+		{
+			p.Put(b);
+			break;
+		}
+		NumRead += b->Count;
+		if (ws != NULL)
+			ws->Submit(b);
+		else
+		{
+			mp[0]->AddRange(*b, 0, b->Count);
+			pool.Put(b);
+		}
+	}
+	if (ws != NULL)
+	{
+		ws->Close();
+		delete ws;
+	}
+	in.Close();
+	if (in.Err)
+	{
+		printf("Read FQ File Error!\n");
+		return false;
+	}
+
+	// labels in read order: the ids of each worker's reads, then all reads sorted by index
+	size_t LabelCount[LB_SIZE] = {0};
+	vector<const char *> Name(NumRead, NULL);
+	vector<char> Label(NumRead, 0);
+	vector<uint32_t> Count(NumRead, 0);
+	for (int w=0; w<Threads; w++)
+	{
+		Mapper &m = *mp[w];
+		const char *s = m.Names.c_str();
+		for (size_t i=0; i<m.Read.size(); i++)
+		{
+			Name[m.Read[i]] = s;
+			Label[m.Read[i]] = m.Label[i];
+			Count[m.Read[i]] = m.Count[i];
+			s = strchr(s, '\t') + 1;
+		}
+		for (int l=0; l<LB_SIZE; l++)
+			LabelCount[l] += m.LabelCount[l];
+	}
+
+	sprintf(fname, "%s_0_reads.info", idsPrefix);
+	FILE *fpinfo = fopen(fname, "wt");
+	sprintf(fname, "%s_0_reads.lbl", idsPrefix);
+	FILE *fplbl = fopen(fname, "wb");
+	if (fpinfo == NULL || fplbl == NULL)
+	{
+		printf("Open OUT Label File Error!\n");
+		return false;
+	}
+	for (size_t r=0; r<NumRead; r++)
+	{
+		fwrite(Name[r], 1, strchr(Name[r], '\t') - Name[r], fpinfo);
+		fprintf(fpinfo, "\t%c\t%u\n", Label[r], Count[r]);
+	}
+	fwrite(&Label[0], 1, NumRead, fplbl);
+	fclose(fpinfo);
+	fclose(fplbl);
+
+	printf("Mapped %lu reads in %lds\n", NumRead, (long)(time(NULL) - t0));
+	const char *base = strrchr(readFile, '/');
+	Metrics met("fastMap", base ? base+1 : readFile);
+	met.AddInt("fastmap_reads", NumRead);
+	for (int l=0; l<LB_SIZE; l++)
+	{
+		printf("%c: %lu (%.2f%%)\n", MapLabels[l], LabelCount[l], NumRead ? 100.0*LabelCount[l]/NumRead : 0.0);
+		sprintf(fname, "fastmap_%c_pct", MapLabels[l] - 'A' + 'a');
+		met.AddPct(fname, (double)LabelCount[l], (double)NumRead);
+	}
+	if (outPrjName != NULL && !met.Write(outPrjName))
+		return false;
+	printf("OutFile: %s_0_reads.info,%s_0_reads.lbl\n", idsPrefix, idsPrefix);
+	return true;
+}
+
+//=============================================================================
+int main(int argc, char **argv)
+{
+//=============================================================================
+	int Threads = (int)thread::hardware_concurrency();
+	const char *outPrjName = NULL;
+	bool ArgOK = (argc >= 4);
+	for (int i=4; ArgOK && i < argc; i++)
+	{
+		if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			Threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-m") == 0 && i+1 < argc)
+			outPrjName = argv[++i];
+		else
+			ArgOK = false;
+	}
+	if (!ArgOK)
+	{
+		printf("=== fastMap: Label reads as the bwa scripts do (P/S/C/O/M/F/N) with a built-in minimizer mapper ===\n\n");
+		printf("Usage: fastMap scaffolds.fasta in.fq idsPrefix [-t threads] [-m outPrjName]\n");
+		printf(" -idsPrefix: Writes idsPrefix_0_reads.info (<id>\\t<label>\\t<count> per read) and idsPrefix_0_reads.lbl\n");
+		printf(" -t: Optional. Number of threads, default all cores\n");
+		printf(" -m: Optional. Also write the label percentages to outPrjName.metrics.json, outPrjName.metrics.tsv\n");
+		printf(" A quick estimate for triage; the full report needs the bwa alignments\n");
+		printf("Verson: 1.0 (2026/10) \n\n");
+
+		return 1;
+	}
+
+//=============================================================================
+	if (!FastMap(argv[1], argv[2], argv[3], outPrjName, MAX(1, Threads)))
+		return 1;
+
+//=============================================================================
+	return 0;
+}
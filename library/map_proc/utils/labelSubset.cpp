@@ -0,0 +1,255 @@
+/*
+== Extract the reads of given labels from a renamed FASTQ in one pass; update: 2026/10
+Records are located through the byte-offset index (<seq>.fqi, one offset per
+record) written by the sampler, and copied with copy_file_range (pread/write
+fallback); consecutive selected records are copied as one range
+*/
+//=============================================================================
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define MIN(x,y) ((x < y) ? x : y)
+#define MAX(x,y) ((x > y) ? x : y)
+
+//=============================================================================
+#define LINE_BUF_SIZE 10000
+#define COPY_BUF_SIZE (8<<20) // 8MB pread/write blocks
+
+struct SubsetOut
+{
+	string labels; // e.g. "PSCO"
+	string fname;
+	int fd;
+	uint64_t RunBeg, RunEnd; // pending byte range of the input
+	uint64_t count;
+};
+
+static vector<char> CopyBuf;
+static bool UseCopyRange = true;
+
+//=============================================================================
+bool CopyRange(int in, int out, uint64_t beg, uint64_t end)
+{
+	while (beg < end)
+	{
+		ssize_t n = -1;
+		if (UseCopyRange)
+		{
+			loff_t off = beg;
+			n = copy_file_range(in, &off, out, NULL, end-beg, 0);
+			if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP))
+			{
+				UseCopyRange = false;
+				continue;
+			}
+		}
+		else
+		{
+			if (CopyBuf.empty())
+				CopyBuf.resize(COPY_BUF_SIZE);
+			n = pread(in, &CopyBuf[0], MIN(end-beg, (uint64_t)CopyBuf.size()), beg);
+			if (n > 0 && write(out, &CopyBuf[0], n) != n)
+				n = -1;
+		}
+		if (n <= 0)
+		{
+			printf("Copy Records Error!\n");
+			return false;
+		}
+		beg += n;
+	}
+	return true;
+}
+
+// Queue one record; adjacent records of the same output are merged into one range
+bool AddRecord(int in, SubsetOut &o, uint64_t beg, uint64_t end)
+{
+	o.count++;
+	if (o.RunEnd == beg && o.RunEnd > o.RunBeg)
+	{
+		o.RunEnd = end;
+		return true;
+	}
+	if (o.RunEnd > o.RunBeg && !CopyRange(in, o.fd, o.RunBeg, o.RunEnd))
+		return false;
+	o.RunBeg = beg;
+	o.RunEnd = end;
+	return true;
+}
+
+//=============================================================================
+// Offsets of the records: from the index when given, otherwise by scanning the FASTQ
+bool LoadOffsets(const char *fq, const char *fqi, vector<uint64_t> &offsets)
+{
+	char buf[LINE_BUF_SIZE];
+	FILE *fp;
+
+	if (fqi != NULL && (fp = fopen(fqi, "rt")) != NULL)
+	{
+		while (fgets(buf, LINE_BUF_SIZE, fp) != NULL)
+			offsets.push_back(strtoull(buf, NULL, 10));
+		fclose(fp);
+		return true;
+	}
+
+	if ((fp = fopen(fq, "rb")) == NULL)
+	{
+		printf("Read FQ File Error!\n");
+		return false;
+	}
+	uint64_t off = 0, line = 0;
+	bool bol = true;
+	while (fgets(buf, LINE_BUF_SIZE, fp) != NULL)
+	{
+		size_t len = strlen(buf);
+		if (bol && line++ % 4 == 0)
+			offsets.push_back(off);
+		bol = (len > 0 && buf[len-1] == '\n');
+		off += len;
+	}
+	fclose(fp);
+	return true;
+}
+
+//=============================================================================
+bool LabelSubset(const char *fq, const char *fqi, const char *info, vector<SubsetOut> &outs)
+{
+	vector<uint64_t> offsets;
+	char buf[LINE_BUF_SIZE];
+
+	if (!LoadOffsets(fq, fqi, offsets))
+		return false;
+
+	int in = open(fq, O_RDONLY);
+	if (in < 0)
+	{
+		printf("Read FQ File Error!\n");
+		return false;
+	}
+	struct stat st;
+	fstat(in, &st);
+	offsets.push_back(st.st_size);
+	uint64_t ReadCount = offsets.size() - 1;
+
+	FILE *fpinfo = fopen(info, "rt");
+	if (fpinfo == NULL)
+	{
+		printf("Read Label Info File Error!\n");
+		return false;
+	}
+
+	// output lookup per label character
+	vector<int> LabelOuts[256];
+	for (size_t i=0; i<outs.size(); i++)
+	{
+		outs[i].fd = open(outs[i].fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (outs[i].fd < 0)
+		{
+			printf("Open OUT FQ File (%s) Error!\n", outs[i].fname.c_str());
+			return false;
+		}
+		outs[i].RunBeg = outs[i].RunEnd = outs[i].count = 0;
+		for (size_t j=0; j<outs[i].labels.size(); j++)
+			LabelOuts[(unsigned char)outs[i].labels[j]].push_back(i);
+	}
+
+	// <id>\t<label>\t<count>, ids are the record numbers of the renamed FASTQ
+	uint64_t line = 0;
+	while (fgets(buf, LINE_BUF_SIZE, fpinfo) != NULL)
+	{
+		char *tab = strchr(buf, '\t');
+		line++;
+		if (tab == NULL)
+			continue;
+		char *endp;
+		uint64_t id = strtoull(buf[0] == '@' ? buf+1 : buf, &endp, 10);
+		if (endp != tab)
+			id = line-1;
+		if (id >= ReadCount)
+		{
+			printf("Label Info File error at line#%lu: read %lu is not in the FASTQ\n", line, id);
+			return false;
+		}
+		vector<int> &sel = LabelOuts[(unsigned char)tab[1]];
+		for (size_t i=0; i<sel.size(); i++)
+		{
+			if (!AddRecord(in, outs[sel[i]], offsets[id], offsets[id+1]))
+				return false;
+		}
+	}
+	fclose(fpinfo);
+
+	for (size_t i=0; i<outs.size(); i++)
+	{
+		if (outs[i].RunEnd > outs[i].RunBeg && !CopyRange(in, outs[i].fd, outs[i].RunBeg, outs[i].RunEnd))
+			return false;
+		close(outs[i].fd);
+		printf("%s\t%lu\t%s\n", outs[i].labels.c_str(), outs[i].count, outs[i].fname.c_str());
+	}
+	close(in);
+
+	return true;
+}
+
+
+
+//=============================================================================
+int main(int argc, char **argv)
+{
+//=============================================================================
+	const char *fqi = NULL;
+	vector<SubsetOut> outs;
+	vector<char *> args;
+
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-x") == 0 && i+1 < argc)
+			fqi = argv[++i];
+		else if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+		{
+			char *eq = strchr(argv[++i], '=');
+			if (eq == NULL || eq == argv[i])
+			{
+				printf("Incorrect output spec: %s\n", argv[i]);
+				return 1;
+			}
+			SubsetOut o;
+			o.labels.assign(argv[i], eq-argv[i]);
+			o.fname = eq+1;
+			outs.push_back(o);
+		}
+		else
+			args.push_back(argv[i]);
+	}
+
+	if (args.size() != 2 || outs.empty())
+	{
+		printf("=== labelSubset: Extract the reads of given labels from a renamed FASTQ ===\n\n");
+		printf("Usage: labelSubset in.fq reads.info [-x in.fqi] -o LABELS=out.fq [-o LABELS=out.fq ...]\n");
+		printf(" -reads.info: <id>\\t<label>\\t<count> per read (the _0_reads.info of an aligner)\n");
+		printf(" -x: Optional. Record byte-offset index of in.fq; scans in.fq if not given\n");
+		printf(" -o: Reads labeled with any of LABELS (e.g. PSCO) go to out.fq\n");
+		printf(" Prints <labels>\\t<#reads>\\t<out.fq> per output\n");
+		printf("Verson: 1.0 (2026/10) \n\n");
+
+		return 1;
+	}
+
+//=============================================================================
+	if (!LabelSubset(args[0], fqi, args[1], outs))
+		return 1;
+
+//=============================================================================
+	return 0;
+}
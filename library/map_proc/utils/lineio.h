@@ -0,0 +1,122 @@
+/*
+== Buffered line reading and block writing of text files; update: 2026/10
+LineReader hands out the lines of a FILE in place from 8MB blocks; BlockWriter collects
+small writes into 8MB blocks. Shared by FastqToSfq, samExtract and samConcord.
+*/
+//=============================================================================
+#ifndef SQUAT_LINEIO_H
+#define SQUAT_LINEIO_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#define IO_BUF_SIZE (8<<20) // 8MB read/write blocks
+
+//=============================================================================
+// Buffered block reader returning one line at a time (without '\n')
+class LineReader
+{
+public:
+	LineReader(FILE *fp) : fp(fp), buf(IO_BUF_SIZE), beg(0), end(0), eof(false) {}
+
+	bool next(char *&s, size_t &len)
+	{
+		for (;;)
+		{
+			char *p = (char *)memchr(&buf[beg], '\n', end-beg);
+			if (p != NULL)
+			{
+				s = &buf[beg];
+				len = p - s;
+				beg += len+1;
+				if (len > 0 && s[len-1] == '\r')
+					len--;
+				return true;
+			}
+			if (eof)
+			{
+				if (beg == end)
+					return false;
+				// last line without '\n'
+				s = &buf[beg];
+				len = end-beg;
+				beg = end;
+				return true;
+			}
+			// move the partial line to the front and refill
+			if (beg > 0)
+			{
+				memmove(&buf[0], &buf[beg], end-beg);
+				end -= beg;
+				beg = 0;
+			}
+			if (end == buf.size())
+				buf.resize(buf.size()*2);
+			size_t n = fread(&buf[end], 1, buf.size()-end, fp);
+			if (n == 0)
+				eof = true;
+			end += n;
+		}
+	}
+
+private:
+	FILE *fp;
+	std::vector<char> buf;
+	size_t beg, end;
+	bool eof;
+};
+
+//=============================================================================
+// Buffered block writer; a NULL file swallows everything and has no buffer
+class BlockWriter
+{
+public:
+	BlockWriter(FILE *fp) : fp(fp), buf(fp ? IO_BUF_SIZE : 0), len(0), written(0) {}
+	~BlockWriter() { flush(); }
+
+	void put(const char *s, size_t n)
+	{
+		if (fp == NULL)
+			return;
+		if (n > buf.size()-len)
+		{
+			flush();
+			if (n >= buf.size())
+			{
+				fwrite(s, 1, n, fp);
+				written += n;
+				return;
+			}
+		}
+		memcpy(buf.data()+len, s, n);
+		len += n;
+	}
+	void put(const char *s) { put(s, strlen(s)); }
+	void put(char c)
+	{
+		if (fp == NULL)
+			return;
+		if (len == buf.size())
+			flush();
+		buf[len++] = c;
+	}
+	void flush()
+	{
+		if (fp != NULL && len > 0)
+			fwrite(buf.data(), 1, len, fp);
+		written += len;
+		len = 0;
+	}
+	// bytes put so far
+	uint64_t size() { return written+len; }
+
+private:
+	FILE *fp;
+	std::vector<char> buf;
+	size_t len;
+	uint64_t written;
+};
+
+#endif
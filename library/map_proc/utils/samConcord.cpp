@@ -0,0 +1,431 @@
+/*
+== Label concordance of bwa-mem and bwa-backtrack from one joint pass over both SAM files; update: 2026/10
+Both SAM files are in the read order of the renamed FASTQ (integer ids), so they
+are merged group by group; each read gets the P/S/C/O/M/F/N label of the
+do_ids rules of bwa_mem_v1.sh / bwa_backtrack_v4.sh
+*/
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "lineio.h"
+
+using namespace std;
+
+#define MIN(x,y) ((x < y) ? x : y)
+#define MAX(x,y) ((x > y) ? x : y)
+
+//=============================================================================
+#define SAM_MIN_FIELD 11
+#define FLAG_UNMAP 0x4
+#define FLAG_SECONDARY 0x100
+#define FLAG_SUPPLEMENTARY 0x800
+
+#define LABELS "PSCOMFN"
+#define LABEL_NUM 7
+#define NO_LABEL LABEL_NUM // read without label or missing in one file
+
+enum { MODE_MEM, MODE_BACKTRACK };
+
+//=============================================================================
+struct Field
+{
+	const char *s;
+	size_t len;
+
+	bool equals(const char *t) const { return len == strlen(t) && memcmp(s, t, len) == 0; }
+	bool startsWith(const char *t) const { size_t n = strlen(t); return len >= n && memcmp(s, t, n) == 0; }
+};
+
+// Split a SAM line by tabs
+size_t SplitFields(char *s, size_t len, vector<Field> &fields)
+{
+	fields.clear();
+	const char *p = s, *end = s+len;
+	while (p <= end)
+	{
+		const char *q = (const char *)memchr(p, '\t', end-p);
+		if (q == NULL)
+			q = end;
+		Field f = { p, (size_t)(q-p) };
+		fields.push_back(f);
+		p = q+1;
+	}
+	return fields.size();
+}
+
+bool HasChar(const Field &f, char c)
+{
+	return memchr(f.s, c, f.len) != NULL;
+}
+
+bool HasAnyChar(const Field &f, const char *set)
+{
+	for (size_t i=0; i<f.len; i++)
+		if (strchr(set, f.s[i]) != NULL)
+			return true;
+	return false;
+}
+
+long FieldInt(const Field &f, size_t skip)
+{
+	string v(f.s+skip, f.len-skip);
+	return atol(v.c_str());
+}
+
+//=============================================================================
+// Label of one read, built record by record as the do_ids awk rules see them
+struct ReadLabel
+{
+	long id;
+	int label; // first label given to the read, NO_LABEL if none
+	bool skip; // the remaining records of a read having Ns are ignored
+	long SumMapQ, MappedCnt; // bwa-mem: multiply mapped reads have a sum of mapQ 0
+
+	void reset(long rid) { id = rid; label = NO_LABEL; skip = false; SumMapQ = MappedCnt = 0; }
+	void set(char c)
+	{
+		if (label == NO_LABEL)
+			label = strchr(LABELS, c) - LABELS;
+	}
+};
+
+// P/S by the first NM tag of a M-only record, C for clips, O otherwise
+void LabelUnique(ReadLabel &rl, const vector<Field> &f)
+{
+	if (!HasAnyChar(f[5], "IDNSHP=X"))
+	{
+		for (size_t i=SAM_MIN_FIELD; i<f.size(); i++)
+		{
+			if (f[i].startsWith("NM:i:"))
+			{
+				rl.set(FieldInt(f[i], 5) == 0 ? 'P' : 'S');
+				break;
+			}
+		}
+	}
+	else if (HasAnyChar(f[5], "SH"))
+		rl.set('C');
+	else
+		rl.set('O');
+}
+
+void LabelRecordMem(ReadLabel &rl, const vector<Field> &f)
+{
+	if (rl.skip)
+		return;
+	// reads containing Ns are labeled from the FASTQ
+	if (HasChar(f[9], 'N'))
+	{
+		rl.set('N');
+		rl.skip = true;
+		return;
+	}
+
+	int flag = atoi(f[1].s);
+	long mapQ = FieldInt(f[4], 0);
+	if (flag & FLAG_UNMAP)
+		rl.set('F');
+	else
+	{
+		if (!(flag & (FLAG_SECONDARY|FLAG_SUPPLEMENTARY)) && mapQ >= 1)
+			LabelUnique(rl, f);
+		rl.SumMapQ += mapQ;
+		rl.MappedCnt++;
+	}
+}
+
+void LabelRecordBacktrack(ReadLabel &rl, const vector<Field> &f)
+{
+	if (rl.skip)
+		return;
+	if (HasChar(f[9], 'N'))
+	{
+		rl.set('N');
+		rl.skip = true;
+		return;
+	}
+
+	int flag = atoi(f[1].s);
+	if (flag & FLAG_UNMAP)
+		rl.set('F');
+	else if (!(flag & (FLAG_SECONDARY|FLAG_SUPPLEMENTARY)) && f.size() > SAM_MIN_FIELD)
+	{
+		// only the first optional field (XT) decides
+		const Field &xt = f[SAM_MIN_FIELD];
+		if (xt.equals("XT:A:R"))
+		{
+			for (size_t i=SAM_MIN_FIELD; i<f.size(); i++)
+			{
+				if (f[i].startsWith("X0:i:"))
+				{
+					rl.set('M');
+					break;
+				}
+			}
+		}
+		else if (xt.equals("XT:A:U"))
+			LabelUnique(rl, f);
+		else
+			rl.set('O');
+	}
+}
+
+void FinishMem(ReadLabel &rl)
+{
+	if (!rl.skip && rl.MappedCnt > 0 && rl.SumMapQ == 0)
+		rl.set('M');
+}
+
+//=============================================================================
+// Streams one SAM file a read (group of records with the same id) at a time
+class SamReads
+{
+public:
+	SamReads(FILE *fp, int mode) : reader(fp), mode(mode), pending(false), done(false), line(0) {}
+
+	// false at the end of the file or on a format error (see error)
+	bool next(ReadLabel &out)
+	{
+		char *s;
+		size_t len;
+
+		if (done)
+			return false;
+		while (reader.next(s, len))
+		{
+			line++;
+			if (len == 0 || s[0] == '@')
+				continue;
+			if (SplitFields(s, len, f) < SAM_MIN_FIELD)
+			{
+				fprintf(stderr, "SAM file format error at line#%lu\n", line);
+				error = true;
+				done = true;
+				return false;
+			}
+			char *endp;
+			long id = strtol(f[0].s, &endp, 10);
+			if (endp != f[0].s+f[0].len)
+			{
+				fprintf(stderr, "SAM file error at line#%lu: read ids shall be the integers of change_id\n", line);
+				error = true;
+				done = true;
+				return false;
+			}
+
+			bool finished = pending && id != cur.id;
+			if (finished)
+			{
+				finish();
+				out = cur;
+			}
+			if (!pending || finished)
+			{
+				cur.reset(id);
+				pending = true;
+			}
+			if (mode == MODE_MEM)
+				LabelRecordMem(cur, f);
+			else
+				LabelRecordBacktrack(cur, f);
+			if (finished)
+				return true;
+		}
+		done = true;
+		if (!pending)
+			return false;
+		finish();
+		out = cur;
+		pending = false;
+		return true;
+	}
+
+	static bool error;
+
+private:
+	void finish()
+	{
+		if (mode == MODE_MEM)
+			FinishMem(cur);
+	}
+
+	LineReader reader;
+	int mode;
+	vector<Field> f;
+	ReadLabel cur;
+	bool pending, done;
+	size_t line;
+};
+
+bool SamReads::error = false;
+
+//=============================================================================
+bool SamConcord(const char *sam1, int mode1, const char *sam2, int mode2, const char *prefix, bool listAll)
+{
+	FILE *fp1 = fopen(sam1, "rt"), *fp2 = fopen(sam2, "rt");
+	if (fp1 == NULL || fp2 == NULL)
+	{
+		fprintf(stderr, "Read SAM File Error!\n");
+		return false;
+	}
+
+	// counts and lazily opened read lists per (label1, label2), NO_LABEL included
+	size_t matrix[LABEL_NUM+1][LABEL_NUM+1];
+	FILE *lists[LABEL_NUM+1][LABEL_NUM+1];
+	memset(matrix, 0, sizeof(matrix));
+	memset(lists, 0, sizeof(lists));
+	const char *names = LABELS "-";
+
+	{
+		SamReads reads1(fp1, mode1), reads2(fp2, mode2);
+		ReadLabel r1, r2;
+		bool has1 = reads1.next(r1), has2 = reads2.next(r2);
+		size_t ReadCount = 0;
+
+		while (has1 || has2)
+		{
+			long id = 0;
+			int l1 = NO_LABEL, l2 = NO_LABEL;
+			if (has1 && (!has2 || r1.id <= r2.id))
+			{
+				id = r1.id;
+				l1 = r1.label;
+			}
+			if (has2 && (!has1 || r2.id <= r1.id))
+			{
+				id = r2.id;
+				l2 = r2.label;
+			}
+			if (has1 && r1.id == id)
+				has1 = reads1.next(r1);
+			if (has2 && r2.id == id)
+				has2 = reads2.next(r2);
+
+			matrix[l1][l2]++;
+			if (prefix != NULL && (listAll || l1 != l2))
+			{
+				if (lists[l1][l2] == NULL)
+				{
+					char fname[1024];
+					sprintf(fname, "%s_%c%c.ids", prefix, names[l1], names[l2]);
+					lists[l1][l2] = fopen(fname, "wt");
+					if (lists[l1][l2] == NULL)
+					{
+						fprintf(stderr, "Open OUT ids File (%s) Error!\n", fname);
+						return false;
+					}
+				}
+				fprintf(lists[l1][l2], "%ld\n", id);
+			}
+
+			// line count indicator
+			if (++ReadCount % 1000000 == 0)
+			{
+				fprintf(stderr, "\rconcordance: %lu reads processed", ReadCount);
+				fflush(stderr);
+			}
+		}
+	}
+	fclose(fp1);
+	fclose(fp2);
+	for (int i=0; i<=LABEL_NUM; i++)
+		for (int j=0; j<=LABEL_NUM; j++)
+			if (lists[i][j] != NULL)
+				fclose(lists[i][j]);
+	if (SamReads::error)
+		return false;
+
+	// rows: labels of the first SAM, columns: labels of the second; '-' = no label / missing
+	FILE *fpout = stdout;
+	if (prefix != NULL)
+	{
+		char fname[1024];
+		sprintf(fname, "%s.tsv", prefix);
+		fpout = fopen(fname, "wt");
+		if (fpout == NULL)
+		{
+			fprintf(stderr, "Open OUT matrix File (%s) Error!\n", fname);
+			return false;
+		}
+	}
+	size_t agree = 0, total = 0;
+	for (int j=0; j<=LABEL_NUM; j++)
+		fprintf(fpout, "\t%c", names[j]);
+	fprintf(fpout, "\n");
+	for (int i=0; i<=LABEL_NUM; i++)
+	{
+		fprintf(fpout, "%c", names[i]);
+		for (int j=0; j<=LABEL_NUM; j++)
+		{
+			fprintf(fpout, "\t%lu", matrix[i][j]);
+			total += matrix[i][j];
+			if (i == j && i != NO_LABEL)
+				agree += matrix[i][j];
+		}
+		fprintf(fpout, "\n");
+	}
+	if (fpout != stdout)
+		fclose(fpout);
+
+	printf("%lu reads, %lu (%.2f%%) with the same label\n", total, agree, total ? 100.0*agree/total : 0.0);
+
+	return true;
+}
+
+int ParseMode(const char *s)
+{
+	if (strcmp(s, "mem") == 0)
+		return MODE_MEM;
+	if (strcmp(s, "backtrack") == 0)
+		return MODE_BACKTRACK;
+	return -1;
+}
+
+
+
+//=============================================================================
+int main(int argc, char **argv)
+{
+//=============================================================================
+	const char *prefix = NULL;
+	int mode1 = MODE_MEM, mode2 = MODE_BACKTRACK;
+	bool listAll = false, ok = true;
+	vector<char *> args;
+
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+			prefix = argv[++i];
+		else if (strcmp(argv[i], "-1") == 0 && i+1 < argc)
+			ok = ok && (mode1 = ParseMode(argv[++i])) >= 0;
+		else if (strcmp(argv[i], "-2") == 0 && i+1 < argc)
+			ok = ok && (mode2 = ParseMode(argv[++i])) >= 0;
+		else if (strcmp(argv[i], "-a") == 0)
+			listAll = true;
+		else
+			args.push_back(argv[i]);
+	}
+
+	if (!ok || args.size() != 2)
+	{
+		printf("=== samConcord: P/S/C/O/M/F/N label concordance of two aligners ===\n\n");
+		printf("Usage: samConcord first.sam second.sam [-1 mem|backtrack] [-2 mem|backtrack] [-o prefix] [-a]\n");
+		printf(" -1/-2: Labeling rule of the first/second SAM file (default mem/backtrack)\n");
+		printf(" -o: Write the matrix to prefix.tsv and the ids of each cell to prefix_<label1><label2>.ids;\n");
+		printf("     the matrix goes to stdout otherwise. '-' stands for reads without a label\n");
+		printf(" -a: Also list the reads of the diagonal (same label), only disagreements by default\n");
+		printf("Verson: 1.0 (2026/10) \n\n");
+
+		return 1;
+	}
+
+//=============================================================================
+	if (!SamConcord(args[0], mode1, args[1], mode2, prefix, listAll))
+		return 1;
+
+//=============================================================================
+	return 0;
+}
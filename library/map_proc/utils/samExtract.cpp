@@ -0,0 +1,502 @@
+/*
+== Stream a bwa SAM file once and extract reads, gold-standard answers and MD-tag statistics; update: 2026/10
+Replaces the samtools|awk extraction of do_extract and the goldstdStats (java) pass of do_stats
+*/
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <time.h>
+#include "lineio.h"
+
+using namespace std;
+
+#define MIN(x,y) ((x < y) ? x : y)
+#define MAX(x,y) ((x > y) ? x : y)
+
+//=============================================================================
+#define SAM_MIN_FIELD 11
+#define FLAG_UNMAP 0x4
+#define FLAG_SECONDARY 0x100
+#define FLAG_SUPPLEMENTARY 0x800
+
+enum { MODE_MEM, MODE_BACKTRACK };
+
+//=============================================================================
+struct Field
+{
+	const char *s;
+	size_t len;
+
+	bool equals(const char *t) const { return len == strlen(t) && memcmp(s, t, len) == 0; }
+	bool startsWith(const char *t) const { size_t n = strlen(t); return len >= n && memcmp(s, t, n) == 0; }
+};
+
+// Split a SAM line by tabs
+size_t SplitFields(char *s, size_t len, vector<Field> &fields)
+{
+	fields.clear();
+	const char *p = s, *end = s+len;
+	while (p <= end)
+	{
+		const char *q = (const char *)memchr(p, '\t', end-p);
+		if (q == NULL)
+			q = end;
+		Field f = { p, (size_t)(q-p) };
+		fields.push_back(f);
+		p = q+1;
+	}
+	return fields.size();
+}
+
+bool HasChar(const Field &f, char c)
+{
+	return memchr(f.s, c, f.len) != NULL;
+}
+
+// the gold standard shall only have CIGAR flag M
+bool IsMatchOnlyCigar(const Field &cigar)
+{
+	for (size_t i=0; i<cigar.len; i++)
+		if (strchr("IDNSHP=X", cigar.s[i]) != NULL)
+			return false;
+	return true;
+}
+
+//=============================================================================
+// MD-tag statistics of one read: length, #errors, max cont. #errors
+struct MDStat
+{
+	long len;
+	long err;
+	long maxcont;
+};
+
+MDStat ParseMD(const char *md, size_t n)
+{
+	MDStat rst = { 0, 0, 0 };
+	long dist = 0, cont = 0;
+
+	for (size_t i=0; i < n; i++)
+	{
+		char c = md[i];
+		if (c >= '0' && c <= '9')
+		{
+			dist = dist*10 + (c-'0');
+			continue;
+		}
+
+		// the symbol itself
+		rst.len += dist+1;
+		rst.err++;
+
+		// a mismatch right after another one (distance 0) extends the run
+		if (dist == 0)
+			cont++;
+		else
+		{
+			rst.maxcont = MAX(rst.maxcont, cont);
+			cont = 1;
+		}
+		dist = 0;
+	}
+	rst.len += dist;
+	rst.maxcont = MAX(rst.maxcont, cont);
+
+	return rst;
+}
+
+// Accumulates the goldstdStats summary and writes the per-read .report
+class GoldStdStats
+{
+public:
+	GoldStdStats() : fprep(NULL), rep(NULL), TotalBases(0), TotalError(0), ReadNoError(0), ReadHasError(0),
+		ErrorMin(0), ErrorMax(0), ContErrorMax(0) {}
+	~GoldStdStats() { close(); }
+
+	bool open(const char *ansFile)
+	{
+		char fname[1024];
+		sprintf(fname, "%s.report", ansFile);
+		fprep = fopen(fname, "wt");
+		if (fprep == NULL)
+		{
+			fprintf(stderr, "Open OUT report File (%s) Error!\n", fname);
+			return false;
+		}
+		rep = new BlockWriter(fprep);
+
+		char tbuf[64];
+		time_t rawtime = time(NULL);
+		strftime(tbuf, sizeof(tbuf), "%Y-%m-%d %H:%M", localtime(&rawtime));
+		fprintf(fprep, "Statistic of %s on %s\n\n", ansFile, tbuf);
+		return true;
+	}
+
+	void add(const Field &name, const Field &md)
+	{
+		MDStat rst = ParseMD(md.s, md.len);
+		size_t reads = ReadNoError+ReadHasError;
+
+		TotalBases += rst.len;
+		TotalError += rst.err;
+		if (rst.err == 0)
+			ReadNoError++;
+		else
+			ReadHasError++;
+
+		ErrorMin = (reads == 0) ? rst.err : MIN(ErrorMin, rst.err);
+		ErrorMax = (reads == 0) ? rst.err : MAX(ErrorMax, rst.err);
+		ContErrorMax = MAX(ContErrorMax, rst.maxcont);
+
+		if (rep != NULL)
+		{
+			// the name right-aligned in 10 columns as by %10s, written as is: QNAMEs go up to 254 chars
+			char tmps[128];
+			for (size_t i=name.len; i<10; i++)
+				rep->put(' ');
+			rep->put(name.s, name.len);
+			int n = snprintf(tmps, sizeof(tmps), "\t%4ld\t%4ld\t%4ld\t", rst.len, rst.err, rst.maxcont);
+			rep->put(tmps, n);
+			rep->put(md.s, md.len);
+			rep->put('\n');
+		}
+	}
+
+	// total bases, total errors, #reads w/o errors, #reads w/ errors, min/max errors, max cont. errors
+	void summary(FILE *fp)
+	{
+		fprintf(fp, "%ld\t%ld\t%lu\t%lu\t%ld\t%ld\t%ld\n", TotalBases, TotalError,
+			ReadNoError, ReadHasError, ErrorMin, ErrorMax, ContErrorMax);
+	}
+
+	void close()
+	{
+		if (rep != NULL)
+		{
+			delete rep;
+			rep = NULL;
+		}
+		if (fprep != NULL)
+		{
+			fclose(fprep);
+			fprep = NULL;
+		}
+	}
+
+private:
+	FILE *fprep;
+	BlockWriter *rep;
+	long TotalBases, TotalError;
+	size_t ReadNoError, ReadHasError;
+	long ErrorMin, ErrorMax, ContErrorMax;
+};
+
+//=============================================================================
+FILE *OpenOut(const char *fname, const char *desc)
+{
+	if (fname == NULL)
+		return NULL;
+	FILE *fp = fopen(fname, "wt");
+	if (fp == NULL)
+		fprintf(stderr, "Open %s OUT File (%s) Error!\n", desc, fname);
+	return fp;
+}
+
+void PutFastq(BlockWriter &w, const vector<Field> &f)
+{
+	w.put('@');
+	w.put(f[0].s, f[0].len);
+	w.put('\n');
+	w.put(f[9].s, f[9].len);
+	w.put("\n+\n", 3);
+	w.put(f[10].s, f[10].len);
+	w.put('\n');
+}
+
+struct Options
+{
+	const char *sam;
+	int mode;
+	const char *fastq, *rnFastq, *ans, *ansStats, *sfq, *sfqStats;
+};
+
+bool SamExtract(const Options &opt)
+{
+	FILE *fpin, *fpfq, *fprn, *fpans, *fpsfq;
+	size_t line = 0, ReadCount = 0, TotalLen = 0, GCcnt = 0;
+	size_t MinSeqLen = 0, MaxSeqLen = 0;
+	GoldStdStats gstd;
+
+	fpin = (strcmp(opt.sam, "-") == 0) ? stdin : fopen(opt.sam, "rt");
+	if (fpin == NULL)
+	{
+		fprintf(stderr, "Read SAM File Error!\n");
+		return false;
+	}
+
+	fpfq = OpenOut(opt.fastq, "fastq");
+	fprn = OpenOut(opt.rnFastq, "fastq");
+	fpans = OpenOut(opt.ans, "ans");
+	fpsfq = OpenOut(opt.sfq, "sfq");
+	if ((opt.fastq && !fpfq) || (opt.rnFastq && !fprn) || (opt.ans && !fpans) || (opt.sfq && !fpsfq))
+		return false;
+	if (opt.ans != NULL && !gstd.open(opt.ans))
+		return false;
+
+	{
+		LineReader reader(fpin);
+		BlockWriter wfq(fpfq), wrn(fprn), wans(fpans), wsfq(fpsfq);
+		vector<Field> f;
+		char *s;
+		size_t len;
+
+		while (reader.next(s, len))
+		{
+			line++;
+
+			// line count indicator
+			if (line % 1000000 == 0)
+			{
+				fprintf(stderr, "\rextract: %lu processed", line);
+				fflush(stderr);
+			}
+
+			// skip header
+			if (len == 0 || s[0] == '@')
+				continue;
+
+			if (SplitFields(s, len, f) < SAM_MIN_FIELD)
+			{
+				fprintf(stderr, "SAM file format error at line#%lu\n", line);
+				return false;
+			}
+
+			// filter out flags of 256 (not primary alignment) and 2048 (supplementary alignment)
+			// it shall equal to the whole data
+			int flag = atoi(f[1].s);
+			if (flag & (FLAG_SECONDARY | FLAG_SUPPLEMENTARY))
+				continue;
+
+			const Field &name = f[0], &seq = f[9], &qual = f[10];
+			PutFastq(wfq, f);
+
+			// sfq and its summary in the same pass
+			wsfq.put(name.s, name.len);
+			wsfq.put('\t');
+			wsfq.put(seq.s, seq.len);
+			wsfq.put('\t');
+			wsfq.put(qual.s, qual.len);
+			wsfq.put('\n');
+			for (size_t i=0; i<seq.len; i++)
+				GCcnt += (seq.s[i] == 'G' || seq.s[i] == 'C');
+			MinSeqLen = (ReadCount == 0) ? seq.len : MIN(MinSeqLen, seq.len);
+			MaxSeqLen = MAX(MaxSeqLen, seq.len);
+			TotalLen += seq.len;
+			ReadCount++;
+
+			bool hasN = HasChar(seq, 'N');
+			if (opt.mode == MODE_BACKTRACK && !hasN)
+				PutFastq(wrn, f);
+
+			// filter out flag of 0x4 (read unmapped)
+			if (flag & FLAG_UNMAP)
+				continue;
+
+			const Field *md = NULL;
+			if (opt.mode == MODE_MEM)
+			{
+				// the mapping quality shall not be 0
+				if (atoi(f[4].s) < 1 || !IsMatchOnlyCigar(f[5]))
+					continue;
+				for (size_t i=1; i<f.size(); i++)
+					if (f[i].startsWith("MD:Z:"))
+						md = &f[i];
+			}
+			else
+			{
+				// reads having Ns are not in the gold standard
+				if (hasN)
+					continue;
+
+				// we only want the "XT:A:U" tag, and no record with "XA:Z:" tag
+				bool unique = false, hasXA = false;
+				for (size_t i=11; i<f.size(); i++)
+				{
+					if (f[i].equals("XT:A:U"))
+						unique = true;
+					else if (f[i].startsWith("XA:Z:"))
+						hasXA = true;
+				}
+				if (!unique || hasXA || !IsMatchOnlyCigar(f[5]))
+					continue;
+				for (size_t i=11; i<f.size() && md == NULL; i++)
+					if (f[i].startsWith("MD:Z:"))
+						md = &f[i];
+			}
+			if (md == NULL)
+				continue;
+
+			// find out the answer, export it and count its errors
+			Field ans = { md->s+5, md->len-5 };
+			wans.put(name.s, name.len);
+			wans.put('\t');
+			wans.put(ans.s, ans.len);
+			wans.put('\n');
+			if (opt.ans != NULL)
+				gstd.add(name, ans);
+		}
+	}
+
+	if (fpin != stdin)
+		fclose(fpin);
+	if (fpfq) fclose(fpfq);
+	if (fprn) fclose(fprn);
+	if (fpans) fclose(fpans);
+	if (fpsfq) fclose(fpsfq);
+	gstd.close();
+
+	if (opt.ans != NULL)
+	{
+		gstd.summary(stdout);
+		if (opt.ansStats != NULL)
+		{
+			FILE *fp = OpenOut(opt.ansStats, "ans stats");
+			if (fp == NULL)
+				return false;
+			gstd.summary(fp);
+			fclose(fp);
+		}
+	}
+
+	// same columns as the do_stats summary of the map_proc scripts
+	if (opt.sfqStats != NULL)
+	{
+		FILE *fp = OpenOut(opt.sfqStats, "sfq stats");
+		if (fp == NULL)
+			return false;
+		fprintf(fp, "%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%.2f%%\n", ReadCount, TotalLen,
+			ReadCount ? TotalLen/ReadCount : 0, MaxSeqLen, MinSeqLen, GCcnt,
+			TotalLen ? 100.0*(double)GCcnt/(double)TotalLen : 0.0);
+		fclose(fp);
+	}
+
+	return true;
+}
+
+// Recompute the statistics of an existing .ans file (name<TAB>MD per line)
+bool AnsStats(const char *ansFile, const char *ansStats)
+{
+	FILE *fpin = fopen(ansFile, "rt");
+	GoldStdStats gstd;
+	char *s;
+	size_t len;
+
+	if (fpin == NULL)
+	{
+		fprintf(stderr, "Read ans File Error!\n");
+		return false;
+	}
+	if (!gstd.open(ansFile))
+		return false;
+
+	{
+		LineReader reader(fpin);
+		while (reader.next(s, len))
+		{
+			char *tab = (char *)memchr(s, '\t', len);
+			if (tab == NULL)
+				continue;
+			Field name = { s, (size_t)(tab-s) };
+			Field md = { tab+1, len-(tab-s)-1 };
+			gstd.add(name, md);
+		}
+	}
+	fclose(fpin);
+	gstd.close();
+
+	gstd.summary(stdout);
+	if (ansStats != NULL)
+	{
+		FILE *fp = OpenOut(ansStats, "ans stats");
+		if (fp == NULL)
+			return false;
+		gstd.summary(fp);
+		fclose(fp);
+	}
+	return true;
+}
+
+
+
+//=============================================================================
+int main(int argc, char **argv)
+{
+//=============================================================================
+	Options opt;
+	memset(&opt, 0, sizeof(opt));
+	const char *ansOnly = NULL;
+	bool ok = true;
+
+	for (int i=1; i<argc; i++)
+	{
+		if (i+1 >= argc || argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0')
+		{
+			if (opt.sam == NULL)
+			{
+				opt.sam = argv[i];
+				continue;
+			}
+			ok = false;
+			break;
+		}
+		switch (argv[i][1])
+		{
+		case 'm':
+			if (strcmp(argv[i+1], "mem") == 0)
+				opt.mode = MODE_MEM;
+			else if (strcmp(argv[i+1], "backtrack") == 0)
+				opt.mode = MODE_BACKTRACK;
+			else
+				ok = false;
+			break;
+		case 'f': opt.fastq = argv[i+1]; break;
+		case 'n': opt.rnFastq = argv[i+1]; break;
+		case 'a': opt.ans = argv[i+1]; break;
+		case 't': opt.ansStats = argv[i+1]; break;
+		case 'q': opt.sfq = argv[i+1]; break;
+		case 's': opt.sfqStats = argv[i+1]; break;
+		case 'A': ansOnly = argv[i+1]; break;
+		default: ok = false; break;
+		}
+		i++;
+	}
+
+	if (!ok || (opt.sam == NULL) == (ansOnly == NULL))
+	{
+		printf("=== samExtract: Extract reads and gold-standard MD answers from a bwa SAM file in one pass ===\n\n");
+		printf("Usage: samExtract in.sam [-m mem|backtrack] [-f out.fq] [-n outNoN.fq] [-a out.ans] [-t ans.stats] [-q out.sfq] [-s sfq.stats]\n");
+		printf("       samExtract -A in.ans [-t ans.stats]\n");
+		printf(" -in.sam: '-' for stdin; secondary and supplementary records are skipped\n");
+		printf(" -m: Gold-standard rule of the aligner (default mem)\n");
+		printf(" -n: Reads without N (backtrack)\n");
+		printf(" -a: Gold-standard answers (name<TAB>MD); also writes out.ans.report and prints the MD statistics\n");
+		printf(" -t: Write the MD statistics (#base, #error, #read w/o error, #read w/ error, min/max error, max cont. error)\n");
+		printf(" -q/-s: SFQ of the reads and its summary\n");
+		printf(" -A: Only compute the MD statistics of an existing .ans file\n");
+		printf("Verson: 1.0 (2026/10) \n\n");
+
+		return 1;
+	}
+
+//=============================================================================
+	if (ansOnly != NULL)
+		ok = AnsStats(ansOnly, opt.ansStats);
+	else
+		ok = SamExtract(opt);
+
+//=============================================================================
+	return ok ? 0 : 1;
+}
@@ -2,16 +2,48 @@ import os
 import re
 import datetime
 import numpy as np
-import matplotlib.pyplot as plt 
-from matplotlib import gridspec
-import glob
+import json
 import base64
-from matplotlib.backends.backend_pdf import PdfPages
 from bs4 import BeautifulSoup
 import csv
 
+#matplotlib is only loaded for the PDF report, see use_matplotlib()
+plt, gridspec, PdfPages = None, None, None
+
 colors = ['tab:blue', 'tab:orange', 'tab:green', 'tab:red', 'tab:purple', 'tab:brown', 'tab:pink', 'tab:gray', 'tab:olive', 'tab:cyan']
 labels = ['P', 'S', 'C', 'O', 'M', 'F', 'N']
+#reads are labeled with uint8 codes: the index in labels, len(labels) if unlabeled
+LABEL_CODES = np.full(256, len(labels), dtype=np.uint8)
+for code, label in enumerate(labels):
+	LABEL_CODES[ord(label)] = code
+
+
+def label_counts(label_array):
+	"""Number of reads of each label code, unlabeled reads last."""
+	return np.bincount(label_array, minlength=len(labels)+1)
+
+
+def label_ids(label_array, label):
+	return np.flatnonzero(label_array == labels.index(label))
+
+
+def ratio(num, den):
+	return np.divide(num, den, out=np.zeros(len(num)), where=den > 0)
+
+
+def use_matplotlib():
+	"""Load matplotlib for the figures of report.pdf; the html report draws its charts from json."""
+	global plt, gridspec, PdfPages
+	import matplotlib; matplotlib.use('pdf')
+	import matplotlib.pyplot as plt
+	from matplotlib import gridspec
+	from matplotlib.backends.backend_pdf import PdfPages
+
+
+def aln_title(aln_tool):
+	return aln_tool + ' (local)' if aln_tool == 'bwa-mem' else aln_tool + ' (end2end)'
+
+
 label_des = {
 			'P': 'Perfectly-matched reads',
 			'S': 'Reads with substitution errors',
@@ -62,8 +94,14 @@ def fill_in_label(stats, soup, template_fpath):
 	label_dis_div.append(img_src)
 
 
-def save_to_html(out_dir, template_fpath, data, thre, aln_tool_list, label_distribution, basic_stats, gen_stats, neg_vals):
-	"""concat all figures into report.html by inserting figures into template.html"""
+def chart_json(charts):
+	"""Compact json of the chart data, safe to inline in a script tag."""
+	text = json.dumps(charts, separators=(',', ':'))
+	return text.replace('<', '\\u003c').replace('>', '\\u003e').replace('&', '\\u0026')
+
+
+def save_to_html(out_dir, template_fpath, data, thre, aln_tool_list, label_distribution, basic_stats, gen_stats, neg_vals, charts):
+	"""fill template.html with the stats tables and the chart data (pie, label bars and the distribution of each aligner)"""
 	toc_fpath = '{}/toc.html'.format(os.path.dirname(template_fpath))
 	all_html_fpath = '{0}/{1}/post_report.html'.format(out_dir, data)
 	index_fpath = '{0}/{1}.html'.format(out_dir, data)
@@ -150,19 +188,10 @@ def save_to_html(out_dir, template_fpath, data, thre, aln_tool_list, label_distr
 		#set up label dis. table
 		fill_in_label(flatten(label_distribution, aln_tool_list), soup, template_fpath)
 
-		#plot label dis piechart
-		img_fpath = '{}/images/piechart.png'.format(src_dir)
-		data_uri = base64.b64encode(open(img_fpath, 'rb').read()).decode('utf-8').replace('\n', '')
-		label_dis_bar = soup.find("div", id="label-dis-piechart")
-		img_src = soup.new_tag("img", src="data:image/png;base64,{0}".format(data_uri))
-		label_dis_bar.append(img_src)
-
-		#plot label dis bar
-		img_fpath = '{}/images/label_dis_bar.png'.format(src_dir)
-		data_uri = base64.b64encode(open(img_fpath, 'rb').read()).decode('utf-8').replace('\n', '')
-		label_dis_bar = soup.find("div", id="label-dis-barchart")
-		img_src = soup.new_tag("img", src="data:image/png;base64,{0}".format(data_uri))
-		label_dis_bar.append(img_src)
+		#charts are drawn as inline svg by the template from the json in #chart-data
+		chart_data = soup.new_tag("script", id="chart-data", type="application/json")
+		chart_data.string = chart_json(charts)
+		soup.head.append(chart_data)
 
 		#section II
 		#the rest of distribution graph for each aligner
@@ -176,16 +205,9 @@ def save_to_html(out_dir, template_fpath, data, thre, aln_tool_list, label_distr
 			sec_two.append(title)
 			i += 1
 
-			cnt = 1
-			files = glob.glob('{0}/{1}/plot/*.png'.format(src_dir, aln_tool))
-			files.sort(key=os.path.getmtime)
-			for img_fpath in files:
-				data_uri = base64.b64encode(open(img_fpath, 'rb').read()).decode('utf-8').replace('\n', '')
+			for cnt in range(1, len(charts['dist'][aln_tool])+1):
 				new_div = soup.new_tag("div", id="{0}-{1}".format(aln_tool, cnt), **{'class': 'inner'})
-				img_src = soup.new_tag("img", src="data:image/png;base64,{0}".format(data_uri))
-				new_div.append(img_src)
 				sec_two.append(new_div)
-				cnt += 1
 
 		#write report.html
 		with open(all_html_fpath, 'w') as w:
@@ -203,6 +225,57 @@ def save_to_html(out_dir, template_fpath, data, thre, aln_tool_list, label_distr
 			w.write(str(soup))
 
 
+#same layout as library/preQ/metrics.h: bump whenever a key is renamed, removed or changes meaning
+METRICS_VERSION = 1
+
+
+def metric_key(name):
+	"""'Assembly Size (Mbp)' -> 'assembly_size_mbp'"""
+	return re.sub(r'[^a-z0-9]+', '_', name.lower().replace("'", '').replace('#', 'num ').replace('%', 'pct')).strip('_')
+
+
+def metric_value(value):
+	if isinstance(value, str):
+		value = value.replace(',', '').rstrip('%')
+		try:
+			value = int(value) if value.isdigit() else float(value)
+		except ValueError:
+			return None
+	if value is None or value != value:
+		return None
+	if isinstance(value, (bool, np.bool_)):
+		return int(value)
+	if isinstance(value, (int, np.integer)):
+		return int(value)
+	return round(float(value), 4)
+
+
+def load_metrics(fpath):
+	"""Metrics of a native tool (name.metrics.json), empty if it is missing or of another version."""
+	if not os.path.isfile(fpath):
+		return {}
+	with open(fpath) as infile:
+		doc = json.load(infile)
+	if doc.get('format') != 'squat-metrics' or doc.get('version') != METRICS_VERSION:
+		return {}
+	return doc['metrics']
+
+
+def save_metrics(prefix, tool, input_name, metrics):
+	"""Write prefix.metrics.json and prefix.metrics.tsv; metrics is a list of (key, value) in output order."""
+	values = [(key, metric_value(value)) for key, value in metrics]
+	doc = {'format': 'squat-metrics', 'version': METRICS_VERSION, 'tool': tool, 'input': input_name,
+		'metrics': dict(values)}
+	with open(prefix + '.metrics.json', 'w') as w:
+		json.dump(doc, w, indent=2)
+		w.write('\n')
+	with open(prefix + '.metrics.tsv', 'w') as w:
+		w.write('metric\tvalue\n')
+		w.write('format\tsquat-metrics\nversion\t{0}\ntool\t{1}\ninput\t{2}\n'.format(METRICS_VERSION, tool, input_name))
+		for key, value in values:
+			w.write('{0}\t{1}\n'.format(key, 'null' if value is None else value))
+
+
 def save_to_pdf(all_pdf_fpath, plot_figures):
 	"""concat all figures into report.pdf"""
 
@@ -291,161 +364,136 @@ def get_genome_eval_stat(src_dir, ref_name):
 	return rows
 
 
-def plot_sam_dis(src_dir, data, aln_tool, label_array, read_size, plot_figures, xlabel='', label='', thre=''):
+def sam_dis_data(data, aln_tool, label_array, read_size, xlabel='', label='', thre=''):
+	"""20-bin histogram (in percentile) of the ratios or scores of one label, with its legend"""
 	hist, bins = np.histogram(data, bins=20)
+	num_read = int(label_counts(label_array)[labels.index(label)])
+	dis = {
+		'title': '{0} distribution of {1} reads\n{2}'.format(xlabel, label, aln_tool),
+		'xlabel': xlabel, 'label': label,
+		'bins': np.round(bins, 6).tolist(),
+		'pct': np.round(hist.astype(np.float32) / hist.sum() * 100, 3).tolist(),
+		'legend': []
+	}
+
+	#if 'Alignment Score' not in xlabel:
+	if thre:
+		ratio_good = np.sum(data < thre) / num_read if num_read else 0
+		ratio_bad = 1 - ratio_good
+		dis['legend'].append('Below threshold (eligible): {:.1%}'.format(ratio_good))
+		dis['legend'].append('Above threshold (poor): {:.1%}'.format(ratio_bad))
+		dis['thre'] = thre
+		#zoom in the graph if necessary
+		dis['zoom'] = bool(np.max(data) < 0.5)
+
+	label_dis = num_read / read_size
+	dis['legend'].append('No. of {0} reads: {1} ({2:.1%})'.format(label, num_read, label_dis))
+
+	if xlabel == 'Mismatch%':
+		dis['fig_name'] = 'mismatch_ratio'
+	elif xlabel == 'Clip%':
+		dis['fig_name'] = 'clip_ratio'
+	else:
+		dis['fig_name'] = 'aln_score_{}'.format(label)
+
+	return dis
+
+
+def plot_sam_dis(dis, plot_figures):
+	bins, pct = np.array(dis['bins']), dis['pct']
 
 	fig = plt.figure(figsize=(15, 10))
 	#gs = gridspec.GridSpec(1, 2, width_ratios=[4, 1]) 
 
 	ax = fig.add_subplot(111)
-	ax.bar(bins[:-1], hist.astype(np.float32) / hist.sum() * 100, width=(bins[1]-bins[0]), alpha=0.5, color='steelblue', linewidth=0, align='edge')
-	ax.set_xlabel(xlabel)
+	ax.bar(bins[:-1], pct, width=(bins[1]-bins[0]), alpha=0.5, color='steelblue', linewidth=0, align='edge')
+	ax.set_xlabel(dis['xlabel'])
 	ax.set_ylabel('Percentile')
 
 	#add legend
-	num_read = np.sum(label_array == label)
-	#if 'Alignment Score' not in xlabel:
-	if thre:
+	legend = list(dis['legend'])
+	if 'thre' in dis:
+		thre = dis['thre']
 		ax.axvline(thre, color='red', zorder=20)
-		ratio_good = np.sum(data < thre) / num_read if num_read else 0
-		ratio_bad = 1 - ratio_good
-		ax.plot(1, 1, label='Below threshold (eligible): {:.1%}'.format(ratio_good), marker='', ls='')
-		ax.plot(1, 1, label='Above threshold (poor): {:.1%}'.format(ratio_bad), marker='', ls='')
+		ax.plot(1, 1, label=legend.pop(0), marker='', ls='')
+		ax.plot(1, 1, label=legend.pop(0), marker='', ls='')
 
-		#zoom in the graph if necessary
-		if np.max(data) < 0.5:
+		if dis['zoom']:
 			ax.set_xlim(0, 0.5)
-			ax.text(thre*2, 0.5, '{} ratio'.format(label), transform=ax.transAxes, zorder=21)
+			ax.text(thre*2, 0.5, '{} ratio'.format(dis['label']), transform=ax.transAxes, zorder=21)
 		else:
-			ax.text(thre, 0.5, '{} ratio'.format(label), transform=ax.transAxes, zorder=21)
+			ax.text(thre, 0.5, '{} ratio'.format(dis['label']), transform=ax.transAxes, zorder=21)
 	
-	label_dis = num_read / read_size
 	midValue = sum(bins)/len(bins)
-	ax.plot(midValue, midValue, label='No. of {0} reads: {1} ({2:.1%})'.format(label, num_read, label_dis), marker='', ls='')
+	ax.plot(midValue, midValue, label=legend.pop(0), marker='', ls='')
 	ax.legend(loc=1, prop={'size': 15})
-
-	title = '{0} distribution of {1} reads\n{2}'.format(xlabel, label, aln_tool)
-	ax.set_title(title)
+	ax.set_title(dis['title'])
 
 	plot_figures.append(fig)
-
-	if xlabel == 'Mismatch%':
-		fig_name = 'mismatch_ratio'
-	elif xlabel == 'Clip%':
-		fig_name = 'clip_ratio'
-	else:
-		fig_name = 'aln_score_{}'.format(label)
-	#title = '{0} distribution of {1} reads {2}'.format(xlabel, label, aln_tool)
-	plt.savefig('{0}/{1}/plot/{2}.png'.format(src_dir, aln_tool, fig_name))
 	plt.close()
 
 
-def draw_bar_bi(ax, field_list, read_size, idx, thre, label=''):
-	upper_cnt, lower_cnt = 0, 0
-	for field in field_list:
-		if field < thre:
-			upper_cnt += 1
-		else:
-			lower_cnt += 1
-	
-	#print(label, upper_cnt, lower_cnt)
-	value1 = round(upper_cnt / read_size * 100)
-	ax.bar(idx, value1, color=colors[idx], align='center', width=0.5)#, label=label)#label=r'${}_+$'.format(label))
-	if upper_cnt:
-		num = '~0' if value1 == 0 else value1
-	else:
-		num = 0
-	ax.text(idx, value1+5, '{}'.format(num), ha='center')
-	
-	value2 = round(-1 * lower_cnt / read_size * 100)	
-	ax.bar(idx, value2, color=colors[idx], align='center', width=0.5)#label=r'${}_-$'.format(label))
-	if lower_cnt:
-		num = '~0' if value2 == 0 else value2
-	else:
-		num = 0
-	ax.text(idx, value2-5, '{}'.format(num), ha='center')
+def bar_bi_value(field_list, read_size, thre):
+	"""Percentages (and counts) of the reads below the threshold (above the x-axis) and over it (below the x-axis)"""
+	upper_cnt = int(np.sum(field_list < thre))
+	lower_cnt = len(field_list) - upper_cnt
+	return round(upper_cnt / read_size * 100), round(-1 * lower_cnt / read_size * 100), upper_cnt, lower_cnt
 
-	return value1, value2, lower_cnt
 
-
-def draw_bar(ax, label_array, read_size, idx, label=''):
-	constant = -1 if label == 'F' else 1
-	label_cnt = np.sum(label_array == label)
-	value = round(int(constant * label_cnt / read_size * 100))
-	ax.bar(idx, value, color=colors[idx], align='center', width=0.5)#, label=label)
-	if label_cnt:
-		num = '~0' if value == 0 else value
-	else:
-		num = 0
-	ax.text(idx, value+5*constant, '{}'.format(num), ha='center')
-
-	return value
+def bar_text(value, cnt):
+	if cnt:
+		return '~0' if value == 0 else value
+	return 0
 
 
-def do_label_dis_bar(ax, align_array, aln_tool, label_array, thre, neg_vals):
-	read_size = len(align_array)
+def label_dis_bar_data(align_array, aln_tool, label_array, thre, neg_vals):
+	"""Bars of the label distribution, [label, pos%, neg%, #pos, #neg] per label; a side is None if the label has no bar there"""
+	read_size = len(label_array)
+	counts = label_counts(label_array)
 	#x_labels = ['P', 'S', 'C', 'O', 'M', 'F', 'N'] if 'backtrack' not in aln_tool else ['P', 'S', 'O', 'M', 'F', 'N']
-	idx = 0
+	field_lists = {
+		'P': None, 'S': do_nm(align_array, label_array), 'C': do_cr(align_array, label_array),
+		'O': do_others(align_array, label_array), 'M': None, 'F': None, 'N': do_N(align_array, label_array)
+	}
+	thre_keys = {'S': 'MR', 'C': 'CR', 'O': 'OR', 'N': 'NR'}
+	bars = []
 	below_cnt = 0
-	ymax, ymin = 0, 0
-
-	#P
-	value = draw_bar(ax, label_array, read_size, idx, label='P')
-	idx += 1
-	ymax = value if ymax < value else ymax
-
-	#S
-	nm_list = do_nm(align_array, label_array)
-	pos_value, neg_value, lower_cnt = draw_bar_bi(ax, nm_list, read_size, idx, thre['MR'], label='S')
-	below_cnt += lower_cnt
-	idx += 1
-	ymax = pos_value if ymax < pos_value else ymax
-	ymin = neg_value if ymin > neg_value else ymin
-	neg_vals['S'].append(lower_cnt / read_size)
-	
-	#C
-	#if 'backtrack' not in aln_tool:
-	cr_list = do_cr(align_array, label_array)
-	pos_value, neg_value, lower_cnt = draw_bar_bi(ax, cr_list, read_size, idx, thre['CR'], label='C')
-	below_cnt += lower_cnt
-	idx += 1
-	ymax = pos_value if ymax < pos_value else ymax
-	ymin = neg_value if ymin > neg_value else ymin
-	neg_vals['C'].append(lower_cnt / read_size)
-
-	#O
-	o_list = do_others(align_array, label_array)
-	pos_value, neg_value, lower_cnt = draw_bar_bi(ax, o_list, read_size, idx, thre['OR'], label='O')
-	below_cnt += lower_cnt
-	idx += 1
-	ymax = pos_value if ymax < pos_value else ymax
-	ymin = neg_value if ymin > neg_value else ymin
-	neg_vals['O'].append(lower_cnt / read_size)
-
-	#M
-	value = draw_bar(ax, label_array, read_size, idx, label='M')
-	idx += 1
-	ymax = value if ymax < value else ymax
-
-	#F
-	value = draw_bar(ax, label_array, read_size, idx, label='F')
-	lower_cnt = np.sum(label_array == 'F')
-	below_cnt += lower_cnt
-	idx += 1
-	ymin = value if ymin > value else ymin
-	neg_vals['F'].append(lower_cnt / read_size)
-
-	#N
-	n_list = do_N(align_array, label_array)
-	pos_value, neg_value, lower_cnt = draw_bar_bi(ax, n_list, read_size, idx, thre['NR'], label='N')
-	below_cnt += lower_cnt
-	idx += 1
-	ymax = pos_value if ymax < pos_value else ymax
-	ymin = neg_value if ymin > neg_value else ymin
-	neg_vals['N'].append(lower_cnt / read_size)
 
+	for label in labels:
+		label_cnt = int(counts[labels.index(label)])
+		if label in thre_keys:
+			bar = [label] + list(bar_bi_value(field_lists[label], read_size, thre[thre_keys[label]]))
+		elif label == 'F':
+			bar = [label, None, round(int(-1 * label_cnt / read_size * 100)), None, label_cnt]
+		else:
+			bar = [label, round(int(label_cnt / read_size * 100)), None, label_cnt, None]
+
+		if bar[4] is not None:
+			below_cnt += bar[4]
+			neg_vals[label].append(bar[4] / read_size)
+		bars.append(bar)
 
 	below_pct = below_cnt / read_size
+	#record barplot input for future use
+	return field_lists, below_pct, {'title': aln_title(aln_tool), 'bars': bars, 'below': below_pct}
+
+
+def bar_range(bar_data_list):
+	"""Lowest and highest bar over the aligners, the charts share the y-axis"""
+	values = [0] + [value for bar_data in bar_data_list for bar in bar_data['bars'] for value in bar[1:3] if value is not None]
+	return min(values), max(values)
+
+
+def do_label_dis_bar(ax, bar_data):
+	for idx, [label, pos_value, neg_value, upper_cnt, lower_cnt] in enumerate(bar_data['bars']):
+		if pos_value is not None:
+			ax.bar(idx, pos_value, color=colors[idx], align='center', width=0.5)
+			ax.text(idx, pos_value+5, '{}'.format(bar_text(pos_value, upper_cnt)), ha='center')
+		if neg_value is not None:
+			ax.bar(idx, neg_value, color=colors[idx], align='center', width=0.5)
+			ax.text(idx, neg_value-5, '{}'.format(bar_text(neg_value, lower_cnt)), ha='center')
+
+	below_pct = bar_data['below']
 	above_pct = 1 - below_pct
 
 	ax.plot(1, 1, label='Above: {:.1%}'.format(above_pct), marker='', ls='')
@@ -455,11 +503,7 @@ def do_label_dis_bar(ax, align_array, aln_tool, label_array, thre, neg_vals):
 	ax.set_xticklabels(labels)
 	ax.set_ylabel('Percentage')
 	ax.legend(loc=1, prop={'size': 10}, frameon=False)
-	title = aln_tool + ' (local)' if aln_tool == 'bwa-mem' else aln_tool + ' (end2end)'
-	ax.set_title('{}'.format(title))
-
-	#record barplot input for future use
-	return {'P': None, 'S': nm_list, 'C': cr_list, 'O': o_list, 'M': None, 'F': None, 'N': n_list}, below_pct, ymax, ymin
+	ax.set_title('{}'.format(bar_data['title']))
 
 
 def add_text(ax, text, fontsize='x-large', weight='medium'):
@@ -532,25 +576,22 @@ def do_label_dis_table(label_dis, src_dir, aln_tool_list, plot_figures):
 	#save_to_csv(flatten(label_dis, aln_tool_list), src_dir, aln_tool_list)
 
 
-def do_label_piechart(label_dis, src_dir, aln_tool_list, plot_figures):
-	#labels = ['P', 'C', 'S', 'O', 'F', 'M', 'N']
-	fracs = [None] * len(labels)
+def label_pie_data(label_dis, aln_tool_list):
+	"""Label percentages of each aligner for the piecharts"""
+	return [{'title': aln_title(aln_tool), 'fracs': [round(label_dis[aln_tool][label] * 100, 3) for label in labels]} for aln_tool in aln_tool_list]
 
-	fig = plt.figure(figsize=(15, 8))
-	ax_list = [None] * len(aln_tool_list)
-	for i, aln_tool in enumerate(aln_tool_list):
-		for j, label in enumerate(labels):
-			fracs[j] = label_dis[aln_tool][label] * 100
 
-		ax = fig.add_subplot(len(aln_tool_list) / 2, 2, i+1)
-		patches, texts, autotexts = ax.pie(fracs, labels=labels, autopct="%.1f%%", radius=0.8, pctdistance=1.25, labeldistance=1.05)
+def do_label_piechart(pie_data, plot_figures):
+	#labels = ['P', 'C', 'S', 'O', 'F', 'M', 'N']
+	fig = plt.figure(figsize=(15, 8))
+	for i, pie in enumerate(pie_data):
+		ax = fig.add_subplot((len(pie_data) + 1) // 2, 2, i+1)
+		patches, texts, autotexts = ax.pie(pie['fracs'], labels=labels, autopct="%.1f%%", radius=0.8, pctdistance=1.25, labeldistance=1.05)
 		patches[0].set_edgecolor('white')
 		for text in texts:
 			text.set_fontsize(15)
-		title = aln_tool + ' (local)' if aln_tool == 'bwa-mem' else aln_tool + ' (end2end)'
-		ax.set_title(title)
+		ax.set_title(pie['title'])
 
-	fig.savefig('{}/images/piechart.png'.format(src_dir))
 	plot_figures.append(fig)
 	plt.close()
 
@@ -558,88 +599,28 @@ def do_label_piechart(label_dis, src_dir, aln_tool_list, plot_figures):
 def do_nm(align_array, label_array):
 	"""plot mismatch in unique reads with sub. error"""
 
-	cnt = 0
-	label_id_list = np.where(label_array == 'S')[0]
-	nm_list = np.zeros(len(label_id_list))
-
-	for _id in label_id_list:
-		try:
-			nm_list[cnt] = align_array[_id]['num_mismatch']/len(align_array[_id]['seq'])
-		except:
-			print(_id)
-		cnt += 1
-
-
-	return nm_list
+	label_id_list = label_ids(label_array, 'S')
+	return ratio(align_array['num_mismatch'][label_id_list], align_array['seq_len'][label_id_list])
 
 
 def do_cr(align_array, label_array):
 	"""clip rate, excluding bowtie2-backtrack (no clip labels)"""
 
-	cnt = 0
-	label_id_list = np.where(label_array == 'C')[0]
-	cr_list = np.zeros(len(label_id_list))
-
-	for _id in label_id_list:
-		length, clip_size = 0, 0
-		cigar = align_array[_id]['cigar']
-		m = re.findall('\d+[MIDNSHP=X]', cigar)
-		for value in m:
-			length += int(value[:-1])
-			if value[-1] == 'S':
-				clip_size += int(value[:-1])
-
-		cr_list[cnt] = clip_size / length
-		cnt += 1
-	
-	return cr_list
+	label_id_list = label_ids(label_array, 'C')
+	return ratio(align_array['clip'][label_id_list], align_array['cigar_len'][label_id_list])
 
 
 def do_as(align_array, label_array, label):
 	""""alignment score, excluding bwa-backtrack (no AS field) and bowtie2-backtrack for clipped reads"""
 
-	label_id_list = np.where(label_array == label)[0]
-	as_list = np.zeros(len(label_id_list))
-	align_subset = align_array[label_id_list]
-	cnt = 0
-
-	for alignment in align_subset:
-		as_list[cnt] = alignment['AS']
-		cnt += 1
-
-	return as_list
+	return align_array['AS'][label_ids(label_array, label)].astype(np.float64)
 
 
 def do_others(align_array, label_array):
-	cnt = 0
-	label_id_list = np.where(label_array == 'O')[0]
-	o_list = np.zeros(len(label_id_list))
-
-	for _id in label_id_list:
-		length, o_size = 0, 0
-		cigar = align_array[_id]['cigar']
-		m = re.findall('\d+[MIDNSHP=X]', cigar)
-		for value in m:
-			length += int(value[:-1])
-			if value[-1] in ['I', 'D', 'P', '=', 'X']:
-				o_size += int(value[:-1])
-
-		o_list[cnt] = o_size / length
-		cnt += 1
-	
-	return o_list
+	label_id_list = label_ids(label_array, 'O')
+	return ratio(align_array['other'][label_id_list], align_array['cigar_len'][label_id_list])
 
 
 def do_N(align_array, label_array):
-	cnt = 0
-	label_id_list = np.where(label_array == 'N')[0]
-	n_list = np.zeros(len(label_id_list))
-	
-	for _id in label_id_list:
-		seq = align_array[_id]['seq']
-		if 'N' in seq:
-			n_size = seq.count('N')
-			n_list[cnt] = n_size / len(seq)
-			cnt += 1
-
-	return n_list
+	label_id_list = label_ids(label_array, 'N')
+	return ratio(align_array['n_count'][label_id_list], align_array['seq_len'][label_id_list])
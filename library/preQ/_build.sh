@@ -1,8 +1,8 @@
-echo "g++ -O3 peQdist.cpp -o peQdist"
-g++ -O3 peQdist.cpp -o peQdist
+echo "g++ -O3 -pthread peQdist.cpp -o peQdist"
+g++ -O3 -pthread peQdist.cpp -o peQdist
 
-echo "g++ -O3 peQsubset.cpp -o peQsubset"
-g++ -O3 peQsubset.cpp -o peQsubset
+echo "g++ -O3 -pthread peQsubset.cpp -o peQsubset"
+g++ -O3 -pthread peQsubset.cpp -o peQsubset
 
-echo "g++ -O3 readQdist.cpp -o readQdist"
-g++ -O3 readQdist.cpp -o readQdist
+echo "g++ -O3 -pthread readQdist.cpp -o readQdist"
+g++ -O3 -pthread readQdist.cpp -o readQdist
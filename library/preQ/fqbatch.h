@@ -0,0 +1,328 @@
+/*
+== Record batches of FASTQ files and their lock-free pool; update: 2026/10
+A batch holds up to FQB_RECORDS records: the raw lines in one arena, each line kept with its
+'\n', and a struct of arrays with the offset and length of the name, seq, '+' and qual line
+of every record. A record is one contiguous span of the arena, so it is written out as is.
+Batches are recycled through FqBatchPool; after the first few batches of a run nothing is
+allocated, and stages on different threads can hand batches to each other.
+*/
+//=============================================================================
+#ifndef SQUAT_FQBATCH_H
+#define SQUAT_FQBATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <atomic>
+#include <thread> // for yield
+#include "fqio.h"
+#include "numa.h"
+
+#define FQB_RECORDS 4096 // records per batch
+#define FQB_LINE_MAX 10000 // longest line, as LINE_BUF_SIZE of the tools
+#define FQB_ARENA (FQB_RECORDS*4*256) // arena bytes; a batch ends early when long reads fill it
+#define FQB_POOL_DEFAULT 64 // batches of a pool if not given
+
+// the read lengths with kernels of their own: FN<L>(...) with L the length of every read of the
+// batch if it is one of them, else the generic FN<0>(...), which takes the lengths of the reads
+#define FQB_FIXED_CALL(len, FN, ...) \
+	switch (len) \
+	{ \
+	case 50: FN<50>(__VA_ARGS__); break; \
+	case 75: FN<75>(__VA_ARGS__); break; \
+	case 100: FN<100>(__VA_ARGS__); break; \
+	case 150: FN<150>(__VA_ARGS__); break; \
+	case 250: FN<250>(__VA_ARGS__); break; \
+	case 300: FN<300>(__VA_ARGS__); break; \
+	default: FN<0>(__VA_ARGS__); break; \
+	}
+// &FN<L> of the same lengths, for a kernel called through a pointer
+#define FQB_FIXED_PICK(len, FN) \
+	((len) == 50 ? &FN<50> : (len) == 75 ? &FN<75> : (len) == 100 ? &FN<100> : \
+	(len) == 150 ? &FN<150> : (len) == 250 ? &FN<250> : (len) == 300 ? &FN<300> : &FN<0>)
+
+//=============================================================================
+struct FqBatchPool;
+
+struct FqBatch
+{
+	char *Arena;
+	size_t Used; // arena bytes in use
+	size_t Count; // records
+	size_t FirstLine; // file line of the first record's name
+	std::vector<uint32_t> NameOff, SeqOff, PlusOff, QualOff; // arena offsets of the lines
+	std::vector<uint32_t> NameLen, SeqLen, PlusLen, QualLen; // line lengths without '\n'
+	bool Mixed; // the reads differ in length
+	uint32_t Id; // slot in the pool
+	FqBatchPool *Home; // the pool it goes back to
+	std::atomic<size_t> Pending; // records not yet processed, for schedulers
+
+	FqBatch() : Used(0), Count(0), FirstLine(0), Mixed(false), Id(0), Home(NULL), Pending(0)
+	{
+		// page-aligned and not touched here, so it can still be bound to a NUMA node
+		if (posix_memalign((void **)&Arena, FQIO_ALIGN, FQB_ARENA) != 0)
+			Arena = NULL;
+		NameOff.resize(FQB_RECORDS); SeqOff.resize(FQB_RECORDS); PlusOff.resize(FQB_RECORDS); QualOff.resize(FQB_RECORDS);
+		NameLen.resize(FQB_RECORDS); SeqLen.resize(FQB_RECORDS); PlusLen.resize(FQB_RECORDS); QualLen.resize(FQB_RECORDS);
+	}
+
+	~FqBatch()
+	{
+		free(Arena);
+	}
+
+	void Clear()
+	{
+		Used = Count = 0;
+		Mixed = false;
+	}
+
+	// the length of every read, 0 if they differ; picks the kernels of FQB_FIXED_CALL
+	size_t FixedLen() const
+	{
+		return (Count > 0 && !Mixed) ? SeqLen[0] : 0;
+	}
+
+	const char *Name(size_t r) const { return Arena + NameOff[r]; }
+	const char *Seq(size_t r) const { return Arena + SeqOff[r]; }
+	const char *Plus(size_t r) const { return Arena + PlusOff[r]; }
+	const char *Qual(size_t r) const { return Arena + QualOff[r]; }
+
+	// the 4 lines of record r
+	const char *Record(size_t r) const { return Arena + NameOff[r]; }
+	size_t RecordLen(size_t r) const { return QualOff[r] + QualLen[r] + 1 - NameOff[r]; }
+
+	void Start(size_t line)
+	{
+		Clear();
+		FirstLine = line + 1;
+	}
+
+	// room for one more record of the longest lines
+	bool Room() const
+	{
+		return Count < FQB_RECORDS && Used + 4*(FQB_LINE_MAX+1) <= FQB_ARENA;
+	}
+
+	// one record from in; line counts the file lines read so far.
+	// 1: added, 0: the end of the file, -1: format error, printed with its line
+	int FillRecord(FqReader &in, size_t &line)
+	{
+		if (Count > 0)
+		{
+			bool same;
+			FQB_FIXED_CALL(SeqLen[Count-1], same = FillLike, in, line);
+			if (same)
+				return 1;
+		}
+		uint32_t off[4], len[4];
+		for (int k=0; k < 4; k++)
+		{
+			off[k] = (uint32_t)Used;
+			size_t n = in.GetLine(Arena+Used, FQB_LINE_MAX);
+			if (n == 0)
+			{
+				if (k == 0) // the end of the file between records
+					return 0;
+				printf("FASTQ file format error at line#%lu\n", line+1);
+				return -1;
+			}
+			line++;
+			if (Arena[Used+n-1] != '\n')
+			{
+				if (n == FQB_LINE_MAX-1)
+				{
+					printf("FASTQ file format error at line#%lu: line longer than %d\n", line, FQB_LINE_MAX-2);
+					return -1;
+				}
+				Arena[Used+n++] = '\n'; // the last line of the file
+			}
+			len[k] = (uint32_t)(n-1);
+			Used += n;
+		}
+		if (Arena[off[0]] != '@')
+		{
+			printf("FASTQ file format error at line#%lu\n", line-3);
+			return -1;
+		}
+		if (Arena[off[2]] != '+')
+		{
+			printf("FASTQ file format error at line#%lu\n", line-1);
+			return -1;
+		}
+		if (len[3] != len[1])
+		{
+			printf("FASTQ file format error at line#%lu: incorrect length of Q-string\n", line);
+			return -1;
+		}
+		Mixed |= (Count > 0 && len[1] != SeqLen[0]);
+		NameOff[Count] = off[0]; NameLen[Count] = len[0];
+		SeqOff[Count] = off[1]; SeqLen[Count] = len[1];
+		PlusOff[Count] = off[2]; PlusLen[Count] = len[2];
+		QualOff[Count] = off[3]; QualLen[Count] = len[3];
+		Count++;
+		return 1;
+	}
+
+	// fixed-stride parsing: the next record if its lines are as long as those of the last one,
+	// as for fixed-length reads with names of one length. One span of the read block is checked
+	// at the four line ends and copied at once; false, with nothing read, if it does not fit
+	template <size_t L> bool FillLike(FqReader &in, size_t &line)
+	{
+		size_t last = Count-1;
+		size_t n0 = NameLen[last]+1, n1 = (L ? L : SeqLen[last])+1, n2 = PlusLen[last]+1;
+		size_t len = n0 + n1 + n2 + n1;
+		const char *p = in.Peek(len);
+		if (p == NULL || p[0] != '@' || p[n0-1] != '\n' || p[n0+n1-1] != '\n' || p[n0+n1] != '+'
+			|| p[n0+n1+n2-1] != '\n' || p[len-1] != '\n')
+			return false;
+		// no other line end inside the span
+		if (memchr(p, '\n', n0-1) != NULL || memchr(p+n0, '\n', n1-1) != NULL
+			|| memchr(p+n0+n1, '\n', n2-1) != NULL || memchr(p+n0+n1+n2, '\n', n1-1) != NULL)
+			return false;
+		uint32_t off = (uint32_t)Used;
+		memcpy(Arena+Used, p, len);
+		in.Skip(len);
+		Used += len;
+		line += 4;
+		NameOff[Count] = off; NameLen[Count] = (uint32_t)(n0-1);
+		SeqOff[Count] = off+n0; SeqLen[Count] = (uint32_t)(n1-1);
+		PlusOff[Count] = off+n0+n1; PlusLen[Count] = (uint32_t)(n2-1);
+		QualOff[Count] = off+n0+n1+n2; QualLen[Count] = (uint32_t)(n1-1);
+		Count++;
+		return true;
+	}
+
+	// records from in until the batch is full; Count 0: the end of the file. false: format error
+	bool Fill(FqReader &in, size_t &line)
+	{
+		Start(line);
+		while (Room())
+		{
+			int ret = FillRecord(in, line);
+			if (ret < 0)
+				return false;
+			if (ret == 0)
+				break;
+		}
+		return true;
+	}
+};
+
+// PE records, read r of b1 and b2 being one pair; Count 0: the end of both files.
+// false: format error, or one file has more records than the other
+inline bool FillPairs(FqBatch &b1, FqBatch &b2, FqReader &in1, FqReader &in2, size_t &line1, size_t &line2)
+{
+	b1.Start(line1);
+	b2.Start(line2);
+	while (b1.Room() && b2.Room())
+	{
+		int ret = b1.FillRecord(in1, line1);
+		if (ret < 0)
+			return false;
+		if (ret == 0)
+		{
+			// the end of file 1 has to be the end of file 2
+			ret = b2.FillRecord(in2, line2);
+			if (ret > 0)
+			{
+				b2.Count--; // read 2 without its mate
+				printf("FASTQ file 2 has more records than file 1, from line#%lu Error!\n", line2-3);
+			}
+			return ret == 0;
+		}
+		ret = b2.FillRecord(in2, line2);
+		if (ret <= 0)
+		{
+			b1.Count--; // read 1 without its mate
+			if (ret == 0)
+				printf("FASTQ file 1 has more records than file 2, from line#%lu Error!\n", line1-3);
+			return false;
+		}
+	}
+	return true;
+}
+
+//=============================================================================
+// Treiber stack of batch slots; the head packs a tag (against ABA) and slot+1 (0: empty).
+// With a NUMA topology the arenas of the pool are bound to its node
+struct FqBatchPool
+{
+	FqBatch **Slot; // Max of them
+	std::atomic<uint32_t> *NextFree;
+	std::atomic<uint64_t> Head;
+	std::atomic<uint32_t> Made; // slots with a batch
+	uint32_t Max;
+	const NumaTopo *Topo;
+	int Node;
+
+	// maxBatches: as many as the threads of the pool keep in use, e.g. a few per worker
+	FqBatchPool(uint32_t maxBatches = FQB_POOL_DEFAULT, const NumaTopo *topo = NULL, int node = 0) : Head(0), Made(0), Topo(topo), Node(node)
+	{
+		Max = (maxBatches < 1 ? 1 : maxBatches);
+		Slot = new FqBatch *[Max];
+		NextFree = new std::atomic<uint32_t>[Max];
+		for (uint32_t i=0; i < Max; i++)
+		{
+			Slot[i] = NULL;
+			NextFree[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	~FqBatchPool()
+	{
+		for (uint32_t i=0; i < Made.load(); i++)
+			delete Slot[i];
+		delete[] Slot;
+		delete[] NextFree;
+	}
+
+	// a free batch, a new one while fewer than Max exist; waits when all are in use
+	FqBatch *Get()
+	{
+		for (;;)
+		{
+			uint64_t h = Head.load(std::memory_order_acquire);
+			uint32_t i = (uint32_t)h;
+			if (i == 0)
+			{
+				uint32_t m = Made.load(std::memory_order_relaxed);
+				if (m < Max)
+				{
+					if (Made.compare_exchange_weak(m, m+1, std::memory_order_relaxed))
+					{
+						Slot[m] = new FqBatch();
+						Slot[m]->Id = m;
+						Slot[m]->Home = this;
+						if (Topo != NULL)
+							Topo->Bind(Slot[m]->Arena, FQB_ARENA, Node);
+						return Slot[m];
+					}
+				}
+				else
+					std::this_thread::yield();
+				continue;
+			}
+			uint64_t nh = (((h >> 32) + 1) << 32) | NextFree[i-1].load(std::memory_order_relaxed);
+			if (Head.compare_exchange_weak(h, nh, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				Slot[i-1]->Clear();
+				return Slot[i-1];
+			}
+		}
+	}
+
+	void Put(FqBatch *b)
+	{
+		uint64_t h = Head.load(std::memory_order_relaxed), nh;
+		do
+		{
+			NextFree[b->Id].store((uint32_t)h, std::memory_order_relaxed);
+			nh = (((h >> 32) + 1) << 32) | (b->Id + 1);
+		} while (!Head.compare_exchange_weak(h, nh, std::memory_order_release, std::memory_order_relaxed));
+	}
+};
+
+#endif
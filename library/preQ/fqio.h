@@ -0,0 +1,562 @@
+/*
+== Block I/O of FASTQ files with an io_uring backend; update: 2026/10
+FqReader keeps FQIO_DEPTH aligned blocks of FQIO_BLOCK bytes in flight ahead of the parser
+and hands out lines like fgets; FqWriter queues full blocks of output and lets them be
+written while the next one fills. io_uring is used through its raw syscalls (no liburing);
+when it is not available (old kernel, seccomp, SQUAT_IO=read) both fall back to plain
+read/write of the same blocks.
+*/
+//=============================================================================
+#ifndef SQUAT_FQIO_H
+#define SQUAT_FQIO_H
+
+#include <stdio.h>
+#include <stdlib.h> // for getenv, posix_memalign
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define FQIO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#define FQIO_BLOCK (1<<20) // bytes per block
+#define FQIO_DEPTH 8 // blocks per file, all but the one being parsed in flight
+#define FQIO_ALIGN 4096
+#define FQIO_NO_LIMIT ((off_t)INT64_MAX)
+
+//=============================================================================
+// minimal io_uring: one submission and one completion at a time, user_data = block index
+struct URing
+{
+	int fd;
+#ifdef FQIO_URING
+	unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+	unsigned *cqHead, *cqTail, *cqMask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sqPtr, *cqPtr;
+	size_t sqSize, cqSize, sqeSize;
+#endif
+
+	URing() : fd(-1) {}
+
+	bool Init(unsigned entries)
+	{
+#ifdef FQIO_URING
+		const char *env = getenv("SQUAT_IO");
+		if (env != NULL && strcmp(env, "read") == 0)
+			return false;
+
+		struct io_uring_params p;
+		memset(&p, 0, sizeof(p));
+		fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+		if (fd < 0)
+			return false;
+
+		sqSize = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+		cqSize = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+		bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single)
+			sqSize = cqSize = (sqSize > cqSize ? sqSize : cqSize);
+		sqeSize = p.sq_entries*sizeof(struct io_uring_sqe);
+
+		sqPtr = mmap(NULL, sqSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		cqPtr = single ? sqPtr : mmap(NULL, cqSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		sqes = (struct io_uring_sqe *)mmap(NULL, sqeSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (sqPtr == MAP_FAILED || cqPtr == MAP_FAILED || (void *)sqes == MAP_FAILED)
+		{
+			close(fd);
+			fd = -1;
+			return false;
+		}
+
+		char *sq = (char *)sqPtr, *cq = (char *)cqPtr;
+		sqHead = (unsigned *)(sq + p.sq_off.head);
+		sqTail = (unsigned *)(sq + p.sq_off.tail);
+		sqMask = (unsigned *)(sq + p.sq_off.ring_mask);
+		sqArray = (unsigned *)(sq + p.sq_off.array);
+		cqHead = (unsigned *)(cq + p.cq_off.head);
+		cqTail = (unsigned *)(cq + p.cq_off.tail);
+		cqMask = (unsigned *)(cq + p.cq_off.ring_mask);
+		cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+		return true;
+#else
+		(void)entries;
+		return false;
+#endif
+	}
+
+	// queue one read or write and submit it
+	bool Submit(bool write, int fileFd, char *buf, size_t len, off_t off, int data)
+	{
+#ifdef FQIO_URING
+		unsigned tail = *sqTail;
+		unsigned idx = tail & *sqMask;
+		struct io_uring_sqe *sqe = &sqes[idx];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+		sqe->fd = fileFd;
+		sqe->addr = (uint64_t)(uintptr_t)buf;
+		sqe->len = (unsigned)len;
+		sqe->off = (uint64_t)off;
+		sqe->user_data = (uint64_t)data;
+		sqArray[idx] = idx;
+		__atomic_store_n(sqTail, tail+1, __ATOMIC_RELEASE);
+		while (syscall(__NR_io_uring_enter, fd, 1, 0, 0, NULL, 0) < 0)
+			if (errno != EINTR)
+				return false;
+		return true;
+#else
+		(void)write; (void)fileFd; (void)buf; (void)len; (void)off; (void)data;
+		return false;
+#endif
+	}
+
+	// reap one completion, waiting for it if none is there
+	bool Reap(int &data, int &res)
+	{
+#ifdef FQIO_URING
+		for (;;)
+		{
+			unsigned head = *cqHead;
+			if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+			{
+				struct io_uring_cqe *cqe = &cqes[head & *cqMask];
+				data = (int)cqe->user_data;
+				res = cqe->res;
+				__atomic_store_n(cqHead, head+1, __ATOMIC_RELEASE);
+				return true;
+			}
+			if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+				return false;
+		}
+#else
+		(void)data; (void)res;
+		return false;
+#endif
+	}
+
+	void Close()
+	{
+#ifdef FQIO_URING
+		if (fd < 0)
+			return;
+		munmap(sqes, sqeSize);
+		if (cqPtr != sqPtr)
+			munmap(cqPtr, cqSize);
+		munmap(sqPtr, sqSize);
+		close(fd);
+		fd = -1;
+#endif
+	}
+};
+
+//=============================================================================
+// blocks shared by the reader and the writer
+struct FqBlocks
+{
+	int fd;
+	bool uring;
+	URing ring;
+	char *Buf[FQIO_DEPTH];
+	size_t Len[FQIO_DEPTH]; // reader: bytes filled; writer: bytes queued
+	size_t Done[FQIO_DEPTH]; // writer: bytes written
+	off_t Off[FQIO_DEPTH]; // file offset of each block
+	bool Busy[FQIO_DEPTH]; // an operation of the block is in flight
+	int InFlight;
+	int Cur; // block being parsed or filled
+	off_t NextOff;
+	bool Err;
+
+	FqBlocks() : fd(-1), uring(false), InFlight(0), Cur(0), NextOff(0), Err(false)
+	{
+		for (int i=0; i < FQIO_DEPTH; i++)
+			Buf[i] = NULL;
+	}
+
+	bool Alloc()
+	{
+		for (int i=0; i < FQIO_DEPTH; i++)
+		{
+			if (posix_memalign((void **)&Buf[i], FQIO_ALIGN, FQIO_BLOCK) != 0)
+				return false;
+			Len[i] = Done[i] = 0;
+			Off[i] = 0;
+			Busy[i] = false;
+		}
+		return true;
+	}
+
+	void Free()
+	{
+		// nothing may still write into the blocks
+		int d, res;
+		while (uring && InFlight > 0 && ring.Reap(d, res))
+			InFlight--;
+		ring.Close();
+		uring = false;
+		for (int i=0; i < FQIO_DEPTH; i++)
+		{
+			free(Buf[i]);
+			Buf[i] = NULL;
+		}
+		if (fd >= 0)
+			close(fd);
+		fd = -1;
+	}
+
+	bool Submit(bool write, int i, char *buf, size_t len, off_t off)
+	{
+		if (!ring.Submit(write, fd, buf, len, off, i))
+			return false;
+		Busy[i] = true;
+		InFlight++;
+		return true;
+	}
+};
+
+//=============================================================================
+struct FqReader : FqBlocks
+{
+	bool Eof[FQIO_DEPTH]; // the read of the block reached the end of the file
+	size_t Pos; // parse position in Buf[Cur]
+	bool End;
+	off_t Limit; // no block is read from here on
+
+
+	bool Open(const char *fname)
+	{
+		fd = open(fname, O_RDONLY);
+		if (fd < 0 || !Alloc())
+			return false;
+#ifdef POSIX_FADV_SEQUENTIAL
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+		// reads at file offsets, several in flight, need a regular file: a pipe
+		// (e.g. readQdist <(zcat x.fq.gz) ...) is read in order with plain read
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+			uring = ring.Init(FQIO_DEPTH);
+		Start(0, FQIO_NO_LIMIT);
+		return true;
+	}
+
+	// continue at file offset off and read the blocks starting before off+len only,
+	// e.g. for one block of a triage sample (triage.h)
+	void Seek(off_t off, off_t len)
+	{
+		int d, res;
+		while (uring && InFlight > 0 && ring.Reap(d, res))
+			InFlight--;
+		InFlight = 0;
+		if (!uring)
+			lseek(fd, off, SEEK_SET);
+		Start(off, off + len);
+	}
+
+	// file offset of the next byte GetLine returns
+	off_t Tell() const
+	{
+		return Off[Cur] + (off_t)Pos;
+	}
+
+	const char *Backend() const
+	{
+		return uring ? "io_uring" : "read";
+	}
+
+	// a line with its '\n' into s, cut at size-1 bytes and NUL-terminated; its length, 0 at the end of the file
+	size_t GetLine(char *s, size_t size)
+	{
+		size_t n = 0;
+		while (n < size-1)
+		{
+			if (Pos == Len[Cur])
+			{
+				if (!Next())
+					break;
+				continue;
+			}
+			size_t avail = Len[Cur] - Pos;
+			if (avail > size-1-n)
+				avail = size-1-n;
+			char *p = Buf[Cur] + Pos;
+			char *nl = (char *)memchr(p, '\n', avail);
+			size_t k = nl ? (size_t)(nl-p+1) : avail;
+			memcpy(s+n, p, k);
+			n += k;
+			Pos += k;
+			if (nl != NULL)
+				break;
+		}
+		s[n] = '\0';
+		return n;
+	}
+
+	// the next n bytes in place, NULL if they are not all in the current block
+	const char *Peek(size_t n) const
+	{
+		return (Pos + n <= Len[Cur]) ? Buf[Cur] + Pos : NULL;
+	}
+
+	// the bytes already read from the parse position to the end of the current block
+	// (all of the first block after Open), e.g. for QEncoding::Detect
+	const char *Buffered(size_t &n) const
+	{
+		n = Len[Cur] - Pos;
+		return Buf[Cur] + Pos;
+	}
+
+	// past n bytes returned by Peek
+	void Skip(size_t n)
+	{
+		Pos += n;
+	}
+
+	// like fgets: NULL at the end of the file
+	char *Gets(char *s, int size)
+	{
+		return GetLine(s, size) ? s : NULL;
+	}
+
+	void Close()
+	{
+		Free();
+	}
+
+private:
+	void Start(off_t off, off_t limit)
+	{
+		Cur = 0;
+		Pos = 0;
+		End = false;
+		NextOff = off;
+		Limit = limit;
+		for (int i=0; i < FQIO_DEPTH; i++)
+		{
+			Busy[i] = Eof[i] = false;
+			Len[i] = 0;
+		}
+		if (uring)
+		{
+			for (int i=0; i < FQIO_DEPTH; i++)
+				Queue(i);
+			Wait(0);
+		}
+		else
+			Fill();
+	}
+
+	void Queue(int i)
+	{
+		Off[i] = NextOff;
+		NextOff += FQIO_BLOCK;
+		Len[i] = 0;
+		Eof[i] = false;
+		if (Off[i] >= Limit)
+		{
+			Eof[i] = true;
+			return;
+		}
+		if (!Submit(false, i, Buf[i], FQIO_BLOCK, Off[i]))
+		{
+			Err = true;
+			Eof[i] = true;
+		}
+	}
+
+	// until block i is full or at the end of the file; short reads are continued
+	void Wait(int i)
+	{
+		int d, res;
+		while (Busy[i])
+		{
+			if (!ring.Reap(d, res))
+			{
+				Err = true;
+				Busy[i] = false;
+				Eof[i] = true;
+				return;
+			}
+			InFlight--;
+			Busy[d] = false;
+			if (res < 0)
+			{
+				Err = true;
+				Eof[d] = true;
+			}
+			else if (res == 0)
+				Eof[d] = true;
+			else
+			{
+				Len[d] += res;
+				if (Len[d] < FQIO_BLOCK && !Submit(false, d, Buf[d]+Len[d], FQIO_BLOCK-Len[d], Off[d]+Len[d]))
+				{
+					Err = true;
+					Eof[d] = true;
+				}
+			}
+		}
+	}
+
+	// plain read of the next block
+	void Fill()
+	{
+		Off[Cur] = NextOff;
+		Len[Cur] = 0;
+		if (Off[Cur] >= Limit)
+			Eof[Cur] = true;
+		while (!Eof[Cur] && Len[Cur] < FQIO_BLOCK)
+		{
+			ssize_t r = read(fd, Buf[Cur]+Len[Cur], FQIO_BLOCK-Len[Cur]);
+			if (r < 0 && errno == EINTR)
+				continue;
+			if (r <= 0)
+			{
+				Err = (r < 0);
+				Eof[Cur] = true;
+				break;
+			}
+			Len[Cur] += r;
+		}
+		NextOff += Len[Cur];
+	}
+
+	// the current block is parsed: requeue it and move to the next one
+	bool Next()
+	{
+		if (End || Eof[Cur])
+		{
+			End = true;
+			return false;
+		}
+		Pos = 0;
+		if (!uring)
+		{
+			Fill();
+			End = (Len[Cur] == 0);
+			return !End;
+		}
+		Queue(Cur);
+		Cur = (Cur+1) % FQIO_DEPTH;
+		Wait(Cur);
+		End = (Len[Cur] == 0);
+		return !End;
+	}
+};
+
+//=============================================================================
+struct FqWriter : FqBlocks
+{
+	bool Open(const char *fname)
+	{
+		fd = open(fname, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+		if (fd < 0 || !Alloc())
+			return false;
+		uring = ring.Init(FQIO_DEPTH);
+		return true;
+	}
+
+	const char *Backend() const
+	{
+		return uring ? "io_uring" : "write";
+	}
+
+	void Write(const char *s, size_t n)
+	{
+		while (n > 0)
+		{
+			size_t k = FQIO_BLOCK - Len[Cur];
+			if (k > n)
+				k = n;
+			memcpy(Buf[Cur]+Len[Cur], s, k);
+			Len[Cur] += k;
+			s += k;
+			n -= k;
+			if (Len[Cur] == FQIO_BLOCK)
+				Flush();
+		}
+	}
+
+	// false if any write failed
+	bool Close()
+	{
+		Flush();
+		while (uring && InFlight > 0)
+			ReapOne();
+		if (fd >= 0 && close(fd) != 0)
+			Err = true;
+		fd = -1;
+		Free();
+		return !Err;
+	}
+
+private:
+	void ReapOne()
+	{
+		int d, res;
+		if (!ring.Reap(d, res))
+		{
+			Err = true;
+			InFlight = 0;
+			for (int i=0; i < FQIO_DEPTH; i++)
+				Busy[i] = false;
+			return;
+		}
+		InFlight--;
+		Busy[d] = false;
+		if (res <= 0)
+			Err = true;
+		else
+		{
+			Done[d] += res;
+			if (Done[d] < Len[d] && !Submit(true, d, Buf[d]+Done[d], Len[d]-Done[d], Off[d]+Done[d]))
+				Err = true;
+		}
+	}
+
+	// write out the current block and make the next one free to fill
+	void Flush()
+	{
+		if (Len[Cur] == 0)
+			return;
+		if (!uring)
+		{
+			for (size_t w=0; w < Len[Cur]; )
+			{
+				ssize_t r = write(fd, Buf[Cur]+w, Len[Cur]-w);
+				if (r < 0 && errno == EINTR)
+					continue;
+				if (r <= 0)
+				{
+					Err = true;
+					break;
+				}
+				w += r;
+			}
+			Len[Cur] = 0;
+			return;
+		}
+		Off[Cur] = NextOff;
+		NextOff += Len[Cur];
+		Done[Cur] = 0;
+		if (!Submit(true, Cur, Buf[Cur], Len[Cur], Off[Cur]))
+			Err = true;
+		Cur = (Cur+1) % FQIO_DEPTH;
+		while (Busy[Cur])
+			ReapOne();
+		Len[Cur] = 0;
+	}
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*
+== %HighQ(q) of reads for any set of Q thresholds and coverage cut points; update: 2026/10
+%HighQ(q) = #bases with quality value >= q / #bases of a read
+A read is counted once into its Q histogram; one cumulative pass over the bins
+then gives %HighQ for every threshold, so more thresholds add no per-base work.
+*/
+//=============================================================================
+#ifndef SQUAT_HIQ_H
+#define SQUAT_HIQ_H
+
+#include <stdio.h>
+#include <stdlib.h> // for atoi, atof
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm> // for sort
+
+#ifndef QSCORE_SIZE
+#define QSCORE_SIZE 42
+#endif
+#define HiQCellSize 200 // %HighQ histogram cells, 0.5% each
+#define HiQDefaultTh "15,20"
+#define HiQDefaultCut "100,95,90"
+
+//=============================================================================
+struct HiQStat
+{
+	std::vector<int> Th; // Q thresholds, ascending
+	std::vector<double> Cut; // coverage cut points in %, descending
+	std::vector< std::vector<size_t> > PercentCount; // [th][cell]: #reads by floor of %HighQ
+	std::vector< std::vector<size_t> > CutCount; // [th][cut]: #reads with %HighQ >= cut
+
+	// thresholds "15,20" (0-41), cut points "100,95,90" (0-100)
+	bool Init(const char *ThList, const char *CutList)
+	{
+		char buf[1024];
+		Th.clear();
+		Cut.clear();
+
+		snprintf(buf, sizeof(buf), "%s", ThList);
+		for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ","))
+		{
+			int q = atoi(tok);
+			if (q < 0 || q >= QSCORE_SIZE)
+			{
+				printf("HighQ threshold (%s) out of range 0-%d Error!\n", tok, QSCORE_SIZE-1);
+				return false;
+			}
+			Th.push_back(q);
+		}
+		snprintf(buf, sizeof(buf), "%s", CutList);
+		for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ","))
+		{
+			double c = atof(tok);
+			if (c < 0 || c > 100)
+			{
+				printf("HighQ cut point (%s) out of range 0-100 Error!\n", tok);
+				return false;
+			}
+			Cut.push_back(c);
+		}
+		if (Th.empty() || Cut.empty())
+		{
+			printf("Empty HighQ thresholds or cut points Error!\n");
+			return false;
+		}
+
+		std::sort(Th.begin(), Th.end());
+		Th.erase(std::unique(Th.begin(), Th.end()), Th.end());
+		std::sort(Cut.rbegin(), Cut.rend());
+		Cut.erase(std::unique(Cut.begin(), Cut.end()), Cut.end());
+
+		PercentCount.assign(Th.size(), std::vector<size_t>(HiQCellSize+1, 0));
+		CutCount.assign(Th.size(), std::vector<size_t>(Cut.size(), 0));
+		return true;
+	}
+
+	// %HighQ of every threshold as a fraction, from the Q histogram (n bins) of one read
+	void Fractions(const int QHist[], int n, size_t len, double frac[]) const
+	{
+		int cumu = 0, j = (int)Th.size()-1;
+		for (int q=n-1; q >= 0 && j >= 0; q--)
+		{
+			cumu += QHist[q];
+			for (; j >= 0 && Th[j] == q; j--)
+				frac[j] = (double)cumu / (double)len;
+		}
+	}
+
+	// count one read (or PE: the smaller fraction of its two reads)
+	void Count(const double frac[])
+	{
+		for (size_t j=0; j < Th.size(); j++)
+		{
+			// LowQ by ceil; HiQ by floor
+			PercentCount[j][(int)floor(HiQCellSize*frac[j])]++;
+			for (size_t c=0; c < Cut.size(); c++)
+				if (100.0*frac[j] + 1e-9 >= Cut[c])
+					CutCount[j][c]++;
+		}
+	}
+
+	// add the counts of a HiQStat with the same thresholds and cut points, e.g. of another thread
+	void Merge(const HiQStat &o)
+	{
+		for (size_t j=0; j < Th.size(); j++)
+		{
+			for (size_t i=0; i <= HiQCellSize; i++)
+				PercentCount[j][i] += o.PercentCount[j][i];
+			for (size_t c=0; c < Cut.size(); c++)
+				CutCount[j][c] += o.CutCount[j][c];
+		}
+	}
+
+	// counts times f, e.g. extrapolated from a sample to the whole file
+	void Scale(double f)
+	{
+		for (size_t j=0; j < Th.size(); j++)
+		{
+			for (size_t i=0; i <= HiQCellSize; i++)
+				PercentCount[j][i] = (size_t)llround(f*PercentCount[j][i]);
+			for (size_t c=0; c < Cut.size(); c++)
+				CutCount[j][c] = (size_t)llround(f*CutCount[j][c]);
+		}
+	}
+
+	// fraction of the n reads with %HighQ(Th[j]) >= Cut[c]
+	double Coverage(size_t j, size_t c, size_t n) const
+	{
+		return n ? (double)CutCount[j][c] / (double)n : 0.0;
+	}
+
+	// high-quality reads: the highest threshold at the highest cut, e.g. %HighQ(20) >= 100%
+	double High(size_t n) const
+	{
+		return Coverage(Th.size()-1, 0, n);
+	}
+
+	// poor-quality reads: fail the lowest threshold at the lowest cut, e.g. %HighQ(15) < 90%
+	double Poor(size_t n) const
+	{
+		return n ? 1.0 - Coverage(0, Cut.size()-1, n) : 0.0;
+	}
+
+	// metric key: highq20_95_pct, highq20_97_5_pct
+	static void Key(char *buf, int q, double cut)
+	{
+		sprintf(buf, "highq%d_%g_pct", q, cut);
+		for (char *p = buf; *p; p++)
+			if (*p == '.')
+				*p = '_';
+	}
+};
+
+#endif
@@ -0,0 +1,289 @@
+/*
+== Self-contained html of the preQ reports; update: 2026/10
+The page style, the navigation script and a small chart engine (inline svg,
+canvas for heat maps) are written into the report itself, so it opens offline;
+series are downsampled to at most HTM_MAX_POINTS points before they are written
+*/
+//=============================================================================
+#ifndef SQUAT_HTMCHART_H
+#define SQUAT_HTMCHART_H
+
+#include <stdio.h>
+#include <vector>
+#include <string>
+
+//=============================================================================
+#define HTM_MAX_POINTS 250
+
+static const char *HtmStyle = R"HTM(
+div.summary { width: 18em; position: fixed; top: 3em; margin: 1em 0 0 0; font-family: sans-serif; color: #800000; left: 0; }
+div.main { display: block; position: absolute; overflow: auto; height: auto; width: auto; top: 4.5em; bottom: 2.3em; left: 18em; right: 0; border-left: 1px solid #CCC; padding: 0 0 0 1em; background-color: white; z-index: 1; }
+div.header { background-color: #098bd4; border: 0; margin: 0; padding: 0.5em; font-size: 200%; font-weight: bold; color: white; position: fixed; width: 100%; top: 0; left: 0; z-index: 2; }
+#header_title { display: inline-block; float: left; clear: left; }
+#header_filename { display: inline-block; float: right; clear: right; font-size: 50%; margin-right: 2em; text-align: right; }
+#btpBtn { background-color: #50A1CB; color: white; z-index: 999; display: none; position: fixed; right: 20px; bottom: 20px; width: 100px; height: 100px; box-sizing: border-box; border-radius: 50%; border-width: 0; font-size: 1.5em; }
+#btpBtn:hover { background-color: #50cbad; }
+.ac-row, .ac-label { position: relative; padding: .5em 1em; display: block; cursor: pointer; transition: background-color .15s ease-in-out; font-size: 15px; color: black; font-weight: 700; background: #ccc; }
+.ac-label:after, .ac-input:checked + .ac-label:after { position: absolute; display: block; right: 0; top: 0; width: 2em; height: 100%; line-height: 2.25em; text-align: center; transition: background-color .15s ease-in-out; }
+.ac-row:hover, .ac-label:hover { background-color: #444; color: white; }
+.ac-input:checked + .ac-label { background-color: #444; color: white; }
+.ac-input:checked + .ac-label:after { transform: rotate(180deg); }
+.ac-label:after { content: "\25BC"; }
+.ac-input { display: none; }
+.ac-text { opacity: 0; height: 0; transition: opacity .5s ease-in-out; overflow: hidden; }
+.ac-input:checked ~ .ac-text { opacity: 1; height: auto; }
+.ac-input:checked ~ .ac-text > .ac-sub > .ac-row { background-color: #999; }
+.sqchart svg { display: block; width: 100%; height: auto; }
+.sqchart canvas { display: block; width: 100%; image-rendering: pixelated; }
+.sqtitle { font-family: sans-serif; font-weight: bold; font-size: 15px; margin: 4px 0; }
+)HTM";
+
+static const char *HtmScript = R"HTM(
+window.onscroll = function() {scrollFunction()};
+
+function scrollFunction() {
+  if (!document.getElementById("main"))
+    return;
+  if (document.getElementById("main").scrollTop > 20 || document.documentElement.scrollTop > 20) {
+    document.getElementById("btpBtn").style.display = "block";
+  } else {
+    document.getElementById("btpBtn").style.display = "none";
+  }
+}
+
+// When the user clicks on the button, scroll to the top of the document
+function topFunction() {
+  document.getElementById("main").scrollTop = 0;
+  document.documentElement.scrollTop = 0;
+}
+
+//href function
+function link(href){
+  window.location.href = href;
+}
+
+// --- chart engine: column/area/line/pie charts as svg, heat maps on a canvas
+var SqColors = ['#3366cc', '#dc3912', '#ff9900', '#109618', '#990099', '#0099c6'];
+
+function SqEsc(s) {
+  return String(s).replace(/&/g, '&amp;').replace(/</g, '&lt;').replace(/>/g, '&gt;');
+}
+
+function SqText(x, y, s, a) {
+  return '<text x="' + x.toFixed(1) + '" y="' + y.toFixed(1) + '" ' + (a || '') + '>' + SqEsc(s) + '</text>';
+}
+
+function SqSvg(w, h, s) {
+  return '<svg xmlns="http://www.w3.org/2000/svg" viewBox="0 0 ' + w + ' ' + h + '" font-family="sans-serif" font-size="12">' + s + '</svg>';
+}
+
+// about n round values from lo to hi
+function SqTicks(lo, hi, n) {
+  var raw = (hi - lo) / n, mag = Math.pow(10, Math.floor(Math.log10(raw))), r = raw / mag;
+  var step = (r < 1.5 ? 1 : r < 3 ? 2 : r < 7 ? 5 : 10) * mag, t = [];
+  for (var v = Math.ceil(lo / step - 1e-9) * step; v <= hi + step * 1e-9; v += step)
+    t.push(parseFloat(v.toPrecision(6)));
+  return t;
+}
+
+function SqFmt(v, o) {
+  return o.percent ? parseFloat((v * 100).toPrecision(4)) + '%' : String(parseFloat(v.toPrecision(4)));
+}
+
+function SqPie(o, names, v, colors) {
+  var cx = 200, cy = 180, r = 130, a0 = -Math.PI / 2, total = 0, s = SqText(10, 22, o.title || '', 'font-size="18"');
+  v.forEach(function(f) { total += f; });
+  total = total || 1;
+  v.forEach(function(f, i) {
+    var a1 = a0 + 2 * Math.PI * f / total, c = colors[i % colors.length], tip = '<title>' + SqEsc(names[i]) + ': ' + (100 * f / total).toFixed(1) + '%</title>';
+    if (f >= total)
+      s += '<circle cx="' + cx + '" cy="' + cy + '" r="' + r + '" fill="' + c + '">' + tip + '</circle>';
+    else if (f > 0)
+      s += '<path d="M' + cx + ',' + cy + 'L' + (cx + r * Math.cos(a0)).toFixed(2) + ',' + (cy + r * Math.sin(a0)).toFixed(2) +
+        'A' + r + ',' + r + ' 0 ' + (a1 - a0 > Math.PI ? 1 : 0) + ' 1 ' + (cx + r * Math.cos(a1)).toFixed(2) + ',' + (cy + r * Math.sin(a1)).toFixed(2) +
+        'Z" fill="' + c + '" stroke="white">' + tip + '</path>';
+    s += '<rect x="380" y="' + (120 + 24 * i) + '" width="14" height="14" fill="' + c + '"/>';
+    s += SqText(400, 132 + 24 * i, names[i] + ' (' + (100 * f / total).toFixed(1) + '%)');
+    a0 = a1;
+  });
+  return SqSvg(700, 340, s);
+}
+
+// o: type (column, area, line or pie), title, xTitle, yTitle, colors, xMin, xMax, reverse, percent
+function SqChart(id, o, x, ys, names) {
+  var el = document.getElementById(id);
+  if (!el)
+    return;
+  el.className += ' sqchart';
+  var colors = o.colors || SqColors;
+  if (o.type == 'pie') {
+    el.innerHTML = SqPie(o, names, ys[0], colors);
+    return;
+  }
+
+  var W = 900, H = 320, L = 70, R = 150, T = 34, B = 48, s = '';
+  var xmin = 'xMin' in o ? o.xMin : Math.min.apply(null, x), xmax = 'xMax' in o ? o.xMax : Math.max.apply(null, x), ymax = 0;
+  ys.forEach(function(y) {
+    y.forEach(function(v, i) { if (x[i] >= xmin && x[i] <= xmax) ymax = Math.max(ymax, v); });
+  });
+  ymax = ymax * 1.05 || 1;
+  if (xmax <= xmin)
+    xmax = xmin + 1;
+  var ticks = SqTicks(xmin, xmax, 10);
+  if (o.type == 'column') {
+    xmin -= 0.5;
+    xmax += 0.5;
+  }
+  var px = function(v) { var f = (v - xmin) / (xmax - xmin); return L + (o.reverse ? 1 - f : f) * (W - L - R); };
+  var py = function(v) { return T + (1 - v / ymax) * (H - T - B); };
+
+  SqTicks(0, ymax, 5).forEach(function(v) {
+    s += '<line x1="' + L + '" y1="' + py(v).toFixed(1) + '" x2="' + (W - R) + '" y2="' + py(v).toFixed(1) + '" stroke="#ddd"/>';
+    s += SqText(L - 6, py(v) + 4, SqFmt(v, o), 'text-anchor="end"');
+  });
+  ticks.forEach(function(v) {
+    s += SqText(px(v), H - B + 16, v, 'text-anchor="middle"');
+  });
+  s += '<line x1="' + L + '" y1="' + py(0).toFixed(1) + '" x2="' + (W - R) + '" y2="' + py(0).toFixed(1) + '" stroke="black"/>';
+
+  ys.forEach(function(y, k) {
+    var c = colors[k % colors.length], pts = [], dots = '';
+    var w = Math.max((W - L - R) / (xmax - xmin) * 0.8 / ys.length, 1);
+    x.forEach(function(v, i) {
+      if (v < xmin || v > xmax)
+        return;
+      var tip = '<title>' + SqEsc(names[k]) + ' @ ' + v + ': ' + SqFmt(y[i], o) + '</title>';
+      if (o.type == 'column')
+        s += '<rect x="' + (px(v) - w * ys.length / 2 + w * k).toFixed(1) + '" y="' + py(y[i]).toFixed(1) + '" width="' + w.toFixed(1) + '" height="' + (py(0) - py(y[i])).toFixed(1) + '" fill="' + c + '">' + tip + '</rect>';
+      else {
+        pts.push(px(v).toFixed(1) + ',' + py(y[i]).toFixed(1));
+        dots += '<circle cx="' + px(v).toFixed(1) + '" cy="' + py(y[i]).toFixed(1) + '" r="4" fill="' + c + '" fill-opacity="0">' + tip + '</circle>';
+      }
+    });
+    if (pts.length) {
+      if (o.type == 'area')
+        s += '<polygon points="' + pts[0].split(',')[0] + ',' + py(0).toFixed(1) + ' ' + pts.join(' ') + ' ' + pts[pts.length - 1].split(',')[0] + ',' + py(0).toFixed(1) + '" fill="' + c + '" fill-opacity="0.3"/>';
+      s += '<polyline points="' + pts.join(' ') + '" fill="none" stroke="' + c + '" stroke-width="2"/>' + dots;
+    }
+    s += '<rect x="' + (W - R + 14) + '" y="' + (T + 6 + 20 * k) + '" width="12" height="12" fill="' + c + '"/>';
+    s += SqText(W - R + 32, T + 16 + 20 * k, names[k]);
+  });
+
+  s += SqText(L, 20, o.title || '', 'font-size="15" font-weight="bold"');
+  s += SqText((L + W - R) / 2, H - 8, o.xTitle || '', 'text-anchor="middle"');
+  s += SqText(16, (T + H - B) / 2, o.yTitle || '', 'text-anchor="middle" transform="rotate(-90 16 ' + ((T + H - B) / 2) + ')"');
+  el.innerHTML = SqSvg(W, H, s);
+}
+
+// m[row][col]; below zero in red, above zero in blue, saturated at +-o.range
+function SqHeat(id, o, x, rows, m) {
+  var el = document.getElementById(id);
+  if (!el || !rows.length)
+    return;
+  el.className += ' sqchart';
+  var w = x.length, h = rows.length;
+  el.innerHTML = '<div class="sqtitle">' + SqEsc(o.title || '') + '</div><canvas width="' + w + '" height="' + h + '" style="height:' + Math.min(Math.max(h * 6, 120), 480) + 'px"></canvas><div>' + SqEsc(o.note || '') + '</div>';
+  var cv = el.getElementsByTagName('canvas')[0], ctx = cv.getContext('2d'), img = ctx.createImageData(w, h);
+  for (var r = 0; r < h; r++) {
+    for (var c = 0; c < w; c++) {
+      var v = Math.max(-1, Math.min(1, m[r][c] / o.range)), p = 4 * (r * w + c);
+      img.data[p] = v < 0 ? 255 : 255 * (1 - v);
+      img.data[p + 1] = 255 * (1 - Math.abs(v));
+      img.data[p + 2] = v > 0 ? 255 : 255 * (1 + v);
+      img.data[p + 3] = 255;
+    }
+  }
+  ctx.putImageData(img, 0, 0);
+  cv.onmousemove = function(e) {
+    var b = cv.getBoundingClientRect(), c = Math.floor((e.clientX - b.left) / b.width * w), r = Math.floor((e.clientY - b.top) / b.height * h);
+    if (r >= 0 && r < h && c >= 0 && c < w)
+      cv.title = (o.rowTitle || '') + ' ' + rows[r] + ', ' + (o.xTitle || '') + ' ' + x[c] + ': ' + m[r][c].toFixed(2);
+  };
+}
+)HTM";
+
+//=============================================================================
+// <head> of a report: inline style (plus the page's own) and scripts
+inline void HtmHead(FILE *fp, const char *title, const char *style)
+{
+	fprintf(fp, "<html>\n<head>\n  <meta charset=\"utf-8\">\n  <title>%s</title>\n", title);
+	fprintf(fp, "<style>%s%s</style>\n", HtmStyle, style);
+	fprintf(fp, "<script type=\"text/javascript\">%s</script>\n", HtmScript);
+	fprintf(fp, "</head>\n\n");
+}
+
+// Average consecutive points so that at most maxPts are left
+inline void HtmDownsample(std::vector<double> &x, std::vector< std::vector<double> > &ys, size_t maxPts)
+{
+	if (x.size() <= maxPts)
+		return;
+
+	size_t step = (x.size() + maxPts - 1) / maxPts;
+	std::vector<double> nx;
+	std::vector< std::vector<double> > nys(ys.size());
+	for (size_t i=0; i<x.size(); i+=step)
+	{
+		size_t end = (i+step < x.size()) ? i+step : x.size();
+		double sx = 0;
+		for (size_t j=i; j<end; j++)
+			sx += x[j];
+		nx.push_back(sx/(end-i));
+		for (size_t k=0; k<ys.size(); k++)
+		{
+			double sy = 0;
+			for (size_t j=i; j<end; j++)
+				sy += ys[k][j];
+			nys[k].push_back(sy/(end-i));
+		}
+	}
+	x.swap(nx);
+	ys.swap(nys);
+}
+
+inline void HtmArray(FILE *fp, const std::vector<double> &v)
+{
+	fprintf(fp, "[");
+	for (size_t i=0; i<v.size(); i++)
+	{
+		fprintf(fp, (i ? ",%.5g" : "%.5g"), v[i]);
+		if (i % 20 == 19)
+			fprintf(fp, "\n");
+	}
+	fprintf(fp, "]");
+}
+
+// SqChart() call of one chart; opt is the body of the options object, names a js array of the series names
+inline void HtmChart(FILE *fp, const char *id, const char *opt, std::vector<double> x, std::vector< std::vector<double> > ys, const char *names)
+{
+	HtmDownsample(x, ys, HTM_MAX_POINTS);
+	fprintf(fp, "  SqChart('%s', {%s},\n  ", id, opt);
+	HtmArray(fp, x);
+	fprintf(fp, ",\n  [");
+	for (size_t k=0; k<ys.size(); k++)
+	{
+		if (k)
+			fprintf(fp, ",\n  ");
+		HtmArray(fp, ys[k]);
+	}
+	fprintf(fp, "], %s);\n\n", names);
+}
+
+// SqHeat() call of a heat map, m[row][col] with one column per x
+inline void HtmHeatmap(FILE *fp, const char *id, const char *opt, const std::vector<double> &x, const std::vector<std::string> &rows, const std::vector< std::vector<double> > &m)
+{
+	fprintf(fp, "  SqHeat('%s', {%s},\n  ", id, opt);
+	HtmArray(fp, x);
+	fprintf(fp, ",\n  [");
+	for (size_t r=0; r<rows.size(); r++)
+		fprintf(fp, (r ? ",'%s'" : "'%s'"), rows[r].c_str());
+	fprintf(fp, "],\n  [");
+	for (size_t r=0; r<m.size(); r++)
+	{
+		if (r)
+			fprintf(fp, ",\n  ");
+		HtmArray(fp, m[r]);
+	}
+	fprintf(fp, "]);\n\n");
+}
+
+#endif
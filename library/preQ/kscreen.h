@@ -0,0 +1,154 @@
+/*
+== Contamination screen of reads against a few small references; update: 2026/10
+Each reference FASTA (PhiX, E. coli, a vector, ...) is one contaminant, named after its file.
+Their minimizers (minimizer.h) go into one open-addressing table of hash -> contaminant,
+minimizers of more than one contaminant being marked shared. A read hits the contaminant
+with the most of its minimizers in the table if that is at least KS_MIN_HITS; the table is
+only read while screening, so all worker threads share it.
+*/
+//=============================================================================
+#ifndef SQUAT_KSCREEN_H
+#define SQUAT_KSCREEN_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <algorithm> // for sort
+#include "minimizer.h"
+
+#define KS_MAX_REFS 64
+#define KS_MIN_HITS 2 // minimizers of a read in one contaminant
+#define KS_SHARED 0xFFFF // a minimizer of more than one contaminant
+
+//=============================================================================
+struct KScreen
+{
+	std::vector<std::string> Names; // of the contaminants
+	std::vector<uint64_t> Key; // minimizer hash + 1, 0: empty slot
+	std::vector<uint16_t> Ref; // contaminant of the slot
+	uint64_t Mask; // slots - 1
+	size_t Bases; // of all references
+
+	// comma-separated FASTA files; false with a message if one cannot be read
+	bool Load(const char *list)
+	{
+		std::vector< std::pair<uint64_t, uint16_t> > all;
+		std::vector<Minimizer> mz;
+		char buf[1024];
+		Bases = 0;
+		snprintf(buf, sizeof(buf), "%s", list);
+		for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ","))
+		{
+			if (Names.size() == KS_MAX_REFS)
+			{
+				printf("More than %d screen references Error!\n", KS_MAX_REFS);
+				return false;
+			}
+			FILE *fp = fopen(tok, "rt");
+			if (fp == NULL)
+			{
+				printf("Open screen reference (%s) Error!\n", tok);
+				return false;
+			}
+			uint16_t id = (uint16_t)Names.size();
+			Names.push_back(RefName(tok));
+
+			// every sequence of the file, sketched when the next header or the end comes
+			std::string seq;
+			char line[4096];
+			for (bool more = true; more; )
+			{
+				more = (fgets(line, sizeof(line), fp) != NULL);
+				if (!more || line[0] == '>')
+				{
+					MzSketch(seq.c_str(), seq.size(), mz);
+					for (size_t i=0; i<mz.size(); i++)
+						all.push_back(std::make_pair(mz[i].Hash, id));
+					Bases += seq.size();
+					seq.clear();
+					continue;
+				}
+				size_t n = strcspn(line, "\r\n");
+				seq.append(line, n);
+			}
+			fclose(fp);
+		}
+
+		// one slot per minimizer, at most half of the table in use
+		std::sort(all.begin(), all.end());
+		size_t slots = 1024;
+		while (slots < 2*all.size())
+			slots <<= 1;
+		Key.assign(slots, 0);
+		Ref.assign(slots, 0);
+		Mask = slots - 1;
+		for (size_t i=0; i<all.size(); )
+		{
+			size_t j = i;
+			uint16_t id = all[i].second;
+			for (; j<all.size() && all[j].first == all[i].first; j++)
+				if (all[j].second != id)
+					id = KS_SHARED;
+			size_t s = Slot(all[i].first);
+			Key[s] = all[i].first + 1;
+			Ref[s] = id;
+			i = j;
+		}
+		return true;
+	}
+
+	// contaminant of a minimizer hash, -1 if none or shared
+	int Find(uint64_t hash) const
+	{
+		size_t s = Slot(hash);
+		return (Key[s] == hash + 1 && Ref[s] != KS_SHARED) ? Ref[s] : -1;
+	}
+
+	// contaminant a read hits, -1 if none; mz: a buffer of the caller (one per thread)
+	int Classify(const char *seq, size_t len, std::vector<Minimizer> &mz) const
+	{
+		int hits[KS_MAX_REFS] = {0};
+		MzSketch(seq, len, mz);
+		for (size_t i=0; i<mz.size(); i++)
+		{
+			int r = Find(mz[i].Hash);
+			if (r >= 0)
+				hits[r]++;
+		}
+		int best = -1;
+		for (int r=0; r<(int)Names.size(); r++)
+			if (hits[r] >= KS_MIN_HITS && (best < 0 || hits[r] > hits[best]))
+				best = r;
+		return best;
+	}
+
+	// metric-friendly name of a reference file: "dir/PhiX-174.fa" -> "phix_174"
+	static std::string RefName(const char *fname)
+	{
+		const char *b = strrchr(fname, '/');
+		std::string name = b ? b+1 : fname;
+		size_t dot = name.find('.');
+		if (dot != std::string::npos && dot > 0)
+			name.erase(dot);
+		for (size_t i=0; i<name.size(); i++)
+		{
+			char c = name[i];
+			name[i] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ? c : '_');
+		}
+		return name;
+	}
+
+private:
+	// the slot of hash, or the empty one where it would go (linear probing)
+	size_t Slot(uint64_t hash) const
+	{
+		size_t s = (size_t)(hash * 0x9E3779B97F4A7C15ULL >> 20) & Mask;
+		while (Key[s] != 0 && Key[s] != hash + 1)
+			s = (s + 1) & Mask;
+		return s;
+	}
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+== Machine-readable metrics of the native tools; update: 2026/10
+Writes outPrjName.metrics.json and outPrjName.metrics.tsv in the same pass as the report.
+Keys are flat snake_case names, written in the order they were added; percentages end
+with _pct (0-100). METRICS_VERSION is bumped whenever a key is renamed, removed or
+changes meaning, so collectors can aggregate runs of one version blindly.
+*/
+//=============================================================================
+#ifndef SQUAT_METRICS_H
+#define SQUAT_METRICS_H
+
+#include <stdio.h>
+#include <math.h> // for NAN
+#include <string>
+#include <vector>
+#include <utility>
+
+#define METRICS_VERSION 1
+
+//=============================================================================
+struct Metrics
+{
+	std::string tool, input;
+	std::vector< std::pair<std::string, std::string> > items; // key, value (already formatted)
+
+	Metrics(const char *toolName, const char *inputName) : tool(toolName), input(inputName) {}
+
+	void AddInt(const char *key, size_t value)
+	{
+		char buf[64];
+		sprintf(buf, "%lu", value);
+		items.push_back(std::make_pair(std::string(key), std::string(buf)));
+	}
+
+	void AddReal(const char *key, double value)
+	{
+		char buf[64];
+		if (value != value) // NaN, e.g. a ratio of an empty input
+			sprintf(buf, "null");
+		else
+			sprintf(buf, "%.4f", value);
+		items.push_back(std::make_pair(std::string(key), std::string(buf)));
+	}
+
+	void AddPct(const char *key, double num, double den)
+	{
+		AddReal(key, den > 0 ? 100.0*num/den : NAN);
+	}
+
+	// JSON string body; inputs are file names, so only quotes, backslashes and controls
+	static std::string Escape(const std::string &s)
+	{
+		std::string ret;
+		for (size_t i=0; i < s.size(); i++)
+		{
+			if (s[i] == '"' || s[i] == '\\')
+				ret += '\\';
+			if ((unsigned char)s[i] < 0x20)
+				ret += ' ';
+			else
+				ret += s[i];
+		}
+		return ret;
+	}
+
+	bool Write(const char *outPrjName) const
+	{
+		char fname[1024];
+		FILE *fp;
+
+		sprintf(fname, "%s.metrics.json", outPrjName);
+		fp = fopen(fname, "wt");
+		if (fp == NULL)
+		{
+			printf("Open OUT metrics File (%s) Error!\n", fname);
+			return false;
+		}
+		fprintf(fp, "{\n  \"format\": \"squat-metrics\",\n  \"version\": %d,\n", METRICS_VERSION);
+		fprintf(fp, "  \"tool\": \"%s\",\n  \"input\": \"%s\",\n  \"metrics\": {", tool.c_str(), Escape(input).c_str());
+		for (size_t i=0; i < items.size(); i++)
+			fprintf(fp, "%s\n    \"%s\": %s", i ? "," : "", items[i].first.c_str(), items[i].second.c_str());
+		fprintf(fp, "\n  }\n}\n");
+		fclose(fp);
+
+		sprintf(fname, "%s.metrics.tsv", outPrjName);
+		fp = fopen(fname, "wt");
+		if (fp == NULL)
+		{
+			printf("Open OUT metrics File (%s) Error!\n", fname);
+			return false;
+		}
+		fprintf(fp, "metric\tvalue\n");
+		fprintf(fp, "format\tsquat-metrics\nversion\t%d\ntool\t%s\ninput\t%s\n", METRICS_VERSION, tool.c_str(), input.c_str());
+		for (size_t i=0; i < items.size(); i++)
+			fprintf(fp, "%s\t%s\n", items[i].first.c_str(), items[i].second.c_str());
+		fclose(fp);
+
+		return true;
+	}
+};
+
+#endif
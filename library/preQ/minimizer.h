@@ -0,0 +1,98 @@
+/*
+== Minimizers of DNA sequences; update: 2026/10
+Of every w consecutive canonical k-mers (the smaller of a k-mer and its reverse complement)
+the one with the smallest hash is kept, so two sequences sharing a stretch of at least
+w+k-1 bases share a minimizer there, and an index of a reference needs about 2/(w+1) of its
+k-mers. k-mers with N are skipped, and so are palindromic ones, which have no strand.
+*/
+//=============================================================================
+#ifndef SQUAT_MINIMIZER_H
+#define SQUAT_MINIMIZER_H
+
+#include <stdint.h>
+#include <vector>
+
+#define MZ_K 21 // k-mer length, at most 32
+#define MZ_W 11 // k-mers per window
+#define MZ_MAX_W 64
+
+//=============================================================================
+struct Minimizer
+{
+	uint64_t Hash;
+	uint32_t Pos; // of the last base of the k-mer
+	bool Rev; // the canonical k-mer is the reverse complement
+};
+
+// 2-bit code of a base, 4 for N and anything else
+inline int MzCode(char c)
+{
+	switch (c)
+	{
+	case 'A': case 'a': return 0;
+	case 'C': case 'c': return 1;
+	case 'G': case 'g': return 2;
+	case 'T': case 't': return 3;
+	default: return 4;
+	}
+}
+
+// invertible integer hash of the k-mer codes (Thomas Wang's), so minimizers are spread evenly
+inline uint64_t MzHash(uint64_t key, uint64_t mask)
+{
+	key = (~key + (key << 21)) & mask;
+	key = key ^ key >> 24;
+	key = ((key + (key << 3)) + (key << 8)) & mask;
+	key = key ^ key >> 14;
+	key = ((key + (key << 2)) + (key << 4)) & mask;
+	key = key ^ key >> 28;
+	key = (key + (key << 31)) & mask;
+	return key;
+}
+
+// the minimizers of seq[0, len), in order of position, each one once
+inline void MzSketch(const char *seq, size_t len, std::vector<Minimizer> &out, int k = MZ_K, int w = MZ_W)
+{
+	const uint64_t mask = (k < 32) ? (1ULL << (2*k)) - 1 : ~0ULL;
+	const int shift = 2*(k-1);
+	uint64_t fwd = 0, rev = 0;
+	int run = 0; // bases since the last N
+	Minimizer win[MZ_MAX_W]; // the last w k-mers, circular; Hash ~0 for none
+	Minimizer none = {~0ULL, 0, false};
+	for (int i=0; i<w; i++)
+		win[i] = none;
+	out.clear();
+	for (size_t i=0; i<len; i++)
+	{
+		int c = MzCode(seq[i]);
+		Minimizer m = none;
+		if (c < 4)
+		{
+			fwd = ((fwd << 2) | (uint64_t)c) & mask;
+			rev = (rev >> 2) | ((uint64_t)(3-c) << shift);
+			if (++run >= k && fwd != rev)
+			{
+				m.Rev = rev < fwd;
+				m.Hash = MzHash(m.Rev ? rev : fwd, mask);
+				m.Pos = (uint32_t)i;
+			}
+		}
+		else
+			run = 0;
+		win[i % w] = m;
+		if (i + 1 < (size_t)(k + w - 1)) // the first window is not full yet
+			continue;
+		// the smallest hash of the window, the leftmost of equal ones
+		Minimizer best = none;
+		for (int j=1; j<=w; j++)
+		{
+			const Minimizer &x = win[(i + j) % w];
+			if (x.Hash < best.Hash)
+				best = x;
+		}
+		if (best.Hash != ~0ULL && (out.empty() || out.back().Pos != best.Pos))
+			out.push_back(best);
+	}
+}
+
+#endif
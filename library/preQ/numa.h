@@ -0,0 +1,128 @@
+/*
+== NUMA placement of worker threads and buffers; update: 2026/10
+Nodes and their CPUs are read from /sys/devices/system/node (no libnuma). Worker w of n
+belongs to node w*nodes/n, so every node runs one contiguous group of workers. A worker
+pinned to its node first-touches its own accumulator there, and the arenas of the batches
+a node's workers read are bound to that node with mbind. Machines with one node (or no
+sysfs) run as one node and nothing is pinned.
+*/
+//=============================================================================
+#ifndef SQUAT_NUMA_H
+#define SQUAT_NUMA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#define NUMA_MAX_NODES 64
+#define NUMA_MPOL_PREFERRED 1 // MPOL_PREFERRED of <numaif.h>
+
+//=============================================================================
+struct NumaTopo
+{
+	std::vector< std::vector<int> > Cpus; // CPUs of each node with CPUs
+	std::vector<int> Id; // sysfs node number of each of them
+
+	// "0-3,8,10-11" -> 0 1 2 3 8 10 11
+	static std::vector<int> ParseList(const char *s)
+	{
+		std::vector<int> ret;
+		while (*s)
+		{
+			char *end;
+			long a = strtol(s, &end, 10), b;
+			if (end == s)
+				break;
+			b = a;
+			if (*end == '-')
+			{
+				s = end + 1;
+				b = strtol(s, &end, 10);
+			}
+			for (long c=a; c <= b; c++)
+				ret.push_back((int)c);
+			s = (*end == ',') ? end + 1 : end;
+		}
+		return ret;
+	}
+
+	void Detect()
+	{
+		Cpus.clear();
+		Id.clear();
+		for (int node=0; node < NUMA_MAX_NODES; node++)
+		{
+			char fname[128], buf[4096];
+			sprintf(fname, "/sys/devices/system/node/node%d/cpulist", node);
+			FILE *fp = fopen(fname, "rt");
+			if (fp == NULL)
+				continue;
+			if (fgets(buf, sizeof(buf), fp) != NULL)
+			{
+				std::vector<int> cpus = ParseList(buf);
+				if (!cpus.empty()) // memory-only nodes run no workers
+				{
+					Cpus.push_back(cpus);
+					Id.push_back(node);
+				}
+			}
+			fclose(fp);
+		}
+		if (Cpus.empty())
+		{
+			Cpus.push_back(std::vector<int>()); // one node, unpinned
+			Id.push_back(0);
+		}
+	}
+
+	int Nodes() const
+	{
+		return (int)Cpus.size();
+	}
+
+	// node of worker w of n
+	int NodeOf(int w, int n) const
+	{
+		return (int)((long)w * Nodes() / n);
+	}
+
+	// the calling thread on the CPUs of node k; false if not pinned
+	bool Pin(int k) const
+	{
+#ifdef __linux__
+		if (Nodes() < 2 || Cpus[k].empty())
+			return false;
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (size_t i=0; i < Cpus[k].size(); i++)
+			if (Cpus[k][i] < CPU_SETSIZE)
+				CPU_SET(Cpus[k][i], &set);
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+		(void)k;
+		return false;
+#endif
+	}
+
+	// pages of [addr, addr+len) preferably from node k; before they are first touched
+	void Bind(void *addr, size_t len, int k) const
+	{
+#if defined(__linux__) && defined(SYS_mbind)
+		if (Nodes() < 2)
+			return;
+		unsigned long mask[NUMA_MAX_NODES/(8*sizeof(unsigned long)) + 1] = {0};
+		mask[Id[k] / (8*sizeof(unsigned long))] |= 1UL << (Id[k] % (8*sizeof(unsigned long)));
+		syscall(SYS_mbind, addr, len, NUMA_MPOL_PREFERRED, mask, (unsigned long)NUMA_MAX_NODES+1, 0);
+#else
+		(void)addr; (void)len; (void)k;
+#endif
+	}
+};
+
+#endif
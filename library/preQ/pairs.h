@@ -0,0 +1,233 @@
+/*
+== Concordance of the two reads of PEs; update: 2026/10
+MateNameHash hashes a read name up to its first blank and without a trailing /1 or /2, so
+the mates "@x/1" "@x/2" or "@x 1:N:0:1" "@x 2:N:0:1" hash alike and R1 and R2 files out of
+step show up as pairs with different hashes. MateOverlap finds where R1 overlaps the reverse
+complement of R2, which happens when the insert is shorter than the two reads together and
+then gives its size; the reads are packed 2 bits per base and every shift is compared 32 bases
+per word. PairStat counts both, with a histogram of the insert sizes found, and mates of very
+different quality, per pair as the batches go by, so nothing needs a second pass.
+*/
+//=============================================================================
+#ifndef SQUAT_PAIRS_H
+#define SQUAT_PAIRS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "fqbatch.h"
+
+#define PAIR_MIN_OVERLAP 20 // bases
+#define PAIR_MAX_MISMATCH 0.1 // mismatches per overlapping base
+#define PAIR_QDIFF 10 // mates whose Phred means differ by this much are discordant
+#define PAIR_MAX_LEN 1000 // longer reads are not searched for an overlap
+#define PAIR_WORDS (PAIR_MAX_LEN/32+2)
+
+//=============================================================================
+// FNV-1a of the name without '@', up to the first blank, without a trailing /1 or /2
+inline uint64_t MateNameHash(const char *name, size_t len)
+{
+	size_t b = (len > 0 && name[0] == '@') ? 1 : 0, e = b;
+	while (e < len && name[e] != ' ' && name[e] != '\t')
+		e++;
+	if (e-b >= 2 && name[e-2] == '/' && (name[e-1] == '1' || name[e-1] == '2'))
+		e -= 2;
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (size_t i=b; i<e; i++)
+	{
+		h ^= (unsigned char)name[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+//=============================================================================
+// a read packed for bit-parallel comparison: 2 bits per base (A 0, C 1, G 2, T 3), 32 bases
+// per word, and a mask with both bits set for N and anything else; the words past the read are 0
+struct PackedSeq
+{
+	uint64_t Base[PAIR_WORDS], NMask[PAIR_WORDS];
+	size_t Len;
+
+	// seq, or its reverse complement
+	void Pack(const char *seq, size_t len, bool revcomp)
+	{
+		Len = len;
+		memset(Base, 0, sizeof(uint64_t)*(len/32+2));
+		memset(NMask, 0, sizeof(uint64_t)*(len/32+2));
+		for (size_t i=0; i<len; i++)
+		{
+			char c = revcomp ? seq[len-1-i] : seq[i];
+			uint64_t code;
+			switch (c)
+			{
+			case 'A': code = 0; break;
+			case 'C': code = 1; break;
+			case 'G': code = 2; break;
+			case 'T': code = 3; break;
+			default: NMask[i/32] |= 3ULL << (2*(i%32)); continue;
+			}
+			Base[i/32] |= (revcomp ? 3-code : code) << (2*(i%32));
+		}
+	}
+
+	// 32 bases from base k, as one word
+	static uint64_t Word(const uint64_t w[], size_t k)
+	{
+		size_t i = k/32, sh = 2*(k%32);
+		return sh ? (w[i] >> sh) | (w[i+1] << (64-sh)) : w[i];
+	}
+};
+
+// mismatches of a[from, from+n) and b[from2, from2+n), N matching nothing; stops above maxMis
+inline size_t PackedMismatch(const PackedSeq &a, size_t from, const PackedSeq &b, size_t from2, size_t n, size_t maxMis)
+{
+	const uint64_t lo = 0x5555555555555555ULL; // the low bit of every base
+	size_t mis = 0;
+	for (size_t k=0; k<n && mis <= maxMis; k+=32)
+	{
+		uint64_t x = PackedSeq::Word(a.Base, from+k) ^ PackedSeq::Word(b.Base, from2+k);
+		uint64_t d = ((x | (x >> 1)) | PackedSeq::Word(a.NMask, from+k) | PackedSeq::Word(b.NMask, from2+k)) & lo;
+		if (n-k < 32)
+			d &= (1ULL << (2*(n-k))) - 1;
+		mis += __builtin_popcountll(d);
+	}
+	return mis;
+}
+
+// insert size of a PE whose reads overlap, 0 if they do not. R1 is at fragment position 0 and
+// the reverse complement of R2 ends at the insert size; of the shifts with an overlap of at least
+// PAIR_MIN_OVERLAP bases and at most PAIR_MAX_MISMATCH mismatches per base, the one with the
+// fewest mismatches per base wins, a longer overlap breaking ties. Every shift is compared 32
+// bases at a time on the packed reads
+inline size_t MateOverlap(const char *seq1, size_t len1, const char *seq2, size_t len2)
+{
+	if (len1 < PAIR_MIN_OVERLAP || len2 < PAIR_MIN_OVERLAP || len1 > PAIR_MAX_LEN || len2 > PAIR_MAX_LEN)
+		return 0;
+	PackedSeq p1, p2;
+	p1.Pack(seq1, len1, false);
+	p2.Pack(seq2, len2, true);
+
+	size_t best = 0, bestMis = 0, bestOv = 0;
+	// rc2 starts at s in R1 coordinates, s = insert - len2
+	for (long s = -(long)(len2 - PAIR_MIN_OVERLAP); s <= (long)(len1 - PAIR_MIN_OVERLAP); s++)
+	{
+		size_t from = (s < 0 ? 0 : (size_t)s), end2 = (size_t)(s + (long)len2), to = (len1 < end2 ? len1 : end2);
+		size_t ov = to - from, maxMis = (size_t)(PAIR_MAX_MISMATCH * ov);
+		size_t mis = PackedMismatch(p1, from, p2, (size_t)((long)from - s), ov, maxMis);
+		if (mis > maxMis)
+			continue;
+		// mis/ov < bestMis/bestOv, or equal with a longer overlap
+		if (best == 0 || mis*bestOv < bestMis*ov || (mis*bestOv == bestMis*ov && ov > bestOv))
+		{
+			best = (size_t)(s + (long)len2);
+			bestMis = mis;
+			bestOv = ov;
+		}
+	}
+	return best;
+}
+
+//=============================================================================
+struct PairStat
+{
+	size_t Pairs;
+	size_t NameMismatch; // pairs whose mates have different names
+	size_t FirstLine; // R1 line of the first of them, 0 if none
+	std::string Name1, Name2; // its names
+	size_t Overlap; // pairs whose mates overlap
+	double InsertSum; // of their insert sizes
+	std::vector<size_t> InsertCount; // of them by insert size
+	size_t ShortInsert; // pairs with an insert shorter than a read: it reads into the adapter
+	size_t QDiscordant; // pairs whose mates' Phred means differ by PAIR_QDIFF or more
+	double QDiffSum; // of |Phred mean 1 - Phred mean 2| over all pairs
+
+	void Init()
+	{
+		Pairs = NameMismatch = FirstLine = Overlap = ShortInsert = QDiscordant = 0;
+		InsertSum = QDiffSum = 0.0;
+		InsertCount.clear();
+		Name1.clear();
+		Name2.clear();
+	}
+
+	// the names of PE r of the batches b1 and b2
+	void AddNames(const FqBatch &b1, const FqBatch &b2, size_t r)
+	{
+		Pairs++;
+		if (MateNameHash(b1.Name(r), b1.NameLen[r]) != MateNameHash(b2.Name(r), b2.NameLen[r]))
+		{
+			size_t line = b1.FirstLine + 4*r;
+			if (NameMismatch++ == 0 || line < FirstLine)
+			{
+				FirstLine = line;
+				Name1.assign(b1.Name(r), b1.NameLen[r]);
+				Name2.assign(b2.Name(r), b2.NameLen[r]);
+			}
+		}
+	}
+
+	// the reads of PE r, with their Phred means
+	void AddMates(const FqBatch &b1, const FqBatch &b2, size_t r, int pm1, int pm2)
+	{
+		size_t insert = MateOverlap(b1.Seq(r), b1.SeqLen[r], b2.Seq(r), b2.SeqLen[r]);
+		if (insert > 0)
+		{
+			Overlap++;
+			InsertSum += (double)insert;
+			if (InsertCount.size() <= insert)
+				InsertCount.resize(insert+1, 0);
+			InsertCount[insert]++;
+			ShortInsert += (insert < b1.SeqLen[r] || insert < b2.SeqLen[r]);
+		}
+		int d = (pm1 > pm2 ? pm1 - pm2 : pm2 - pm1);
+		QDiffSum += d;
+		QDiscordant += (d >= PAIR_QDIFF);
+	}
+
+	void Merge(const PairStat &o)
+	{
+		if (o.NameMismatch > 0 && (NameMismatch == 0 || o.FirstLine < FirstLine))
+		{
+			FirstLine = o.FirstLine;
+			Name1 = o.Name1;
+			Name2 = o.Name2;
+		}
+		Pairs += o.Pairs;
+		NameMismatch += o.NameMismatch;
+		Overlap += o.Overlap;
+		InsertSum += o.InsertSum;
+		if (InsertCount.size() < o.InsertCount.size())
+			InsertCount.resize(o.InsertCount.size(), 0);
+		for (size_t i=0; i<o.InsertCount.size(); i++)
+			InsertCount[i] += o.InsertCount[i];
+		ShortInsert += o.ShortInsert;
+		QDiscordant += o.QDiscordant;
+		QDiffSum += o.QDiffSum;
+	}
+
+	// insert size with a fraction p of the overlapping pairs at or below it, 0 if none
+	size_t InsertPercentile(double p) const
+	{
+		size_t cumu = 0;
+		for (size_t i=0; i<InsertCount.size(); i++)
+		{
+			cumu += InsertCount[i];
+			if (Overlap > 0 && cumu >= p*Overlap)
+				return i;
+		}
+		return 0;
+	}
+
+	// warning of mates out of step, to fp
+	void Warn(FILE *fp) const
+	{
+		if (NameMismatch > 0)
+			fprintf(fp, "Warning: %lu of %lu PEs have mates of different names, first at R1 line#%lu (%s vs %s); are R1 and R2 in step?\n",
+				NameMismatch, Pairs, FirstLine, Name1.c_str(), Name2.c_str());
+	}
+};
+
+#endif
@@ -1,6 +1,7 @@
 /*
-== Author: Yu-Jung Chang; update: 2018/03
+== Author: Yu-Jung Chang; update: 2026/10
 Read PE-FASTQ files and generate quality distribution of the data
+The html report is self-contained (see htmchart.h); summary numbers go to outPrjName.metrics.json/.tsv
 */
 //=============================================================================
 #include <stdio.h>
@@ -8,6 +9,14 @@ Read PE-FASTQ files and generate quality distribution of the data
 #include <vector>
 #include <math.h>
 #include <string>
+#include <memory> // for unique_ptr
+#include "htmchart.h"
+#include "metrics.h"
+#include "fqbatch.h"
+#include "wsched.h"
+#include "hiq.h"
+#include "qenc.h"
+#include "pairs.h"
 //#include <algorithm> // for heap
 //#include <stdlib.h> // for qsort
 
@@ -20,12 +29,7 @@ using namespace std;
 #define LINE_BUF_SIZE 10000
 #define ALPHABET_SIZE 256
 #define QSCORE_SIZE 42
-#define QCharOffset 33
 #define SEQ_SIZE 400
-#define HiQCellSize 200
-
-#define HiQParamSize 2
-int HiQTh[HiQParamSize] = {15, 20};
 
 //=============================================================================
 int cmpchar(const void *arg1, const void *arg2)
@@ -43,82 +47,75 @@ void counting_sort(char Qstr[], int Qlen, int Qcnt[])
 }
 
 //=============================================================================
-bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
+// statistics of the PEs one worker counted; the workers' are merged once at the end
+struct PeQAcc
 {
-	FILE *fp1, *fp2, *fpout, *fphtm;
-	char line_buf[LINE_BUF_SIZE], line_buf2[LINE_BUF_SIZE];
-	char OutCSV[1024], OutHTM[1024];
-	size_t AlphabetCount[ALPHABET_SIZE] = {0}; // counting alphabet occurrence
-	double TotalLen = 0.0; // Total length of all sequences
-	size_t PECount = 0; // # of PE sequences
-	size_t line = 0; // # of lines
-	size_t MinSeqLen = LINE_BUF_SIZE;
-	size_t MaxSeqLen = 0;
+	size_t AlphabetCount[ALPHABET_SIZE]; // counting alphabet occurrence
+	double TotalLen; // Total length of all sequences
+	size_t PECount; // # of PE sequences
+	size_t MinSeqLen;
+	size_t MaxSeqLen;
 
-	size_t QCount[QSCORE_SIZE] = {0}; // counting Q scores
-	size_t MinQCount[QSCORE_SIZE] = {0}; // counting MinQ scores
+	size_t QCount[QSCORE_SIZE]; // counting Q scores
+	size_t MinQCount[QSCORE_SIZE]; // counting MinQ scores
 
 	// for HiQ%
-	size_t HiQPercentCount[HiQParamSize][HiQCellSize+1] = {0};
-	
+	HiQStat HiQ;
+	vector<double> HiQFrac, HiQFrac2;
+
 	// for GC%
-	size_t CntGCRead[101] = {0}; // Counts of GC% for read
+	size_t CntGCRead[101]; // Counts of GC% for read
 
-	// Open files
-	fp1 = fopen(r1, "rt");
-	if (fp1 == NULL)
-	{
-		printf("Read FQ File 1 Error!\n");
-		return false;
-	}
+	QEncoding enc;
+	size_t BadQ; // Q characters outside the encoding, counted as Q0
 
-	fp2 = fopen(r2, "rt");
-	if (fp2 == NULL)
+	// mate names, overlaps and quality of the two reads of a PE
+	PairStat Pair;
+
+	void Init(const HiQStat &hiq, const QEncoding &e)
 	{
-		printf("Read FQ File 2 Error!\n");
-		return false;
+		memset(AlphabetCount, 0, sizeof(AlphabetCount));
+		TotalLen = 0.0;
+		PECount = 0;
+		MinSeqLen = LINE_BUF_SIZE;
+		MaxSeqLen = 0;
+		memset(QCount, 0, sizeof(QCount));
+		memset(MinQCount, 0, sizeof(MinQCount));
+		HiQ = hiq;
+		HiQFrac.resize(HiQ.Th.size());
+		HiQFrac2.resize(HiQ.Th.size());
+		memset(CntGCRead, 0, sizeof(CntGCRead));
+		enc = e;
+		BadQ = 0;
+		Pair.Init();
 	}
 
-	sprintf(OutCSV, "%s.csv", outPrjName);
-	fpout = fopen(OutCSV, "wt");
-	if (fpout == NULL)
+	// PEs [begin, end) of the batches b1 and b2, by the kernels of their length
+	void AddRange(const FqBatch &b1, const FqBatch &b2, size_t begin, size_t end)
 	{
-		printf("Open OUT CSV File Error!\n");
-		return false;
+		size_t len = b1.FixedLen();
+		if (b2.FixedLen() != len)
+			len = 0;
+		FQB_FIXED_CALL(len, AddLen, b1, b2, begin, end);
 	}
 
-	sprintf(OutHTM, "%s.htm", outPrjName);
-	fphtm = fopen(OutHTM, "wt");
-	if (fphtm == NULL)
+	// L: every read of b1 and b2 is that long, 0 for any length
+	template <size_t L>
+	void AddLen(const FqBatch &b1, const FqBatch &b2, size_t begin, size_t end)
 	{
-		printf("Open OUT HTM File Error!\n");
-		return false;
+		for (size_t r=begin; r<end; r++)
+			Add<L>(b1, b2, r);
 	}
 
-	// Read the file and check
-	while (fgets(line_buf, LINE_BUF_SIZE, fp1) != NULL && fgets(line_buf2, LINE_BUF_SIZE, fp2) != NULL) // get the 1st line per 4 lines
+	// PE r of the batches b1 and b2
+	template <size_t L>
+	void Add(const FqBatch &b1, const FqBatch &b2, size_t r)
 	{
-		// line 1
-		line++;
-		if (line_buf[0] != '@' || line_buf2[0] != '@') // Is not the 1st title line
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
-
-		// line 2
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL || fgets(line_buf2, LINE_BUF_SIZE, fp2) == NULL) // get the 2nd line: the seq. If fails
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
-		
 		// read 1 & 2
-		strtok(line_buf, "\n");
-		strtok(line_buf2, "\n");
-		size_t SeqLen1 = strlen(line_buf);
-		size_t SeqLen2 = strlen(line_buf2);
+		const char *seq1 = b1.Seq(r), *seq2 = b2.Seq(r);
+		const unsigned char *qual1 = (const unsigned char *)b1.Qual(r), *qual2 = (const unsigned char *)b2.Qual(r);
+		size_t SeqLen1 = L ? L : b1.SeqLen[r], SeqLen2 = L ? L : b2.SeqLen[r];
+		size_t QLen1 = SeqLen1, QLen2 = SeqLen2;
 		TotalLen += (double)(SeqLen1+SeqLen2);
 		PECount++;
 
@@ -132,13 +129,13 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 		size_t GCcnt=0, ATcnt=0;
 		for (size_t i=0; i<SeqLen1; i++)
 		{
-			AlphabetCount[line_buf[i]]++;
-			if (line_buf[i] == 'G' || line_buf[i] == 'C')
+			AlphabetCount[(unsigned char)seq1[i]]++;
+			if (seq1[i] == 'G' || seq1[i] == 'C')
 				GCcnt++;
-			else if (line_buf[i] == 'A' || line_buf[i] == 'T')
+			else if (seq1[i] == 'A' || seq1[i] == 'T')
 				ATcnt++;
 		}
-		GCvalue = (char)round(100.0*(double)GCcnt/(double)(GCcnt+ATcnt));
+		GCvalue = (GCcnt+ATcnt) ? (char)round(100.0*(double)GCcnt/(double)(GCcnt+ATcnt)) : 0;
 		CntGCRead[GCvalue]++;
 //		printf("[%lu] NumGC=%lu, NumAT=%lu, GCvalue=%d\n", PECount, GCcnt[0], ATcnt[0], GCvalue); getchar();
 
@@ -146,89 +143,197 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 		GCcnt=ATcnt=0;
 		for (size_t i=0; i<SeqLen2; i++)
 		{
-			AlphabetCount[line_buf2[i]]++;
-			if (line_buf2[i] == 'G' || line_buf2[i] == 'C')
+			AlphabetCount[(unsigned char)seq2[i]]++;
+			if (seq2[i] == 'G' || seq2[i] == 'C')
 				GCcnt++;
-			else if (line_buf2[i] == 'A' || line_buf2[i] == 'T')
+			else if (seq2[i] == 'A' || seq2[i] == 'T')
 				ATcnt++;
 		}
-		GCvalue = (char)round(100.0*(double)GCcnt/(double)(GCcnt+ATcnt));
+		GCvalue = (GCcnt+ATcnt) ? (char)round(100.0*(double)GCcnt/(double)(GCcnt+ATcnt)) : 0;
 		CntGCRead[GCvalue]++;
 
-		// line 3
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL || line_buf[0] != '+' || fgets(line_buf2, LINE_BUF_SIZE, fp2) == NULL || line_buf2[0] != '+') // get the 3rd line: the q title. If fails
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
+		int QHist1[QHIST_SIZE] = {0}, QHist2[QHIST_SIZE] = {0}; // Q histograms of read 1 & 2
+		CountQHist<L>(qual1, QLen1, enc, QHist1);
+		CountQHist<L>(qual2, QLen2, enc, QHist2);
+		BadQ += FoldBadQ(QHist1) + FoldBadQ(QHist2);
+
+		// Q counts and MinQ of the PE from the histograms; Q above the top bin is counted in it
+		int minq = QERR_TABLE_SIZE-1;
+		for (int q=QERR_TABLE_SIZE-1; q >= 0; q--)
+			if (QHist1[q] + QHist2[q])
+			{
+				QCount[MIN(q, QSCORE_SIZE-1)] += QHist1[q] + QHist2[q];
+				minq = q;
+			}
+		MinQCount[MIN(minq, QSCORE_SIZE-1)]++;
+
+		// for HiQ%: the PE by its worse read
+		HiQ.Fractions(QHist1, QERR_TABLE_SIZE, QLen1, &HiQFrac[0]);
+		HiQ.Fractions(QHist2, QERR_TABLE_SIZE, QLen2, &HiQFrac2[0]);
+		for (size_t j=0; j < HiQ.Th.size(); j++)
+			HiQFrac[j] = MIN(HiQFrac[j], HiQFrac2[j]);
+		HiQ.Count(&HiQFrac[0]);
+
+		// pair concordance
+		Pair.AddNames(b1, b2, r);
+		Pair.AddMates(b1, b2, r, PhredMean(QErrSum(QHist1, QERR_TABLE_SIZE), QLen1, QSCORE_SIZE-1),
+			PhredMean(QErrSum(QHist2, QERR_TABLE_SIZE), QLen2, QSCORE_SIZE-1));
+	}
 
-		// line 4
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL || fgets(line_buf2, LINE_BUF_SIZE, fp2) == NULL) // get the 4th line: the qscore. If fails
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
-		strtok(line_buf, "\n");
-		strtok(line_buf2, "\n");
-		size_t QLen1 = strlen(line_buf);
-		size_t QLen2 = strlen(line_buf2);
-		if (QLen1 != SeqLen1 || QLen2 != SeqLen2)
+	void Merge(const PeQAcc &o)
+	{
+		for (int i=0; i<ALPHABET_SIZE; i++)
+			AlphabetCount[i] += o.AlphabetCount[i];
+		TotalLen += o.TotalLen;
+		PECount += o.PECount;
+		MinSeqLen = MIN(MinSeqLen, o.MinSeqLen);
+		MaxSeqLen = MAX(MaxSeqLen, o.MaxSeqLen);
+		for (int q=0; q<QSCORE_SIZE; q++)
 		{
-			printf("FASTQ file format error at line#%lu: incorrect length of Q-string\n", line);
-			return false;
+			QCount[q] += o.QCount[q];
+			MinQCount[q] += o.MinQCount[q];
 		}
+		HiQ.Merge(o.HiQ);
+		for (int i=0; i<101; i++)
+			CntGCRead[i] += o.CntGCRead[i];
+		BadQ += o.BadQ;
+		Pair.Merge(o.Pair);
+	}
+};
 
-		char minq1 = QSCORE_SIZE-1, minq2 = QSCORE_SIZE-1;
-		int HiQCnt[HiQParamSize][2] = {0};
+//=============================================================================
+bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName, HiQStat &HiQ, int Threads, int Phred)
+{
+	FILE *fpout, *fphtm;
+	char OutCSV[1024], OutHTM[1024];
+	size_t line = 0; // # of lines
 
-		for (size_t i=0; i<QLen1; i++)
-		{
-			char tmpq = line_buf[i]-QCharOffset;
-			QCount[tmpq]++;
-			minq1 = MIN(minq1, tmpq);
-			for (int j=0; j < HiQParamSize; j++)
-				if (tmpq >= HiQTh[j])
-					HiQCnt[j][0] ++;
-		}
-		for (size_t i=0; i<QLen2; i++)
-		{
-			char tmpq = line_buf2[i]-QCharOffset;
-			QCount[tmpq]++;
-			minq2 = MIN(minq2, tmpq);
-			for (int j=0; j < HiQParamSize; j++)
-				if (tmpq >= HiQTh[j])
-					HiQCnt[j][1] ++;
-		}
+	// Open files
+	FqReader in1;
+	if (!in1.Open(r1))
+	{
+		printf("Read FQ File 1 Error!\n");
+		return false;
+	}
 
-		// for MinQ
-		MinQCount[MIN(minq1, minq2)]++;
+	FqReader in2;
+	if (!in2.Open(r2))
+	{
+		printf("Read FQ File 2 Error!\n");
+		return false;
+	}
+	// both files are taken to share the encoding of r1
+	QEncoding enc;
+	size_t probeLen;
+	const char *probe = in1.Buffered(probeLen);
+	enc.Detect(probe, probeLen, QSCORE_SIZE-1, Phred);
+	enc.Print(stdout);
+	printf("Input I/O: %s\n", in1.Backend());
+	printf("Threads: %d\n", Threads);
 
-		// for HiQ%
-		for (int j=0; j < HiQParamSize; j++)
-		{
-			// For each PE, decide its HiQ% tile number
-			// LowQ by ceil; HiQ by floor
-			int HiqpTileNo = (int)floor(HiQCellSize*MIN((double)HiQCnt[j][0]/(double)QLen1, (double)HiQCnt[j][1]/(double)QLen2));
-			HiQPercentCount[j][HiqpTileNo]++;
+	sprintf(OutCSV, "%s.csv", outPrjName);
+	fpout = fopen(OutCSV, "wt");
+	if (fpout == NULL)
+	{
+		printf("Open OUT CSV File Error!\n");
+		return false;
+	}
+
+	sprintf(OutHTM, "%s.htm", outPrjName);
+	fphtm = fopen(OutHTM, "wt");
+	if (fphtm == NULL)
+	{
+		printf("Open OUT HTM File Error!\n");
+		return false;
+	}
 
+	// Read the files in batches of PEs and check; every worker counts into its own accumulator,
+	// set up by the worker itself so that it lies on the worker's NUMA node
+	vector< unique_ptr<PeQAcc> > acc(Threads);
+	FqBatchPool pool(4);
+	WsScheduler *ws = NULL;
+	if (Threads > 1)
+		ws = new WsScheduler(Threads, 4, [&acc, &HiQ, &enc](int w) {
+			acc[w].reset(new PeQAcc());
+			acc[w]->Init(HiQ, enc);
+		}, [&acc](int w, const WsTask &t) {
+			acc[w]->AddRange(*t.b1, *t.b2, t.Begin, t.End);
+		});
+	else
+	{
+		acc[0].reset(new PeQAcc());
+		acc[0]->Init(HiQ, enc);
+	}
+	size_t line2 = 0, NumPE = 0;
+	for (;;)
+	{
+		// both batches of a PE from the same node
+		FqBatchPool &p = ws ? ws->NextPool() : pool;
+		FqBatch *b1 = p.Get(), *b2 = p.Get();
+		if (!FillPairs(*b1, *b2, in1, in2, line, line2))
+		{
+			delete ws;
+			return false;
+		}
+		if (b1->Count == 0)
+		{
+			p.Put(b1);
+			p.Put(b2);
+			break;
 		}
 
 		// Progress
-		if (PECount % 5000000 == 0) // print . per 5M PE
+		if ((NumPE+b1->Count)/5000000 != NumPE/5000000) // print . per 5M PE
 		{
 			printf(".");
 			fflush(stdout);
 		}
+		NumPE += b1->Count;
 
-		// for Test
-//		if (PECount == 20000000)
-//			break;;
+		if (ws != NULL)
+			ws->Submit(b1, b2);
+		else
+		{
+			acc[0]->AddRange(*b1, *b2, 0, b1->Count);
+			pool.Put(b1);
+			pool.Put(b2);
+		}
+	}
+	if (ws != NULL)
+	{
+		ws->Close(); // waits for the workers
+		ws->Reduce([&acc](int dst, int src) {
+			acc[dst]->Merge(*acc[src]);
+			acc[src].reset();
+		});
+	}
+	in1.Close();
+	in2.Close();
+	if (in1.Err || in2.Err)
+	{
+		printf("Read FQ File %d Error!\n", in1.Err ? 1 : 2);
+		delete ws;
+		return false;
 	}
-	fclose(fp1);
-	fclose(fp2);
+
+	PeQAcc &all = *acc[0];
+	size_t (&AlphabetCount)[ALPHABET_SIZE] = all.AlphabetCount;
+	double &TotalLen = all.TotalLen;
+	size_t &PECount = all.PECount;
+	size_t &MinSeqLen = all.MinSeqLen;
+	size_t &MaxSeqLen = all.MaxSeqLen;
+	size_t (&QCount)[QSCORE_SIZE] = all.QCount;
+	size_t (&MinQCount)[QSCORE_SIZE] = all.MinQCount;
+	size_t (&CntGCRead)[101] = all.CntGCRead;
+	size_t &BadQ = all.BadQ;
+	PairStat &Pair = all.Pair;
+	HiQ = all.HiQ;
 	printf("done\n");
+	if (ws != NULL) // throughput of the worker groups
+	{
+		ws->Report(stdout);
+		delete ws;
+	}
 
 // --- summary
 	// to screen
@@ -241,7 +346,66 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 	fprintf(stdout, "AvgReadLen: %.2f\n", TotalLen/(double)(PECount*2));
 	fprintf(stdout, "MinReadLen: %lu\n", MinSeqLen);
 	fprintf(stdout, "MaxReadLen: %lu\n", MaxSeqLen);
-	fprintf(stdout, "OutFile: %s,%s\n", OutCSV, OutHTM);
+	if (BadQ > 0)
+		fprintf(stdout, "Warning: %lu Q characters outside Phred+%d, counted as Q0\n", BadQ, enc.Offset);
+	Pair.Warn(stdout);
+	fprintf(stdout, "OverlapPE: %.2f%%, mean insert %.1f, median insert %lu\n", PECount ? 100.0*Pair.Overlap/PECount : 0.0,
+		Pair.Overlap ? Pair.InsertSum/Pair.Overlap : 0.0, Pair.InsertPercentile(0.5));
+	fprintf(stdout, "ShortInsertPE: %.2f%%\n", PECount ? 100.0*Pair.ShortInsert/PECount : 0.0);
+	fprintf(stdout, "MateQDiscordantPE: %.2f%%\n", PECount ? 100.0*Pair.QDiscordant/PECount : 0.0);
+	fprintf(stdout, "OutFile: %s,%s,%s.metrics.json,%s.metrics.tsv\n", OutCSV, OutHTM, outPrjName, outPrjName);
+
+	// metrics; MinQ and %HighQ are per PE (the worse of the two reads)
+	{
+		string in = string(r1) + "," + r2;
+		Metrics met("peQdist", in.c_str());
+		size_t BQsum[4] = {0}; // <15, 15-19, 20-29, 30+
+		for (int i=0; i<QSCORE_SIZE; i++)
+			BQsum[i < 15 ? 0 : (i < 20 ? 1 : (i < 30 ? 2 : 3))] += QCount[i];
+		size_t MQsum[3] = {0}; // >= 10, >=15, >=20
+		for (int i=10; i<QSCORE_SIZE; i++)
+			MQsum[i < 15 ? 0 : (i < 20 ? 1 : 2)] += MinQCount[i];
+		MQsum[1] += MQsum[2];
+		MQsum[0] += MQsum[1];
+		double pe = (double)PECount;
+
+		met.AddInt("pairs", PECount);
+		met.AddInt("reads", PECount*2);
+		met.AddInt("bases", (size_t)TotalLen);
+		met.AddReal("avg_read_len", PECount ? TotalLen/(double)(PECount*2) : NAN);
+		met.AddInt("min_read_len", PECount ? MinSeqLen : 0);
+		met.AddInt("max_read_len", MaxSeqLen);
+		met.AddPct("gc_pct", (double)(AlphabetCount['C']+AlphabetCount['G']), TotalLen);
+		met.AddPct("n_pct", (double)AlphabetCount['N'], TotalLen);
+		met.AddPct("base_q30_pct", (double)BQsum[3], TotalLen);
+		met.AddPct("base_q20_29_pct", (double)BQsum[2], TotalLen);
+		met.AddPct("base_q15_19_pct", (double)BQsum[1], TotalLen);
+		met.AddPct("base_lt_q15_pct", (double)BQsum[0], TotalLen);
+		met.AddPct("minq_ge20_pct", (double)MQsum[2], pe);
+		met.AddPct("minq_ge15_pct", (double)MQsum[1], pe);
+		met.AddPct("minq_ge10_pct", (double)MQsum[0], pe);
+		char key[64];
+		for (size_t j=HiQ.Th.size(); j-- > 0; )
+			for (size_t c=0; c < HiQ.Cut.size(); c++)
+			{
+				HiQStat::Key(key, HiQ.Th[j], HiQ.Cut[c]);
+				met.AddReal(key, 100.0*HiQ.Coverage(j, c, PECount));
+			}
+		met.AddReal("poor_quality_pct", 100.0*HiQ.Poor(PECount));
+		met.AddReal("medium_quality_pct", 100.0*(1-HiQ.High(PECount)-HiQ.Poor(PECount)));
+		met.AddReal("high_quality_pct", 100.0*HiQ.High(PECount));
+		met.AddInt("q_offset", enc.Offset);
+		met.AddInt("invalid_q_bases", BadQ);
+		met.AddInt("name_mismatch_pairs", Pair.NameMismatch);
+		met.AddPct("overlap_pct", (double)Pair.Overlap, pe);
+		met.AddReal("overlap_insert_mean", Pair.Overlap ? Pair.InsertSum/Pair.Overlap : NAN);
+		met.AddReal("overlap_insert_median", Pair.Overlap ? (double)Pair.InsertPercentile(0.5) : NAN);
+		met.AddPct("short_insert_pct", (double)Pair.ShortInsert, pe);
+		met.AddPct("mate_q_discordant_pct", (double)Pair.QDiscordant, pe);
+		met.AddReal("mate_q_diff_mean", PECount ? Pair.QDiffSum/pe : NAN);
+		if (!met.Write(outPrjName))
+			return false;
+	}
 
 	// Start outputing to files
 	fprintf(fpout, "--- Summary of PE FASTQ ---\n");
@@ -252,9 +416,13 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 	fprintf(fpout, "AvgReadLen,%.2f\n", TotalLen/(double)(PECount*2));
 	fprintf(fpout, "MaxReadLen,%lu\n", MaxSeqLen);
 	fprintf(fpout, "MinReadLen,%lu\n", MinSeqLen);
+	fprintf(fpout, "NameMismatchPE,%lu\n", Pair.NameMismatch);
+	fprintf(fpout, "OverlapPE%%,%.2f%%\n", PECount ? 100.0*Pair.Overlap/PECount : 0.0);
+	fprintf(fpout, "ShortInsertPE%%,%.2f%%\n", PECount ? 100.0*Pair.ShortInsert/PECount : 0.0);
+	fprintf(fpout, "MateQDiscordantPE%%,%.2f%%\n", PECount ? 100.0*Pair.QDiscordant/PECount : 0.0);
 
 	// Output html
-	fprintf(fphtm, "<html>\n<head>\n<script type=\"text/javascript\" src=\"https://www.gstatic.com/charts/loader.js\"></script></head>\n");
+	HtmHead(fphtm, "PE quality distribution", "");
 	fprintf(fphtm, "<body>\n");
 	fprintf(fphtm, "--- Summary of PE FASTQ ---\n");
 	fprintf(fphtm, "<li>InputFile: %s,%s\n", r1, r2);
@@ -264,6 +432,12 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 	fprintf(fphtm, "<li>AvgReadLen: %.2f\n", TotalLen/(double)(PECount*2));
 	fprintf(fphtm, "<li>MinReadLen: %lu\n", MinSeqLen);
 	fprintf(fphtm, "<li>MaxReadLen: %lu\n", MaxSeqLen);
+	if (Pair.NameMismatch > 0)
+		fprintf(fphtm, "<li><b>Warning: %lu PEs have mates of different names, first at R1 line#%lu; R1 and R2 may be out of step</b>\n", Pair.NameMismatch, Pair.FirstLine);
+	fprintf(fphtm, "<li>PEs with overlapping mates: %.2f%% (mean insert %.1f, median %lu)\n", PECount ? 100.0*Pair.Overlap/PECount : 0.0,
+		Pair.Overlap ? Pair.InsertSum/Pair.Overlap : 0.0, Pair.InsertPercentile(0.5));
+	fprintf(fphtm, "<li>PEs with an insert shorter than a read (adapter read-through, clipped when mapped): %.2f%%\n", PECount ? 100.0*Pair.ShortInsert/PECount : 0.0);
+	fprintf(fphtm, "<li>PEs with mates differing by %d or more in Phred mean: %.2f%%\n", PAIR_QDIFF, PECount ? 100.0*Pair.QDiscordant/PECount : 0.0);
 
 // --- Alphabet freq
 	fprintf(fpout, "\n--- Alphabet Occurrence Count/Frequency ---\n");
@@ -329,12 +503,15 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 	fprintf(fphtm, "  <tr><td><br>--- MinimalQ distribution ---</td></tr>\n");
 	fprintf(fphtm, "  <tr><td id=mq style=\"height: 300px\"></td></tr>\n");
 
-	for (int i=0; i<HiQParamSize; i++)
+	for (size_t i=0; i<HiQ.Th.size(); i++)
 	{
-		fprintf(fphtm, "  <tr><td><br>--- %%HighQ(%d) distribution ---</td></tr>\n", HiQTh[i]);
-		fprintf(fphtm, "  <tr><td id=hq%d style=\"height: 300px\"></td></tr>\n", HiQTh[i]);
+		fprintf(fphtm, "  <tr><td><br>--- %%HighQ(%d) distribution ---</td></tr>\n", HiQ.Th[i]);
+		fprintf(fphtm, "  <tr><td id=hq%d style=\"height: 300px\"></td></tr>\n", HiQ.Th[i]);
 	}
 
+	fprintf(fphtm, "  <tr><td><br>--- Insert size of PEs with overlapping mates ---</td></tr>\n");
+	fprintf(fphtm, "  <tr><td id=is style=\"height: 300px\"></td></tr>\n");
+
 	fprintf(fphtm, "</table>\n\n");
 
 	// script
@@ -342,28 +519,17 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 	fprintf(fphtm, "function DrawDist() {\n");
 
 	// option
-	fprintf(fphtm, "  var opt1 = {\n");
-	fprintf(fphtm, "    title: 'GC%% distribution of reads', hAxis: { title: 'GC%%' }, vAxis: { title: 'Freq%%' }, colors: ['#a52714', '#097138']\n");
-	fprintf(fphtm, "  };\n");
-
-	fprintf(fphtm, "  var d1 = new google.visualization.DataTable();\n");
-	fprintf(fphtm, "  d1.addColumn('number', 'GC%%');\n");
-	fprintf(fphtm, "  d1.addColumn('number', 'Freq');\n");
-	fprintf(fphtm, "  d1.addRows( [ "); 
-
-	for (char i=0; i<=100; i++)
 	{
-		double tmpf = 100.0 * (double)CntGCRead[i] / (double)(PECount*2);
-		fprintf(fphtm, "[%d,%.2f],", i, tmpf);
-		if (i % 10 == 9)
-			fprintf(fphtm, "\n");
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (int i=0; i<=100; i++)
+		{
+			x.push_back(i);
+			y[0].push_back(100.0 * (double)CntGCRead[i] / (double)(PECount*2));
+		}
+		HtmChart(fphtm, "gc", "type: 'line', title: 'GC% distribution of reads', xTitle: 'GC%', yTitle: 'Freq%', colors: ['#a52714', '#097138']", x, y, "['Freq']");
 	}
 
-	fprintf(fphtm, "  ] );\n");
-	fprintf(fphtm, "  var chart1 = new google.visualization.LineChart(document.getElementById('gc'));\n");
-	fprintf(fphtm, "  chart1.draw(d1, opt1);\n");
-	fprintf(fphtm, "\n");
-
 
 // --- Base Q dist
 	fprintf(fpout, "\n--- Base Q-value Count ---\n");
@@ -378,28 +544,17 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 	}
 
 	// option
-	fprintf(fphtm, "  var opt2 = {\n");
-	fprintf(fphtm, "    title: 'Base Q-value distribution', hAxis: { title: 'Q-value' }, vAxis: { title: 'Freq%%', format: 'percent' }, colors: ['#a52714', '#097138']\n");
-	fprintf(fphtm, "  };\n");
-
-	fprintf(fphtm, "  var d2 = new google.visualization.DataTable();\n");
-	fprintf(fphtm, "  d2.addColumn('number', 'Q-value');\n");
-	fprintf(fphtm, "  d2.addColumn('number', 'Freq');\n");
-	fprintf(fphtm, "  d2.addRows( [ "); 
-
-	for (size_t i=0; i<QSCORE_SIZE; i++)
 	{
-		double tmpf = 100.0 * (double)QCount[i] / TotalLen;
-		fprintf(fphtm, "[%lu,%.2f], ", i, tmpf);
-		if (i % 10 == 9)
-			fprintf(fphtm, "\n");
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (size_t i=0; i<QSCORE_SIZE; i++)
+		{
+			x.push_back(i);
+			y[0].push_back((double)QCount[i] / TotalLen);
+		}
+		HtmChart(fphtm, "bq", "type: 'line', title: 'Base Q-value distribution', xTitle: 'Q-value', yTitle: 'Freq%', percent: 1, colors: ['#a52714', '#097138']", x, y, "['Freq']");
 	}
 
-	fprintf(fphtm, "  ] );\n");
-	fprintf(fphtm, "  var chart2 = new google.visualization.LineChart(document.getElementById('bq'));\n");
-	fprintf(fphtm, "  chart2.draw(d2, opt2);\n");
-	fprintf(fphtm, "\n");
-
 // --- MinQ dist
 	fprintf(fpout, "\n--- PE MinQ-value Count ---\n");
 	fprintf(fpout, "MinQ,Count,Freq%%,cumuFreq%%\n");
@@ -415,74 +570,72 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 	}
 
 	// option
-	fprintf(fphtm, "  var opt3 = {\n");
-	fprintf(fphtm, "    title: 'MinQ distribution', hAxis: { title: 'MinQ-value (in reverse dir.)', direction: -1, viewWindow: { max: 41 } }, vAxis: { title: '%%', format: 'percent' }, colors: ['#a52714', '#097138']\n");
-	fprintf(fphtm, "  };\n");
-
-	fprintf(fphtm, "  var d3 = new google.visualization.DataTable();\n");
-	fprintf(fphtm, "  d3.addColumn('number', 'MinQ');\n");
-	fprintf(fphtm, "  d3.addColumn('number', 'Freq');\n");
-	fprintf(fphtm, "  d3.addColumn('number', 'SubsetSize');\n");
-	fprintf(fphtm, "  d3.addRows( [ "); 
-
-	for (size_t i=0, cumuCnt=PECount; i<QSCORE_SIZE; i++)
 	{
-		double tmpf = (double)MinQCount[i] / (double)PECount;
-		double tmpf2 = (double)cumuCnt / (double)PECount;
-		fprintf(fphtm, "[%lu,%.4f,%.4f], ", i, tmpf, tmpf2);
-		if (i % 10 == 9)
-			fprintf(fphtm, "\n");
-		cumuCnt -= MinQCount[i];
+		vector<double> x;
+		vector< vector<double> > y(2);
+		for (size_t i=0, cumuCnt=PECount; i<QSCORE_SIZE; i++)
+		{
+			x.push_back(i);
+			y[0].push_back((double)MinQCount[i] / (double)PECount);
+			y[1].push_back((double)cumuCnt / (double)PECount);
+			cumuCnt -= MinQCount[i];
+		}
+		HtmChart(fphtm, "mq", "type: 'line', title: 'MinQ distribution', xTitle: 'MinQ-value (in reverse dir.)', yTitle: '%', percent: 1, reverse: 1, xMax: 41, colors: ['#a52714', '#097138']", x, y, "['Freq', 'SubsetSize']");
 	}
 
-	fprintf(fphtm, "  ] );\n");
-	fprintf(fphtm, "  var chart3 = new google.visualization.LineChart(document.getElementById('mq'));\n");
-	fprintf(fphtm, "  chart3.draw(d3, opt3);\n");
-	fprintf(fphtm, "\n");
-
 // --- Dist of %HighQ(x) 
-	for (int j=0; j < HiQParamSize; j++)
+	for (size_t j=0; j < HiQ.Th.size(); j++)
 	{
-		// option
-		fprintf(fphtm, "  var optH%d = {\n", HiQTh[j]);
-		fprintf(fphtm, "    title: '%%HighQ(%d) distribution', hAxis: { title: '%%HighQ(%d) (in reverse dir.)', direction: -1, viewWindow: { max: 100, min: 50 } }, vAxis: { title: '%%', format: 'percent' }, colors: ['#a52714', '#097138']\n", HiQTh[j], HiQTh[j]);
-		fprintf(fphtm, "  };\n");
-	
-		fprintf(fphtm, "  var dH%d = new google.visualization.DataTable();\n", HiQTh[j]);
-		fprintf(fphtm, "  dH%d.addColumn('number', '%%HighQ');\n", HiQTh[j]);
-		fprintf(fphtm, "  dH%d.addColumn('number', 'Freq');\n", HiQTh[j]);
-		fprintf(fphtm, "  dH%d.addColumn('number', 'SubsetSize');\n", HiQTh[j]);
-		fprintf(fphtm, "  dH%d.addRows( [ ", HiQTh[j]); 
-
-		fprintf(fpout, "\n--- PE %%HighQ(%d)-value Count ---\n", HiQTh[j]);
-		fprintf(fpout, "%%HighQ(%d),Count,Freq%%,CumuFreq%%\n", HiQTh[j]);
+		vector<double> x;
+		vector< vector<double> > y(2);
+
+		fprintf(fpout, "\n--- PE %%HighQ(%d)-value Count ---\n", HiQ.Th[j]);
+		fprintf(fpout, "%%HighQ(%d),Count,Freq%%,CumuFreq%%\n", HiQ.Th[j]);
 		for (long i=HiQCellSize, cumuCnt=0; i >= 0; i--)
 		{
-			if (HiQPercentCount[j][i] == 0)
+			if (HiQ.PercentCount[j][i] == 0)
 				continue;
 
-			cumuCnt += HiQPercentCount[j][i];
-			double tmpf = (double)HiQPercentCount[j][i] / (double)PECount;
+			cumuCnt += HiQ.PercentCount[j][i];
+			double tmpf = (double)HiQ.PercentCount[j][i] / (double)PECount;
 			double tmpf2 = (double)cumuCnt / (double)PECount;
-			fprintf(fpout, "%.1f,%lu,%.2f%%,%.2f%%\n", (double)i*(100.0/HiQCellSize), HiQPercentCount[j][i], 100.0*tmpf, 100.0*tmpf2);
+			fprintf(fpout, "%.1f,%lu,%.2f%%,%.2f%%\n", (double)i*(100.0/HiQCellSize), HiQ.PercentCount[j][i], 100.0*tmpf, 100.0*tmpf2);
 
-			fprintf(fphtm, "[%.1f,%.4f,%.4f], ", (double)i*(100.0/HiQCellSize), tmpf, tmpf2);
-			if (i % 10 == 9)
-				fprintf(fphtm, "\n");
+			x.push_back((double)i*(100.0/HiQCellSize));
+			y[0].push_back(tmpf);
+			y[1].push_back(tmpf2);
 		}
-	
-		fprintf(fphtm, "  [0,0,1] ] );\n");
-		fprintf(fphtm, "  var chartH%d = new google.visualization.LineChart(document.getElementById('hq%d'));\n", HiQTh[j], HiQTh[j]);
-		fprintf(fphtm, "  chartH%d.draw(dH%d, optH%d);\n", HiQTh[j], HiQTh[j], HiQTh[j]);
-		fprintf(fphtm, "\n");
+		x.push_back(0);
+		y[0].push_back(0);
+		y[1].push_back(1);
+
+		char id[32], opt[1024];
+		sprintf(id, "hq%d", HiQ.Th[j]);
+		sprintf(opt, "type: 'line', title: '%%HighQ(%d) distribution', xTitle: '%%HighQ(%d) (in reverse dir.)', yTitle: '%%', percent: 1, reverse: 1, xMin: 50, xMax: 100, colors: ['#a52714', '#097138']", HiQ.Th[j], HiQ.Th[j]);
+		HtmChart(fphtm, id, opt, x, y, "['Freq', 'SubsetSize']");
+	}
+
+// --- Insert size of the overlapping PEs
+	fprintf(fpout, "\n--- Insert size of PEs with overlapping mates ---\n");
+	fprintf(fpout, "Insert,Count,Freq%%\n");
+	{
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (size_t i=0; i<Pair.InsertCount.size(); i++)
+		{
+			if (Pair.InsertCount[i] > 0)
+				fprintf(fpout, "%lu,%lu,%.2f%%\n", i, Pair.InsertCount[i], 100.0*(double)Pair.InsertCount[i]/(double)PECount);
+			x.push_back(i);
+			y[0].push_back((double)Pair.InsertCount[i] / (double)PECount);
+		}
+		HtmChart(fphtm, "is", "type: 'line', title: 'Insert size of PEs with overlapping mates', xTitle: 'Insert size (bp)', yTitle: '% of PEs', percent: 1, colors: ['#a52714', '#097138']", x, y, "['Freq']");
 	}
 	fprintf(fpout, "\n");
 
 
 	// end of htm
 	fprintf(fphtm, "}\n");
-	fprintf(fphtm, "google.charts.load('current', {packages: ['corechart', 'line']});\n");
-	fprintf(fphtm, "google.charts.setOnLoadCallback(DrawDist);"); 
+	fprintf(fphtm, "DrawDist();\n"); 
 	fprintf(fphtm, "</script>\n");
 	fprintf(fphtm, "</body>\n</html>\n");
 
@@ -498,12 +651,35 @@ bool ProbeFASTQPE(char *r1, char *r2, char *outPrjName)
 int main(int argc, char **argv)
 {
 //=============================================================================
-	if(argc != 4)
+	const char *ThList = HiQDefaultTh, *CutList = HiQDefaultCut;
+	int Threads = (int)thread::hardware_concurrency();
+	int Phred = 0;
+	bool ArgOK = (argc >= 4);
+	for (int i=4; ArgOK && i < argc; i++)
+	{
+		if (strcmp(argv[i], "-q") == 0 && i+1 < argc)
+			ThList = argv[++i];
+		else if (strcmp(argv[i], "-c") == 0 && i+1 < argc)
+			CutList = argv[++i];
+		else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			Threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-p") == 0 && i+1 < argc)
+			Phred = atoi(argv[++i]);
+		else
+			ArgOK = false;
+	}
+	if (Phred != 0 && Phred != 33 && Phred != 64)
+		ArgOK = false;
+	if(!ArgOK)
 	{
 		printf("=== peQdist: Read PE-FASTQ files and generate quality distribution and GC%% of paired-end FASTQ files ===\n\n");
-		printf("Usage: peQdist r1.fq r2.fq outPrjName\n");
+		printf("Usage: peQdist r1.fq r2.fq outPrjName [-q QThs] [-c Cuts] [-t threads] [-p 33|64]\n");
 		printf("Input: r1.fq (read1 fastq of PE), r2.fq (read2 fastq of PE)\n");
-		printf("Output: outPrjName.htm, outPrjName.csv\n");
+		printf(" -q: Optional. Comma-separated Q thresholds of %%HighQ(q) (Range: 0-41; default %s)\n", HiQDefaultTh);
+		printf(" -c: Optional. Comma-separated %%HighQ coverage cut points (Range: 100.0-0.0; default %s)\n", HiQDefaultCut);
+		printf(" -t: Optional. Number of threads, default all cores\n");
+		printf(" -p: Optional. Quality offset, Phred+33 or Phred+64 (default: detected, Phred+33 if the first reads fit both)\n");
+		printf("Output: outPrjName.htm, outPrjName.csv, outPrjName.metrics.json, outPrjName.metrics.tsv\n");
 		printf("Verson: 0.91 (2017/11) \n");
 		printf("Author: Yu-Jung Chang\n\n");
 
@@ -511,7 +687,11 @@ int main(int argc, char **argv)
 	}
 
 //=============================================================================
-	ProbeFASTQPE(argv[1], argv[2], argv[3]);
+	HiQStat HiQ;
+	if (!HiQ.Init(ThList, CutList))
+		return 1;
+	if (!ProbeFASTQPE(argv[1], argv[2], argv[3], HiQ, MAX(1, Threads), Phred))
+		return 1;
 
 //=============================================================================
 	return 0;
@@ -1,6 +1,7 @@
 /*
-== Author: Yu-Jung Chang; update: 2017/10
+== Author: Yu-Jung Chang; update: 2026/10
 Give %HiQ(x) and read PE FASTQ files to select PEs 
+Optionally also by expected errors (EE) of reads, see qerr.h
 */
 //=============================================================================
 #include <stdio.h>
@@ -8,6 +9,10 @@ Give %HiQ(x) and read PE FASTQ files to select PEs
 #include <string>
 #include <math.h>
 #include <stdlib.h> // for atoi
+#include "metrics.h"
+#include "fqbatch.h"
+#include "qenc.h"
+#include "pairs.h"
 
 using namespace std;
 
@@ -17,22 +22,23 @@ using namespace std;
 //=============================================================================
 #define LINE_BUF_SIZE 10000
 #define QSCORE_SIZE 42
-#define QCharOffset 33
 #define SEQ_SIZE 400
 #define HiQCellSize 200
 #define DefalutHiQTh 20
+#define NoMaxEE -1.0 // no EE filter
 
 //=============================================================================
 // Select PEs By LowQPercent
-bool peSelect_HiQ(char *r1, char *r2, char *outPrjName, double HiQPercentTh, char HiQTh)
+bool peSelect_HiQ(char *r1, char *r2, char *outPrjName, double HiQPercentTh, char HiQTh, double MaxEE, int Phred)
 {
-	FILE *fp1, *fp2, *fpo1, *fpo2, *fpcsv;
-	char line_buf[LINE_BUF_SIZE], line_buf2[LINE_BUF_SIZE];
+	FILE *fpcsv;
+	FqWriter out1, out2;
 	double TotalLen = 0.0, sTotalLen = 0.0; // Total length of all output sequences
 	size_t PECount = 0, sPECount = 0; // # of PE sequences
 	size_t line = 0; // # of fq lines
 	char tmps[512];
 	double Qsum = 0.0, sQsum = 0.0;
+	double EEsum = 0.0, sEEsum = 0.0; // expected errors of all reads
 	size_t MinSeqLen, sMinSeqLen;
 	size_t MaxSeqLen, sMaxSeqLen;
 	MinSeqLen = sMinSeqLen = LINE_BUF_SIZE;
@@ -40,19 +46,29 @@ bool peSelect_HiQ(char *r1, char *r2, char *outPrjName, double HiQPercentTh, cha
 	char outFiles[LINE_BUF_SIZE];
 
 	// Open files
-	fp1 = fopen(r1, "rt");
-	if (fp1 == NULL)
+	FqReader in1;
+	if (!in1.Open(r1))
 	{
 		printf("Read FQ File 1 Error!\n");
 		return false;
 	}
 
-	fp2 = fopen(r2, "rt");
-	if (fp2 == NULL)
+	FqReader in2;
+	if (!in2.Open(r2))
 	{
 		printf("Read FQ File 2 Error!\n");
 		return false;
 	}
+	// both files are taken to share the encoding of r1
+	QEncoding enc;
+	size_t probeLen;
+	const char *probe = in1.Buffered(probeLen);
+	enc.Detect(probe, probeLen, QSCORE_SIZE-1, Phred);
+	enc.Print(stdout);
+	printf("Input I/O: %s\n", in1.Backend());
+	size_t BadQ = 0; // Q characters outside the encoding, counted as Q0
+	PairStat Pair; // mate names
+	Pair.Init();
 
 	sprintf(tmps, "%s.csv", outPrjName);
 	fpcsv = fopen(tmps, "wt");
@@ -64,8 +80,7 @@ bool peSelect_HiQ(char *r1, char *r2, char *outPrjName, double HiQPercentTh, cha
 	sprintf(outFiles, "%s", tmps);
 
 	sprintf(tmps, "%s-r1.fq", outPrjName);
-	fpo1 = fopen(tmps, "wt");
-	if (fpo1 == NULL)
+	if (!out1.Open(tmps))
 	{
 		printf("Open r1 OUT File (%s) Error!\n", tmps);
 		return false;
@@ -73,131 +88,115 @@ bool peSelect_HiQ(char *r1, char *r2, char *outPrjName, double HiQPercentTh, cha
 	sprintf(outFiles, "%s,%s", outFiles, tmps);
 
 	sprintf(tmps, "%s-r2.fq", outPrjName);
-	fpo2 = fopen(tmps, "wt");
-	if (fpo2 == NULL)
+	if (!out2.Open(tmps))
 	{
 		printf("Open r2 OUT File (%s) Error!\n", tmps);
 		return false;
 	}
 	sprintf(outFiles, "%s,%s", outFiles, tmps);
 
-	// Read the file and select
-	string fqrec1[4], fqrec2[4]; // line 1-4
-	while (fgets(line_buf, LINE_BUF_SIZE, fp1) != NULL && fgets(line_buf2, LINE_BUF_SIZE, fp2) != NULL) // get the 1st line per 4 lines
+	// Read the files in batches of PEs and select
+	FqBatchPool pool;
+	size_t line2 = 0;
+	for (;;)
 	{
-		// line 1
-		line++;
-		if (line_buf[0] != '@' || line_buf2[0] != '@') // Is not the 1st title line
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
-		fqrec1[0] = line_buf;
-		fqrec2[0] = line_buf2;
-
-		// line 2
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL || fgets(line_buf2, LINE_BUF_SIZE, fp2) == NULL) // get the 2nd line: the seq. If fails
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
+		FqBatch *b1 = pool.Get(), *b2 = pool.Get();
+		if (!FillPairs(*b1, *b2, in1, in2, line, line2))
 			return false;
-		}
-		fqrec1[1] = line_buf;
-		fqrec2[1] = line_buf2;
-		
-		strtok(line_buf, "\n");
-		strtok(line_buf2, "\n");
-		size_t SeqLen1 = strlen(line_buf);
-		size_t SeqLen2 = strlen(line_buf2);
-
-		size_t tmpi = MIN(SeqLen1, SeqLen2);
-		MinSeqLen = MIN(MinSeqLen, tmpi);
-		tmpi = MAX(SeqLen1, SeqLen2);
-		MaxSeqLen = MAX(MaxSeqLen, tmpi);
-
-		// line 3
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL || line_buf[0] != '+' || fgets(line_buf2, LINE_BUF_SIZE, fp2) == NULL || line_buf2[0] != '+') // get the 3rd line: the q title. If fails
+		size_t NumPE = b1->Count;
+		// the Q histogram kernel of the batches' read length
+		size_t FixedLen = (b1->FixedLen() == b2->FixedLen()) ? b1->FixedLen() : 0;
+		void (*QHistOf)(const unsigned char *, size_t, const QEncoding &, int []) = FQB_FIXED_PICK(FixedLen, CountQHist);
+		for (size_t r=0; r<NumPE; r++)
 		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
-		fqrec1[2] = line_buf;
-		fqrec2[2] = line_buf2;
+			// read 1 & 2
+			const unsigned char *qual1 = (const unsigned char *)b1->Qual(r), *qual2 = (const unsigned char *)b2->Qual(r);
+			Pair.AddNames(*b1, *b2, r);
+			size_t SeqLen1 = b1->SeqLen[r], SeqLen2 = b2->SeqLen[r];
+			size_t QLen1 = SeqLen1, QLen2 = SeqLen2;
+
+			size_t tmpi = MIN(SeqLen1, SeqLen2);
+			MinSeqLen = MIN(MinSeqLen, tmpi);
+			tmpi = MAX(SeqLen1, SeqLen2);
+			MaxSeqLen = MAX(MaxSeqLen, tmpi);
 
-		// line 4
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL || fgets(line_buf2, LINE_BUF_SIZE, fp2) == NULL) // get the 4th line: the qscore. If fails
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
-		fqrec1[3] = line_buf;
-		fqrec2[3] = line_buf2;
-
-		strtok(line_buf, "\n");
-		strtok(line_buf2, "\n");
-		size_t QLen1 = strlen(line_buf);
-		size_t QLen2 = strlen(line_buf2);
-		if (QLen1 != SeqLen1 || QLen2 != SeqLen2)
-		{
-			printf("FASTQ file format error at line#%lu: incorrect length of Q-string\n", line);
-			return false;
-		}
+			// Q histograms of read 1 & 2; %HighQ, Q sum and EE all come from them
+			int QHist1[QHIST_SIZE] = {0}, QHist2[QHIST_SIZE] = {0};
+			QHistOf(qual1, QLen1, enc, QHist1);
+			QHistOf(qual2, QLen2, enc, QHist2);
+			BadQ += FoldBadQ(QHist1) + FoldBadQ(QHist2);
 
-		double tmpPEQsum = 0.0;
-		int HiQCnt1 = 0, HiQCnt2 = 0;
-		for (size_t i=0; i<QLen1; i++)
-		{
-			char tmpq = line_buf[i]-QCharOffset;
-			if (tmpq >= HiQTh)
-				HiQCnt1 ++;
-			tmpPEQsum += (double)tmpq;
-		}
-		for (size_t i=0; i<QLen2; i++)
-		{
-			char tmpq = line_buf2[i]-QCharOffset;
-			if (tmpq >= HiQTh)
-				HiQCnt2 ++;
-			tmpPEQsum += (double)tmpq;
-		}
-		Qsum += tmpPEQsum;
-		PECount++;
-		TotalLen += (double)(SeqLen1+SeqLen2);
-		double hiqp = (int)floor(HiQCellSize*MIN((double)HiQCnt1/(double)QLen1, (double)HiQCnt2/(double)QLen2)) * 100.0 / HiQCellSize;
-//		printf("lowqp=%f\n", lowqp); getchar();
-		if (hiqp >= HiQPercentTh)
-		{
-			// output 
-			for (int i=0; i < 4; i++)
+			double tmpPEQsum = 0.0;
+			int HiQCnt1 = 0, HiQCnt2 = 0;
+			for (int q=0; q<QERR_TABLE_SIZE; q++)
 			{
-				fprintf(fpo1, "%s", fqrec1[i].c_str());
-				fprintf(fpo2, "%s", fqrec2[i].c_str());
+				tmpPEQsum += (double)q * (double)(QHist1[q] + QHist2[q]);
+				if (q >= HiQTh)
+				{
+					HiQCnt1 += QHist1[q];
+					HiQCnt2 += QHist2[q];
+				}
+			}
+			double ee1 = QErrSum(QHist1, QERR_TABLE_SIZE), ee2 = QErrSum(QHist2, QERR_TABLE_SIZE);
+			Qsum += tmpPEQsum;
+			EEsum += ee1 + ee2;
+			PECount++;
+			TotalLen += (double)(SeqLen1+SeqLen2);
+			double hiqp = (int)floor(HiQCellSize*MIN((double)HiQCnt1/(double)QLen1, (double)HiQCnt2/(double)QLen2)) * 100.0 / HiQCellSize;
+	//		printf("lowqp=%f\n", lowqp); getchar();
+			if (hiqp >= HiQPercentTh && (MaxEE < 0 || MAX(ee1, ee2) <= MaxEE))
+			{
+				// output 
+				out1.Write(b1->Record(r), b1->RecordLen(r));
+				out2.Write(b2->Record(r), b2->RecordLen(r));
+				sPECount++;
+				sTotalLen += (double)(SeqLen1+SeqLen2);
+				sQsum += tmpPEQsum;
+				sEEsum += ee1 + ee2;
+
+				tmpi = MIN(SeqLen1, SeqLen2);
+				sMinSeqLen = MIN(sMinSeqLen, tmpi);
+				tmpi = MAX(SeqLen1, SeqLen2);
+				sMaxSeqLen = MAX(sMaxSeqLen, tmpi);
 			}
-			sPECount++;
-			sTotalLen += (double)(SeqLen1+SeqLen2);
-			sQsum += tmpPEQsum;
-
-			tmpi = MIN(SeqLen1, SeqLen2);
-			sMinSeqLen = MIN(sMinSeqLen, tmpi);
-			tmpi = MAX(SeqLen1, SeqLen2);
-			sMaxSeqLen = MAX(sMaxSeqLen, tmpi);
 		}
-
+		pool.Put(b1);
+		pool.Put(b2);
+		if (NumPE == 0)
+			break;
+	}
+	in1.Close();
+	in2.Close();
+	if (in1.Err || in2.Err)
+	{
+		printf("Read FQ File %d Error!\n", in1.Err ? 1 : 2);
+		return false;
+	}
+	bool ok1 = out1.Close(), ok2 = out2.Close();
+	if (!ok1 || !ok2)
+	{
+		printf("Write OUT FQ File Error!\n");
+		return false;
 	}
-	fclose(fp1);
-	fclose(fp2);
-	fclose(fpo1);
-	fclose(fpo2);
 
 	// Start outputing
 	sprintf(tmps, "--- Summary ---\n");
 	fputs(tmps, stdout);
 	fputs(tmps, fpcsv);
 
+	if (BadQ > 0)
+		printf("Warning: %lu Q characters outside Phred+%d, counted as Q0\n", BadQ, enc.Offset);
+	Pair.Warn(stdout);
+
 	sprintf(tmps, "PE's '%%HighQ(%d) >= %.1f\n", HiQTh, HiQPercentTh);
 	fputs(tmps, stdout);
 	fputs(tmps, fpcsv);
+	if (MaxEE >= 0)
+	{
+		sprintf(tmps, "PE's EE of both reads <= %.2f\n", MaxEE);
+		fputs(tmps, stdout);
+		fputs(tmps, fpcsv);
+	}
 
 	sprintf(tmps, "Name,Original,Subset,Sub/Ori\n");
 	fputs(tmps, stdout);
@@ -232,6 +231,44 @@ bool peSelect_HiQ(char *r1, char *r2, char *outPrjName, double HiQPercentTh, cha
 	fputs(tmps, stdout);
 	fputs(tmps, fpcsv);
 
+	// Q of the mean error probability
+	tmpf = -10.0*log10(EEsum/TotalLen);
+	tmpf2 = -10.0*log10(sEEsum/sTotalLen);
+	sprintf(tmps, "BasePhredMean,%.1f,%.1f,%.1f%%\n", tmpf, tmpf2, 100.0*tmpf2/tmpf);
+	fputs(tmps, stdout);
+	fputs(tmps, fpcsv);
+
+	tmpf = EEsum/(double)(PECount*2);
+	tmpf2 = sEEsum/(double)(sPECount*2);
+	sprintf(tmps, "ReadEEmean,%.2f,%.2f,%.1f%%\n", tmpf, tmpf2, 100.0*tmpf2/tmpf);
+	fputs(tmps, stdout);
+	fputs(tmps, fpcsv);
+
+	// metrics
+	string in = string(r1) + "," + r2;
+	Metrics met("peQsubset", in.c_str());
+	met.AddInt("highq_q", HiQTh);
+	met.AddReal("highq_min_pct", HiQPercentTh);
+	met.AddReal("max_ee", MaxEE >= 0 ? MaxEE : NAN);
+	met.AddInt("pairs", PECount);
+	met.AddInt("pairs_kept", sPECount);
+	met.AddPct("pairs_kept_pct", (double)sPECount, (double)PECount);
+	met.AddInt("bases", (size_t)TotalLen);
+	met.AddInt("bases_kept", (size_t)sTotalLen);
+	met.AddPct("bases_kept_pct", sTotalLen, TotalLen);
+	met.AddReal("base_q_mean", TotalLen > 0 ? Qsum/TotalLen : NAN);
+	met.AddReal("base_q_mean_kept", sTotalLen > 0 ? sQsum/sTotalLen : NAN);
+	met.AddReal("phred_mean", TotalLen > 0 ? -10.0*log10(EEsum/TotalLen) : NAN);
+	met.AddReal("phred_mean_kept", sTotalLen > 0 ? -10.0*log10(sEEsum/sTotalLen) : NAN);
+	met.AddReal("ee_per_read_mean", PECount ? EEsum/(double)(PECount*2) : NAN);
+	met.AddReal("ee_per_read_mean_kept", sPECount ? sEEsum/(double)(sPECount*2) : NAN);
+	met.AddInt("q_offset", enc.Offset);
+	met.AddInt("invalid_q_bases", BadQ);
+	met.AddInt("name_mismatch_pairs", Pair.NameMismatch);
+	if (!met.Write(outPrjName))
+		return false;
+	sprintf(outFiles+strlen(outFiles), ",%s.metrics.json,%s.metrics.tsv", outPrjName, outPrjName);
+
 	printf("OutFile: %s\n", outFiles);
 	return true;
 }
@@ -242,14 +279,27 @@ bool peSelect_HiQ(char *r1, char *r2, char *outPrjName, double HiQPercentTh, cha
 int main(int argc, char **argv)
 {
 //=============================================================================
-	if(argc != 5 && argc != 6)
+	double MaxEE = NoMaxEE;
+	int Phred = 0;
+	for (; argc >= 7; argc -= 2)
+	{
+		if (strcmp(argv[argc-2], "-e") == 0)
+			MaxEE = atof(argv[argc-1]);
+		else if (strcmp(argv[argc-2], "-p") == 0)
+			Phred = atoi(argv[argc-1]);
+		else
+			break;
+	}
+	if((argc != 5 && argc != 6) || MaxEE < NoMaxEE || (Phred != 0 && Phred != 33 && Phred != 64))
 	{
 		printf("=== peQsubset: Select the PE subset from the input PE FASTQ files by %%HighQ(QTh) ===\n\n");
-		printf("Usage: peQsubset r1.fq r2.fq outPrjName %%HighQ [QTh]\n");
+		printf("Usage: peQsubset r1.fq r2.fq outPrjName %%HighQ [QTh] [-e MaxEE] [-p 33|64]\n");
 		printf("Input: r1.fq (read1 fastq of PE), r2.fq (read2 fastq of PE)\n");
 		printf(" -QTh: Optional. The Q-value lowerbound (Range: 0-41; default 20)\n");
 		printf(" -%%HighQ: The lowerbound percent of read1's/read2's' bases with Q-values >= QTh (Range: 100.0-0.0)\n");
-		printf("Output: outPrjName-r1.fq, outPrjName-r2.fq, outPrjName.csv\n");
+		printf(" -MaxEE: Optional. The upperbound of read1's/read2's expected errors, sum of 10^(-Q/10) over a read\n");
+		printf(" -p: Optional. Quality offset, Phred+33 or Phred+64 (default: detected, Phred+33 if the first reads fit both)\n");
+		printf("Output: outPrjName-r1.fq, outPrjName-r2.fq, outPrjName.csv, outPrjName.metrics.json, outPrjName.metrics.tsv\n");
 		printf("Verson: 0.9 (2017/10) \n");
 		printf("Author: Yu-Jung Chang\n\n");
 
@@ -257,10 +307,9 @@ int main(int argc, char **argv)
 	}
 
 //=============================================================================
-	if (argc == 5)
-		peSelect_HiQ(argv[1], argv[2], argv[3], atof(argv[4]), DefalutHiQTh);
-	else if (argc == 6)
-		peSelect_HiQ(argv[1], argv[2], argv[3], atof(argv[4]), (char)atoi(argv[5]));
+	char HiQTh = (argc == 6) ? (char)atoi(argv[5]) : DefalutHiQTh;
+	if (!peSelect_HiQ(argv[1], argv[2], argv[3], atof(argv[4]), HiQTh, MaxEE, Phred))
+		return 1;
 
 //=============================================================================
 	return 0;
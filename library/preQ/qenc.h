@@ -0,0 +1,143 @@
+/*
+== Quality encoding of FASTQ files; update: 2026/10
+The offset (Phred+33 or Phred+64) is detected from the Q lines of the first reads,
+or given by the user when those fit both.
+Q characters are only used through the 256-entry tables of QEncoding, so any byte,
+including one outside the encoding, indexes in bounds.
+Files with at most QBIN_MAX_LEVELS Q values (binned qualities, e.g. 4 on NovaSeq)
+also get a level index per character for the binned counting kernels.
+*/
+//=============================================================================
+#ifndef SQUAT_QENC_H
+#define SQUAT_QENC_H
+
+#include <stdio.h>
+#include <string.h>
+#include "qerr.h"
+
+#define QENC_PROBE_READS 10000 // reads looked at for the detection
+#define QBAD_BIN QERR_TABLE_SIZE // histogram bin of characters outside the encoding
+#define QHIST_SIZE (QERR_TABLE_SIZE+1) // Q 0-93 and QBAD_BIN
+#define QBIN_MAX_LEVELS 8 // binned kernel up to this many Q values, a power of 2
+#define QBIN_MISS 0x80 // level of a Q value the binned kernel has no counter for
+
+//=============================================================================
+struct QEncoding
+{
+	int Offset; // 33 or 64
+	unsigned char Bin[256]; // char -> histogram bin: Q 0-93, QBAD_BIN if outside the encoding
+	unsigned char Val[256]; // char -> Q value for sums, 0 if outside the encoding
+	unsigned char Clamp[256]; // char -> Q value capped to the tool's top bin
+	int NumLevels; // > 0: binned, Level/LevelBin/LevelClamp are valid
+	unsigned char Level[256]; // char -> level 0..NumLevels-1, QBIN_MISS otherwise
+	unsigned char LevelBin[QBIN_MAX_LEVELS]; // histogram bin of each level
+	unsigned char LevelClamp[QBIN_MAX_LEVELS]; // capped Q value of each level
+	size_t ProbeReads;
+	bool Guessed; // the probed reads fit both offsets
+
+	void Init(int offset, int maxQ)
+	{
+		Offset = offset;
+		for (int c=0; c < 256; c++)
+		{
+			int q = c - offset;
+			bool ok = (q >= 0 && q < QERR_TABLE_SIZE && c != '\n');
+			Bin[c] = ok ? q : QBAD_BIN;
+			Val[c] = ok ? q : 0;
+			Clamp[c] = ok ? (q < maxQ ? q : maxQ) : 0;
+			Level[c] = QBIN_MISS;
+		}
+		NumLevels = 0;
+	}
+
+	// offset from the first reads in buf (the bytes the reader already holds, the file
+	// is not opened again, so pipes work); binned levels if they use few Q values
+	// maxQ: the top bin of the tool's Q arrays (QSCORE_SIZE-1); offset: 33 or 64 to force, 0 to detect
+	void Detect(const char *buf, size_t len, int maxQ, int offset = 0)
+	{
+		size_t seen[256] = {0};
+		int line = 0;
+		ProbeReads = 0;
+		// the 4th line of each record
+		for (size_t i=0; i < len && ProbeReads < QENC_PROBE_READS; i++)
+		{
+			unsigned char c = (unsigned char)buf[i];
+			if (c == '\n')
+			{
+				if (++line % 4 == 0)
+					ProbeReads++;
+			}
+			else if (line % 4 == 3)
+				seen[c]++;
+		}
+
+		int minc = 256, maxc = -1, distinct = 0;
+		for (int i=0; i < 256; i++)
+			if (seen[i] && i != '\r')
+			{
+				minc = (i < minc ? i : minc);
+				maxc = i;
+				distinct++;
+			}
+		// Phred+33 reaches below ';' and rarely above 'J'/'K' (Q41/42); Phred+64 (and Solexa+64,
+		// Q -5..-1 as 0) starts at ';'/'@' and goes above 'K' from Q12 on. Anything else, e.g.
+		// Phred+33 reads with only Q26+ (';'..'J'), is ambiguous and taken as Phred+33.
+		Guessed = false;
+		if (offset != 33 && offset != 64)
+		{
+			if (minc < 59)
+				offset = 33;
+			else if (maxc > 'K')
+				offset = 64;
+			else
+			{
+				offset = 33;
+				Guessed = (distinct > 0 && minc >= '@');
+			}
+		}
+		Init(offset, maxQ);
+		if (Offset == 64)
+			for (int i=59; i < 64; i++)
+				Bin[i] = Val[i] = Clamp[i] = 0;
+
+		if (distinct > 0 && distinct <= QBIN_MAX_LEVELS)
+			for (int i=0; i < 256; i++)
+				if (seen[i] && i != '\r')
+				{
+					Level[i] = NumLevels;
+					LevelBin[NumLevels] = Bin[i];
+					LevelClamp[NumLevels++] = Clamp[i];
+				}
+	}
+
+	void Print(FILE *fp) const
+	{
+		if (NumLevels > 0)
+			fprintf(fp, "Quality encoding: Phred+%d, binned (%d levels)\n", Offset, NumLevels);
+		else
+			fprintf(fp, "Quality encoding: Phred+%d\n", Offset);
+		if (Guessed)
+			fprintf(fp, "Quality encoding: the first reads fit Phred+33 and Phred+64, Phred+33 assumed (-p 64 to override)\n");
+	}
+};
+
+// Q histogram of a read's len Q characters; L: the length at compile time, 0 for len
+template <size_t L>
+inline void CountQHist(const unsigned char *qs, size_t len, const QEncoding &enc, int QHist[])
+{
+	if (L)
+		len = L;
+	for (size_t i=0; i<len; i++)
+		QHist[enc.Bin[qs[i]]]++;
+}
+
+// Fold a read's histogram into Q bins: bad characters count as Q0, returns their number
+inline int FoldBadQ(int QHist[])
+{
+	int bad = QHist[QBAD_BIN];
+	QHist[0] += bad;
+	QHist[QBAD_BIN] = 0;
+	return bad;
+}
+
+#endif
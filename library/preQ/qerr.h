@@ -0,0 +1,75 @@
+/*
+== Expected errors and Phred means of reads; update: 2026/10
+EE (expected errors) of a read = sum over its bases of 10^(-Q/10)
+Phred mean of a read = -10*log10(EE/#bases), i.e. the Q of its mean error probability,
+which is lower than the arithmetic mean of the Q values whenever they spread.
+The error probabilities come from a constexpr table of the 94 printable Q characters.
+*/
+//=============================================================================
+#ifndef SQUAT_QERR_H
+#define SQUAT_QERR_H
+
+#include <math.h>
+
+#define QERR_TABLE_SIZE 94 // Q 0-93, '!'-'~' in Phred+33
+#define EE_CELL 0.1 // width of the EE histogram cells
+#define EE_CELLS 201 // EE 0-20 by EE_CELL, the last cell holds everything above
+
+//=============================================================================
+// 10^(-b/10), b = 0-9
+constexpr double QErrTenth[10] = {
+	1.0, 0.79432823472428150, 0.63095734448019325, 0.50118723362727224, 0.39810717055349725,
+	0.31622776601683793, 0.25118864315095801, 0.19952623149688797, 0.15848931924611135, 0.12589254117941673
+};
+
+struct QErrTable
+{
+	double p[QERR_TABLE_SIZE];
+
+	constexpr QErrTable() : p()
+	{
+		for (int q=0; q < QERR_TABLE_SIZE; q++)
+		{
+			double v = QErrTenth[q % 10];
+			for (int k=0; k < q/10; k++)
+				v *= 0.1;
+			p[q] = v;
+		}
+	}
+};
+
+constexpr QErrTable QErr; // QErr.p[q] = 10^(-q/10)
+
+//=============================================================================
+// EE of a read from its Q histogram (n bins, n <= QERR_TABLE_SIZE): a fixed-length dot
+// product with 4 independent partial sums, so it vectorizes without reordering the additions
+inline double QErrSum(const int QHist[], int n)
+{
+	double acc[4] = {0.0, 0.0, 0.0, 0.0};
+	int q = 0;
+	for (; q+4 <= n; q+=4)
+		for (int k=0; k < 4; k++)
+			acc[k] += (double)QHist[q+k] * QErr.p[q+k];
+	for (; q < n; q++)
+		acc[0] += (double)QHist[q] * QErr.p[q];
+	return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+// Phred mean from EE over len bases, rounded and capped to 0-maxQ
+inline int PhredMean(double ee, size_t len, int maxQ)
+{
+	if (len == 0)
+		return 0;
+	if (ee <= 0)
+		return maxQ;
+	int q = (int)floor(-10.0*log10(ee/(double)len) + 0.5);
+	return q < 0 ? 0 : (q > maxQ ? maxQ : q);
+}
+
+inline int EECell(double ee)
+{
+	int i = (int)(ee / EE_CELL);
+	return i < EE_CELLS-1 ? i : EE_CELLS-1;
+}
+
+#endif
@@ -1,6 +1,8 @@
 /*
-== Author: Yu-Jung Chang; update: 2018/04
+== Author: Yu-Jung Chang; update: 2026/10
 Read single FASTQ file and generate quality distribution of the data
+Summary numbers go to outPrjName.metrics.json/.tsv as well (see metrics.h)
+The report is a single self-contained html file (see htmchart.h)
 */
 //=============================================================================
 #include <stdio.h>
@@ -8,7 +10,18 @@ Read single FASTQ file and generate quality distribution of the data
 #include <vector>
 #include <math.h>
 #include <string>
+#include <map>
+#include <memory> // for unique_ptr
 #include <time.h>
+#include "htmchart.h"
+#include "metrics.h"
+#include "fqbatch.h"
+#include "wsched.h"
+#include "hiq.h"
+#include "qerr.h"
+#include "qenc.h"
+#include "triage.h"
+#include "kscreen.h"
 //#include <algorithm> // for heap
 //#include <stdlib.h> // for qsort
 
@@ -21,12 +34,9 @@ using namespace std;
 #define LINE_BUF_SIZE 10000
 #define ALPHABET_SIZE 256
 #define QSCORE_SIZE 42
-#define QCharOffset 33
 #define SEQ_SIZE 400
-#define HiQCellSize 200
-
-#define HiQParamSize 2
-int HiQTh[HiQParamSize] = {15, 20};
+#define MAX_TILE 1000 // tiles with a per-position quality row
+#define TILE_NAME_SIZE 32 // lane:tile with its NUL
 
 //=============================================================================
 int cmpchar(const void *arg1, const void *arg2)
@@ -96,76 +106,237 @@ string GetFilePrefix(string s)
 		return(s);
 }
 
+// Illumina lane:tile of a read title, "@inst:run:flowcell:lane:tile:x:y ..." or "@inst:lane:tile:x:y#...",
+// into name (size bytes, NUL-terminated); its length, 0 if none. Nothing is allocated, it runs per read
+size_t GetTileName(const char *title, char *name, size_t size)
+{
+	size_t len = strcspn(title, " \t\n");
+	size_t sep[8], n = 1; // field k lies between sep[k] and sep[k+1]
+	sep[0] = 0;
+	for (size_t i=1; i<len; i++)
+		if (title[i] == ':')
+		{
+			if (n == 7) // more than 7 fields
+				return 0;
+			sep[n++] = i;
+		}
+	sep[n++] = len;
+
+	size_t lane;
+	if (n == 8) // 7 fields
+		lane = 3;
+	else if (n == 6) // 5 fields
+		lane = 1;
+	else
+		return 0;
+
+	size_t b = sep[lane]+1, k = sep[lane+2]-b;
+	if (k == 0 || k >= size)
+		return 0;
+	for (size_t i=0; i<k; i++)
+		if ((title[b+i] < '0' || title[b+i] > '9') && title[b+i] != ':')
+			return 0;
+	memcpy(name, title+b, k);
+	name[k] = '\0';
+	return k;
+}
+
+// Smallest q with at least p of the n counts at or below it
+int HistPercentile(const size_t hist[], size_t n, double p)
+{
+	size_t cumuCnt = 0;
+	for (int q=0; q<QSCORE_SIZE; q++)
+	{
+		cumuCnt += hist[q];
+		if (cumuCnt >= p*n)
+			return q;
+	}
+	return QSCORE_SIZE-1;
+}
+
 //=============================================================================
-bool ProbeFASTQ(char *r1, char *outPrjName)
+// Q counting kernels of one read: its histogram (QHIST_SIZE bins), the per-position counts
+// and the Q sums of the first SEQ_SIZE positions of its tile (TileSum NULL: no tile).
+// L: the read length at compile time (FQB_FIXED_CALL), 0 for len
+
+// any Q characters, through the tables of the encoding
+template <size_t L>
+void CountQ(const unsigned char *qs, size_t len, const QEncoding &enc, int ReadQHist[], size_t *PosQ, double *TileSum, size_t *TileCnt)
 {
-	FILE *fp1, *fphtm;
-//	FILE *fpout;
-	char line_buf[LINE_BUF_SIZE];
-	char OutHTM[1024];
-//	char OutCSV[1024];
-	size_t AlphabetCount[ALPHABET_SIZE] = {0}; // counting alphabet occurrence
-	size_t TotalLen = 0; // Total length of all sequences
-	size_t ReadCount = 0; // # of read sequences
-	size_t line = 0; // # of lines
-	size_t MinSeqLen = LINE_BUF_SIZE;
-	size_t MaxSeqLen = 0;
+	if (L)
+		len = L;
+	for (size_t i=0; i<len; i++)
+	{
+		ReadQHist[enc.Bin[qs[i]]]++;
+		PosQ[i*QSCORE_SIZE+enc.Clamp[qs[i]]]++;
+	}
+	if (TileSum != NULL)
+		for (size_t i=0; i<len && i<SEQ_SIZE; i++)
+		{
+			TileSum[i] += enc.Val[qs[i]];
+			TileCnt[i]++;
+		}
+}
 
-	size_t QCount[QSCORE_SIZE] = {0}; // counting Q scores
-	size_t MinQCount[QSCORE_SIZE] = {0}; // counting MinQ scores
+// binned Q characters: QBIN_MAX_LEVELS counters per position instead of QSCORE_SIZE.
+// false, with nothing counted, if the read has a character without a level
+template <size_t L>
+bool CountQBinned(const unsigned char *qs, size_t len, const QEncoding &enc, int ReadQHist[], size_t *PosL, double *TileSum, size_t *TileCnt)
+{
+	if (L)
+		len = L;
+	int LevelHist[QBIN_MAX_LEVELS] = {0};
+	unsigned char miss = 0;
+	for (size_t i=0; i<len; i++)
+	{
+		unsigned char l = enc.Level[qs[i]];
+		miss |= l;
+		l &= QBIN_MAX_LEVELS-1;
+		LevelHist[l]++;
+		PosL[i*QBIN_MAX_LEVELS+l]++;
+	}
+	if (miss & QBIN_MISS)
+	{
+		for (size_t i=0; i<len; i++)
+			PosL[i*QBIN_MAX_LEVELS+(enc.Level[qs[i]] & (QBIN_MAX_LEVELS-1))]--;
+		return false;
+	}
+	for (int l=0; l<enc.NumLevels; l++)
+		ReadQHist[enc.LevelBin[l]] += LevelHist[l];
+	if (TileSum != NULL)
+		for (size_t i=0; i<len && i<SEQ_SIZE; i++)
+		{
+			TileSum[i] += enc.Val[qs[i]];
+			TileCnt[i]++;
+		}
+	return true;
+}
+
+// per-position level counts added into the per-position Q counts
+void LevelsToPosQ(const vector<size_t> &PosL, const QEncoding &enc, vector<size_t> &PosQ)
+{
+	size_t NumPos = PosL.size() / QBIN_MAX_LEVELS;
+	if (PosQ.size() < NumPos*QSCORE_SIZE)
+		PosQ.resize(NumPos*QSCORE_SIZE, 0);
+	for (size_t i=0; i<NumPos; i++)
+		for (int l=0; l<enc.NumLevels; l++)
+			PosQ[i*QSCORE_SIZE+enc.LevelClamp[l]] += PosL[i*QBIN_MAX_LEVELS+l];
+}
+
+//=============================================================================
+// statistics of the reads one worker counted; the workers' are merged once at the end
+struct ReadQAcc
+{
+	size_t AlphabetCount[ALPHABET_SIZE]; // counting alphabet occurrence
+	size_t TotalLen; // Total length of all sequences
+	size_t ReadCount; // # of read sequences
+	size_t MinSeqLen;
+	size_t MaxSeqLen;
+
+	size_t QCount[QSCORE_SIZE]; // counting Q scores
+	size_t MinQCount[QSCORE_SIZE]; // counting MinQ scores
 
 	// for HiQ%
-	size_t HiQPercentCount[HiQParamSize][HiQCellSize+1] = {0};
-	
-	// for GC%
-	size_t CntGCRead[101] = {0}; // Counts of GC% for read
+	HiQStat HiQ;
+	vector<double> HiQFrac;
 
-	// Open files
-	fp1 = fopen(r1, "rt");
-	if (fp1 == NULL)
+	// for GC%
+	size_t CntGCRead[101]; // Counts of GC% for read
+
+	// expected errors (EE) of reads, see qerr.h
+	double TotalEE;
+	size_t EECount[EE_CELLS]; // reads by EE cell
+	size_t EELe[2]; // reads with EE <= 1, <= 2
+	size_t PhredCount[QSCORE_SIZE]; // reads by Phred mean
+
+	// own copy: a Q value outside the binned levels switches only this worker to the full kernel
+	QEncoding enc;
+	// Q counts per position, QSCORE_SIZE per position
+	vector<size_t> PosQCount;
+	// binned qualities: level counts per position, QBIN_MAX_LEVELS per position
+	vector<size_t> PosLCount;
+	size_t BadQ; // Q characters outside the encoding, counted as Q0
+	// per-tile Q sums and base counts of the first SEQ_SIZE positions
+	map<string, int> TileIdx;
+	vector< vector<double> > TileQSum;
+	vector< vector<size_t> > TileQCnt;
+	// tile of the last read: runs of reads share it, so the map is only looked up when it changes
+	char LastTile[TILE_NAME_SIZE];
+	size_t LastTileLen;
+	int LastTileIdx;
+	// contamination screen (kscreen.h), NULL if none: reads hitting each contaminant
+	const KScreen *Screen;
+	vector<size_t> ScreenHits;
+	vector<Minimizer> MzBuf;
+
+	void Init(const HiQStat &hiq, const QEncoding &e, const KScreen *screen)
 	{
-		printf("Read FQ File 1 Error!\n");
-		return false;
+		memset(AlphabetCount, 0, sizeof(AlphabetCount));
+		TotalLen = ReadCount = 0;
+		MinSeqLen = LINE_BUF_SIZE;
+		MaxSeqLen = 0;
+		memset(QCount, 0, sizeof(QCount));
+		memset(MinQCount, 0, sizeof(MinQCount));
+		HiQ = hiq;
+		HiQFrac.resize(HiQ.Th.size());
+		memset(CntGCRead, 0, sizeof(CntGCRead));
+		TotalEE = 0.0;
+		memset(EECount, 0, sizeof(EECount));
+		memset(EELe, 0, sizeof(EELe));
+		memset(PhredCount, 0, sizeof(PhredCount));
+		enc = e;
+		BadQ = 0;
+		LastTileLen = 0; // no tile
+		LastTileIdx = -1;
+		Screen = screen;
+		ScreenHits.assign(Screen ? Screen->Names.size() : 0, 0);
 	}
-/*
-	sprintf(OutCSV, "%s.csv", outPrjName);
-	fpout = fopen(OutCSV, "wt");
-	if (fpout == NULL)
+
+	// reads [begin, end) of batch b, by the kernels of their length
+	void AddRange(const FqBatch &b, size_t begin, size_t end)
 	{
-		printf("Open OUT CSV File Error!\n");
-		return false;
+		FQB_FIXED_CALL(b.FixedLen(), AddLen, b, begin, end);
 	}
-*/
-	sprintf(OutHTM, "%s.htm", outPrjName);
-	fphtm = fopen(OutHTM, "wt");
-	if (fphtm == NULL)
+
+	// L: every read of b is that long, 0 for any length
+	template <size_t L>
+	void AddLen(const FqBatch &b, size_t begin, size_t end)
 	{
-		printf("Open OUT HTM File Error!\n");
-		return false;
+		for (size_t r=begin; r<end; r++)
+			Add<L>(b, r);
 	}
 
-	// Read the file and check
-	while (fgets(line_buf, LINE_BUF_SIZE, fp1) != NULL) // get the 1st line per 4 lines
+	// read r of batch b
+	template <size_t L>
+	void Add(const FqBatch &b, size_t r)
 	{
-		// line 1
-		line++;
-		if (line_buf[0] != '@') // Is not the 1st title line
+		// tile of the read
+		char TileName[TILE_NAME_SIZE];
+		size_t TileLen = GetTileName(b.Name(r), TileName, sizeof(TileName));
+		if (TileLen != LastTileLen || memcmp(TileName, LastTile, TileLen) != 0)
 		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
+			LastTileIdx = -1;
+			if (TileLen > 0)
+			{
+				map<string, int>::iterator it = TileIdx.find(TileName);
+				if (it != TileIdx.end())
+					LastTileIdx = it->second;
+				else if (TileIdx.size() < MAX_TILE)
+				{
+					LastTileIdx = TileIdx[TileName] = TileQSum.size();
+					TileQSum.push_back(vector<double>(SEQ_SIZE, 0));
+					TileQCnt.push_back(vector<size_t>(SEQ_SIZE, 0));
+				}
+			}
+			memcpy(LastTile, TileName, TileLen);
+			LastTileLen = TileLen;
 		}
+		int tile = LastTileIdx;
 
-		// line 2
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL) // get the 2nd line: the seq. If fails
-		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
-		}
-		
-		// read 1 & 2
-		strtok(line_buf, "\n");
-		size_t SeqLen1 = strlen(line_buf);
+		// the read
+		const char *seq = b.Seq(r);
+		size_t SeqLen1 = L ? L : b.SeqLen[r];
+		size_t QLen1 = SeqLen1;
 		TotalLen += SeqLen1;
 		ReadCount++;
 
@@ -177,75 +348,390 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 		size_t GCcnt=0, ATcnt=0;
 		for (size_t i=0; i<SeqLen1; i++)
 		{
-			AlphabetCount[line_buf[i]]++;
-			if (line_buf[i] == 'G' || line_buf[i] == 'C')
+			AlphabetCount[(unsigned char)seq[i]]++;
+			if (seq[i] == 'G' || seq[i] == 'C')
 				GCcnt++;
-			else if (line_buf[i] == 'A' || line_buf[i] == 'T')
+			else if (seq[i] == 'A' || seq[i] == 'T')
 				ATcnt++;
 		}
-		GCvalue = (char)round(100.0*(double)GCcnt/(double)(GCcnt+ATcnt));
+		GCvalue = (GCcnt+ATcnt) ? (char)round(100.0*(double)GCcnt/(double)(GCcnt+ATcnt)) : 0;
 		CntGCRead[GCvalue]++;
 //		printf("[%lu] NumGC=%lu, NumAT=%lu, GCvalue=%d\n", PECount, GCcnt[0], ATcnt[0], GCvalue); getchar();
 
-		// line 3
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL || line_buf[0] != '+') // get the 3rd line: the q title. If fails
+		int ReadQHist[QHIST_SIZE] = {0}; // Q histogram of the read
+		const unsigned char *qs = (const unsigned char *)b.Qual(r);
+		double *TileSum = (tile >= 0) ? &TileQSum[tile][0] : NULL;
+		size_t *TileCnt = (tile >= 0) ? &TileQCnt[tile][0] : NULL;
+		bool counted = false;
+		if (enc.NumLevels > 0)
 		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
+			if (PosLCount.size() < QLen1*QBIN_MAX_LEVELS)
+				PosLCount.resize(QLen1*QBIN_MAX_LEVELS, 0);
+			counted = CountQBinned<L>(qs, QLen1, enc, ReadQHist, &PosLCount[0], TileSum, TileCnt);
+			if (!counted) // a Q value the probe did not see: full kernel from here on
+			{
+				LevelsToPosQ(PosLCount, enc, PosQCount);
+				vector<size_t>().swap(PosLCount);
+				enc.NumLevels = 0;
+			}
 		}
-
-		// line 4
-		line++;
-		if (fgets(line_buf, LINE_BUF_SIZE, fp1) == NULL) // get the 4th line: the qscore. If fails
+		if (!counted)
 		{
-			printf("FASTQ file format error at line#%lu\n", line);
-			return false;
+			if (PosQCount.size() < QLen1*QSCORE_SIZE)
+				PosQCount.resize(QLen1*QSCORE_SIZE, 0);
+			CountQ<L>(qs, QLen1, enc, ReadQHist, &PosQCount[0], TileSum, TileCnt);
 		}
-		strtok(line_buf, "\n");
-		size_t QLen1 = strlen(line_buf);
-		if (QLen1 != SeqLen1)
+		BadQ += FoldBadQ(ReadQHist);
+
+		// Q counts and MinQ from the histogram; Q above the top bin is counted in it
+		int minq1 = QERR_TABLE_SIZE-1;
+		for (int q=QERR_TABLE_SIZE-1; q >= 0; q--)
+			if (ReadQHist[q])
+			{
+				QCount[MIN(q, QSCORE_SIZE-1)] += ReadQHist[q];
+				minq1 = q;
+			}
+		MinQCount[MIN(minq1, QSCORE_SIZE-1)]++;
+
+		// for HiQ%
+		HiQ.Fractions(ReadQHist, QERR_TABLE_SIZE, QLen1, &HiQFrac[0]);
+		HiQ.Count(&HiQFrac[0]);
+
+		// for EE and Phred mean
+		double ee = QErrSum(ReadQHist, QERR_TABLE_SIZE);
+		TotalEE += ee;
+		EECount[EECell(ee)]++;
+		EELe[0] += (ee <= 1.0);
+		EELe[1] += (ee <= 2.0);
+		PhredCount[PhredMean(ee, QLen1, QSCORE_SIZE-1)]++;
+
+		if (Screen != NULL)
 		{
-			printf("FASTQ file format error at line#%lu: incorrect length of Q-string\n", line);
-			return false;
+			int ref = Screen->Classify(seq, SeqLen1, MzBuf);
+			if (ref >= 0)
+				ScreenHits[ref]++;
 		}
+	}
+
+	// binned counts into the per-position Q counts
+	void Finish()
+	{
+		if (enc.NumLevels > 0)
+			LevelsToPosQ(PosLCount, enc, PosQCount);
+		vector<size_t>().swap(PosLCount);
+		enc.NumLevels = 0;
+	}
 
-		char minq1 = QSCORE_SIZE-1;
-		int HiQCnt[HiQParamSize] = {0};
+	// add a finished accumulator
+	void Merge(const ReadQAcc &o)
+	{
+		for (int i=0; i<ALPHABET_SIZE; i++)
+			AlphabetCount[i] += o.AlphabetCount[i];
+		TotalLen += o.TotalLen;
+		ReadCount += o.ReadCount;
+		MinSeqLen = MIN(MinSeqLen, o.MinSeqLen);
+		MaxSeqLen = MAX(MaxSeqLen, o.MaxSeqLen);
+		for (int q=0; q<QSCORE_SIZE; q++)
+		{
+			QCount[q] += o.QCount[q];
+			MinQCount[q] += o.MinQCount[q];
+			PhredCount[q] += o.PhredCount[q];
+		}
+		HiQ.Merge(o.HiQ);
+		for (int i=0; i<101; i++)
+			CntGCRead[i] += o.CntGCRead[i];
+		TotalEE += o.TotalEE;
+		for (int i=0; i<EE_CELLS; i++)
+			EECount[i] += o.EECount[i];
+		EELe[0] += o.EELe[0];
+		EELe[1] += o.EELe[1];
+		if (PosQCount.size() < o.PosQCount.size())
+			PosQCount.resize(o.PosQCount.size(), 0);
+		for (size_t i=0; i<o.PosQCount.size(); i++)
+			PosQCount[i] += o.PosQCount[i];
+		BadQ += o.BadQ;
+		for (size_t i=0; i<o.ScreenHits.size(); i++)
+			ScreenHits[i] += o.ScreenHits[i];
+		for (map<string, int>::const_iterator it=o.TileIdx.begin(); it != o.TileIdx.end(); it++)
+		{
+			int tile;
+			map<string, int>::iterator mt = TileIdx.find(it->first);
+			if (mt != TileIdx.end())
+				tile = mt->second;
+			else if (TileIdx.size() < MAX_TILE)
+			{
+				tile = TileIdx[it->first] = TileQSum.size();
+				TileQSum.push_back(vector<double>(SEQ_SIZE, 0));
+				TileQCnt.push_back(vector<size_t>(SEQ_SIZE, 0));
+			}
+			else
+				continue;
+			for (int i=0; i<SEQ_SIZE; i++)
+			{
+				TileQSum[tile][i] += o.TileQSum[it->second][i];
+				TileQCnt[tile][i] += o.TileQCnt[it->second][i];
+			}
+		}
+	}
 
-		for (size_t i=0; i<QLen1; i++)
+	// counts times f, from a triage sample to the whole file; the tile rows only give means
+	void Scale(double f)
+	{
+		for (int i=0; i<ALPHABET_SIZE; i++)
+			AlphabetCount[i] = (size_t)llround(f*AlphabetCount[i]);
+		TotalLen = (size_t)llround(f*TotalLen);
+		ReadCount = (size_t)llround(f*ReadCount);
+		for (int q=0; q<QSCORE_SIZE; q++)
 		{
-			char tmpq = line_buf[i]-QCharOffset;
-			QCount[tmpq]++;
-			minq1 = MIN(minq1, tmpq);
-			for (int j=0; j < HiQParamSize; j++)
-				if (tmpq >= HiQTh[j])
-					HiQCnt[j] ++;
+			QCount[q] = (size_t)llround(f*QCount[q]);
+			MinQCount[q] = (size_t)llround(f*MinQCount[q]);
+			PhredCount[q] = (size_t)llround(f*PhredCount[q]);
 		}
+		HiQ.Scale(f);
+		for (int i=0; i<101; i++)
+			CntGCRead[i] = (size_t)llround(f*CntGCRead[i]);
+		TotalEE *= f;
+		for (int i=0; i<EE_CELLS; i++)
+			EECount[i] = (size_t)llround(f*EECount[i]);
+		EELe[0] = (size_t)llround(f*EELe[0]);
+		EELe[1] = (size_t)llround(f*EELe[1]);
+		for (size_t i=0; i<PosQCount.size(); i++)
+			PosQCount[i] = (size_t)llround(f*PosQCount[i]);
+		BadQ = (size_t)llround(f*BadQ);
+		for (size_t i=0; i<ScreenHits.size(); i++)
+			ScreenHits[i] = (size_t)llround(f*ScreenHits[i]);
+	}
+};
 
-		// for MinQ
-		MinQCount[minq1]++;
+//=============================================================================
+// triage sample (triage.h): per-block sums of the headline metrics, for the bootstrap
+enum { TB_BYTES, TB_READS, TB_BASES, TB_GC, TB_Q30, TB_HIGH, TB_POOR, TB_EE, TB_SIZE };
 
-		// for HiQ%
-		for (int j=0; j < HiQParamSize; j++)
+// the blocks of plan into all, each block counted on its own first
+bool TriageFASTQ(FqReader &in, const TriagePlan &plan, const HiQStat &HiQ, const QEncoding &enc, const KScreen *Screen, ReadQAcc &all, vector<double> Block[TB_SIZE])
+{
+	FqBatchPool pool(1);
+	size_t line = 0; // lines of the sample; a format error is reported with it
+	off_t prevEnd = 0;
+	for (size_t k=0; k<plan.Off.size(); k++)
+	{
+		off_t start = FqSyncRecord(in.fd, MAX(plan.Off[k], prevEnd), plan.FileSize);
+		if (start < 0) // the end of the file, or no record start near the offset
+			continue;
+		off_t stop = start + (off_t)plan.BlockSize;
+		in.Seek(start, plan.BlockSize + FQIO_BLOCK); // one block more for the record across the stop
+		ReadQAcc *blk = new ReadQAcc();
+		blk->Init(HiQ, enc, Screen);
+		FqBatch *b = pool.Get();
+		while (in.Tell() < stop)
 		{
-			// For each PE, decide its HiQ% tile number
-			// LowQ by ceil; HiQ by floor
-			int HiqpTileNo = (int)floor(HiQCellSize*(double)HiQCnt[j]/(double)QLen1);
-			HiQPercentCount[j][HiqpTileNo]++;
+			b->Start(line);
+			while (b->Room() && in.Tell() < stop)
+			{
+				int ret = b->FillRecord(in, line);
+				if (ret < 0)
+				{
+					printf("Triage block at byte %ld Error!\n", (long)start);
+					pool.Put(b);
+					delete blk;
+					return false;
+				}
+				if (ret == 0)
+					break;
+			}
+			if (b->Count == 0)
+				break;
+			blk->AddRange(*b, 0, b->Count);
+		}
+		pool.Put(b);
+		prevEnd = in.Tell();
+		blk->Finish();
+
+		size_t q30 = 0;
+		for (int q=30; q<QSCORE_SIZE; q++)
+			q30 += blk->QCount[q];
+		Block[TB_BYTES].push_back((double)(prevEnd - start));
+		Block[TB_READS].push_back((double)blk->ReadCount);
+		Block[TB_BASES].push_back((double)blk->TotalLen);
+		Block[TB_GC].push_back((double)(blk->AlphabetCount['C'] + blk->AlphabetCount['G']));
+		Block[TB_Q30].push_back((double)q30);
+		Block[TB_HIGH].push_back((double)blk->HiQ.CutCount[blk->HiQ.Th.size()-1][0]);
+		Block[TB_POOR].push_back((double)(blk->ReadCount - blk->HiQ.CutCount[0][blk->HiQ.Cut.size()-1]));
+		Block[TB_EE].push_back(blk->TotalEE);
+		all.Merge(*blk);
+		delete blk;
+	}
+	return true;
+}
 
+//=============================================================================
+bool ProbeFASTQ(char *r1, char *outPrjName, bool WriteHtm, HiQStat &HiQ, int Threads, double TriageMB, const KScreen *Screen, int Phred)
+{
+	FILE *fphtm;
+//	FILE *fpout;
+	char line_buf[LINE_BUF_SIZE];
+	char OutHTM[1024];
+//	char OutCSV[1024];
+	size_t line = 0; // # of lines
+
+	// Open files
+	FqReader in1;
+	if (!in1.Open(r1))
+	{
+		printf("Read FQ File 1 Error!\n");
+		return false;
+	}
+	QEncoding enc;
+	size_t probeLen;
+	const char *probe = in1.Buffered(probeLen);
+	enc.Detect(probe, probeLen, QSCORE_SIZE-1, Phred);
+	enc.Print(stdout);
+	printf("Input I/O: %s\n", in1.Backend());
+	TriagePlan plan;
+	if (TriageMB > 0 && !plan.Init(in1.fd, TriageMB))
+		printf("Triage needs a regular file, reading all of the input\n");
+	if (plan.Sampling())
+	{
+		printf("Triage: %lu blocks of %.1f MB out of %.1f MB\n", plan.Off.size(), plan.BlockSize/1e6, plan.FileSize/1e6);
+		Threads = 1; // the blocks are counted one by one on this thread
+	}
+	printf("Threads: %d\n", Threads);
+	if (Screen != NULL)
+		printf("Screen: %lu references, %.1f kb\n", Screen->Names.size(), Screen->Bases/1e3);
+	int QLevels = enc.NumLevels; // binned levels found by the probe
+/*
+	sprintf(OutCSV, "%s.csv", outPrjName);
+	fpout = fopen(OutCSV, "wt");
+	if (fpout == NULL)
+	{
+		printf("Open OUT CSV File Error!\n");
+		return false;
+	}
+*/
+	// Read the file in batches and check; every worker counts into its own accumulator,
+	// set up by the worker itself so that it lies on the worker's NUMA node
+	vector< unique_ptr<ReadQAcc> > acc(Threads);
+	FqBatchPool pool(2);
+	WsScheduler *ws = NULL;
+	if (Threads > 1)
+		ws = new WsScheduler(Threads, 2, [&acc, &HiQ, &enc, Screen](int w) {
+			acc[w].reset(new ReadQAcc());
+			acc[w]->Init(HiQ, enc, Screen);
+		}, [&acc](int w, const WsTask &t) {
+			acc[w]->AddRange(*t.b1, t.Begin, t.End);
+		});
+	else
+	{
+		acc[0].reset(new ReadQAcc());
+		acc[0]->Init(HiQ, enc, Screen);
+	}
+	size_t NumRead = 0;
+	vector<double> Block[TB_SIZE];
+	if (plan.Sampling() && !TriageFASTQ(in1, plan, HiQ, enc, Screen, *acc[0], Block))
+		return false;
+	while (!plan.Sampling())
+	{
+		FqBatchPool &p = ws ? ws->NextPool() : pool;
+		FqBatch *b = p.Get();
+		if (!b->Fill(in1, line))
+		{
+			delete ws;
+			return false;
+		}
+		if (b->Count == 0)
+		{
+			p.Put(b);
+			break;
 		}
 
 		// Progress
-		if (ReadCount % 10000000 == 0) // print . per 5M PE
+		if ((NumRead+b->Count)/10000000 != NumRead/10000000) // print . per 10M reads
 		{
 			printf(".");
 			fflush(stdout);
 		}
+		NumRead += b->Count;
+
+		if (ws != NULL)
+			ws->Submit(b);
+		else
+		{
+			acc[0]->AddRange(*b, 0, b->Count);
+			pool.Put(b);
+		}
+	}
+	if (ws != NULL)
+	{
+		ws->Close(); // waits for the workers
+		ws->Reduce([&acc](int dst, int src) {
+			acc[src]->Finish();
+			acc[dst]->Merge(*acc[src]);
+			acc[src].reset();
+		});
+	}
+	in1.Close();
+	if (in1.Err)
+	{
+		printf("Read FQ File 1 Error!\n");
+		delete ws;
+		return false;
+	}
+	acc[0]->Finish();
 
+	// triage: the sample extrapolated to the file, and the bootstrap intervals
+	double Sampled = 0; // bytes of the records counted
+	for (size_t k=0; k<Block[TB_BYTES].size(); k++)
+		Sampled += Block[TB_BYTES][k];
+	if (plan.Sampling())
+	{
+		if (Sampled == 0)
+		{
+			printf("No FASTQ record found in the triage blocks Error!\n");
+			return false;
+		}
+		acc[0]->Scale(plan.FileSize / Sampled);
+	}
+	TriageCI ciReads, ciLen, ciGC, ciQ30, ciHigh, ciPoor, ciEE;
+	if (plan.Sampling())
+	{
+		ciReads.Bootstrap(Block[TB_READS], Block[TB_BYTES], (double)plan.FileSize);
+		ciLen.Bootstrap(Block[TB_BASES], Block[TB_READS], 1.0);
+		ciGC.Bootstrap(Block[TB_GC], Block[TB_BASES], 100.0);
+		ciQ30.Bootstrap(Block[TB_Q30], Block[TB_BASES], 100.0);
+		ciHigh.Bootstrap(Block[TB_HIGH], Block[TB_READS], 100.0);
+		ciPoor.Bootstrap(Block[TB_POOR], Block[TB_READS], 100.0);
+		ciEE.Bootstrap(Block[TB_EE], Block[TB_READS], 1.0);
 	}
-	fclose(fp1);
+
+	ReadQAcc &all = *acc[0];
+	size_t (&AlphabetCount)[ALPHABET_SIZE] = all.AlphabetCount;
+	size_t &TotalLen = all.TotalLen;
+	size_t &ReadCount = all.ReadCount;
+	size_t &MinSeqLen = all.MinSeqLen;
+	size_t &MaxSeqLen = all.MaxSeqLen;
+	size_t (&QCount)[QSCORE_SIZE] = all.QCount;
+	size_t (&MinQCount)[QSCORE_SIZE] = all.MinQCount;
+	size_t (&CntGCRead)[101] = all.CntGCRead;
+	double &TotalEE = all.TotalEE;
+	size_t (&EECount)[EE_CELLS] = all.EECount;
+	size_t (&EELe)[2] = all.EELe;
+	size_t (&PhredCount)[QSCORE_SIZE] = all.PhredCount;
+	vector<size_t> &PosQCount = all.PosQCount;
+	size_t &BadQ = all.BadQ;
+	map<string, int> &TileIdx = all.TileIdx;
+	vector< vector<double> > &TileQSum = all.TileQSum;
+	vector< vector<size_t> > &TileQCnt = all.TileQCnt;
+	vector<size_t> &ScreenHits = all.ScreenHits;
+	size_t ScreenAny = 0; // reads hitting any contaminant
+	for (size_t i=0; i<ScreenHits.size(); i++)
+		ScreenAny += ScreenHits[i];
+	HiQ = all.HiQ;
 	printf("done\n");
+	if (ws != NULL) // throughput of the worker groups
+	{
+		ws->Report(stdout);
+		delete ws;
+	}
 
 // --- summary
 	// to screen
@@ -256,8 +742,139 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	fprintf(stdout, "AvgReadLen: %.2f\n", (double)TotalLen/(double)ReadCount);
 	fprintf(stdout, "MinReadLen: %lu\n", MinSeqLen);
 	fprintf(stdout, "MaxReadLen: %lu\n", MaxSeqLen);
+	if (plan.Sampling())
+	{
+		fprintf(stdout, "Triage: %.1f of %.1f MB sampled (%.2f%%) in %lu blocks, counts extrapolated; 95%% CI:\n",
+			Sampled/1e6, plan.FileSize/1e6, 100.0*Sampled/plan.FileSize, Block[TB_BYTES].size());
+		fprintf(stdout, "  #Read %.0f-%.0f, AvgReadLen %.2f-%.2f, GC%% %.2f-%.2f, Q30%% %.2f-%.2f\n",
+			ciReads.Lo, ciReads.Hi, ciLen.Lo, ciLen.Hi, ciGC.Lo, ciGC.Hi, ciQ30.Lo, ciQ30.Hi);
+		fprintf(stdout, "  HighQ%% %.2f-%.2f, PoorQ%% %.2f-%.2f, EE/read %.3f-%.3f\n",
+			ciHigh.Lo, ciHigh.Hi, ciPoor.Lo, ciPoor.Hi, ciEE.Lo, ciEE.Hi);
+	}
+	if (Screen != NULL)
+	{
+		for (size_t i=0; i<ScreenHits.size(); i++)
+			fprintf(stdout, "Screen %s: %.2f%% of reads\n", Screen->Names[i].c_str(), 100.0*ScreenHits[i]/(double)ReadCount);
+		fprintf(stdout, "Screen any: %.2f%% of reads\n", 100.0*ScreenAny/(double)ReadCount);
+	}
+	if (BadQ > 0)
+		fprintf(stdout, "Warning: %lu Q characters outside Phred+%d, counted as Q0\n", BadQ, enc.Offset);
+
+	// quality summaries shared by metrics and htm
+	size_t BQsum[4] = {0}; // <15, 15-19, 20-29, 30+
+	for (size_t i=0; i<QSCORE_SIZE; i++)
+	{
+		if (i < 15)
+			BQsum[0] += QCount[i];
+		else if (i >= 15 && i < 20)
+			BQsum[1] += QCount[i];
+		else if (i >= 20 && i < 30)
+			BQsum[2] += QCount[i];
+		else
+			BQsum[3] += QCount[i];
+	}
+
+	size_t MQsum[3] = {0}; // >= 10, >=15, >=20
+	for (size_t i=0; i<QSCORE_SIZE; i++)
+	{
+		if (i >= 10)
+		{
+			MQsum[0] += MinQCount[i];
+			if (i >= 15)
+			{
+				MQsum[1] += MinQCount[i];
+				if (i >= 20)
+				{
+					MQsum[2] += MinQCount[i];
+				}
+			}
+		}
+	}
+
+	double HighCov = HiQ.High(ReadCount), PoorCov = HiQ.Poor(ReadCount); // read categories
+
+	double QMean = 0.0; // arithmetic mean of the base Q values
+	for (int i=0; i<QSCORE_SIZE; i++)
+		QMean += (double)i * (double)QCount[i];
+	QMean /= (double)TotalLen;
+	double PhredMeanAll = -10.0*log10(TotalEE/(double)TotalLen); // Q of the mean error probability
+
+	// metrics
+	Metrics met("readQdist", GetFileName(r1).c_str());
+	met.AddInt("reads", ReadCount);
+	met.AddInt("bases", TotalLen);
+	met.AddReal("avg_read_len", ReadCount ? (double)TotalLen/(double)ReadCount : NAN);
+	met.AddInt("min_read_len", ReadCount ? MinSeqLen : 0);
+	met.AddInt("max_read_len", MaxSeqLen);
+	met.AddPct("gc_pct", (double)(AlphabetCount['C']+AlphabetCount['G']), (double)TotalLen);
+	met.AddPct("n_pct", (double)AlphabetCount['N'], (double)TotalLen);
+	met.AddPct("base_q30_pct", (double)BQsum[3], (double)TotalLen);
+	met.AddPct("base_q20_29_pct", (double)BQsum[2], (double)TotalLen);
+	met.AddPct("base_q15_19_pct", (double)BQsum[1], (double)TotalLen);
+	met.AddPct("base_lt_q15_pct", (double)BQsum[0], (double)TotalLen);
+	met.AddPct("minq_ge20_pct", (double)MQsum[2], (double)ReadCount);
+	met.AddPct("minq_ge15_pct", (double)MQsum[1], (double)ReadCount);
+	met.AddPct("minq_ge10_pct", (double)MQsum[0], (double)ReadCount);
+	for (size_t j=HiQ.Th.size(); j-- > 0; )
+		for (size_t c=0; c < HiQ.Cut.size(); c++)
+		{
+			HiQStat::Key(line_buf, HiQ.Th[j], HiQ.Cut[c]);
+			met.AddReal(line_buf, 100.0*HiQ.Coverage(j, c, ReadCount));
+		}
+	met.AddReal("poor_quality_pct", 100.0*PoorCov);
+	met.AddReal("medium_quality_pct", 100.0*(1-HighCov-PoorCov));
+	met.AddReal("high_quality_pct", 100.0*HighCov);
+	met.AddReal("q_mean", QMean);
+	met.AddReal("phred_mean", PhredMeanAll);
+	met.AddReal("read_phred_mean_median", ReadCount ? HistPercentile(PhredCount, ReadCount, 0.5) : NAN);
+	met.AddReal("ee_per_read_mean", ReadCount ? TotalEE/(double)ReadCount : NAN);
+	met.AddPct("ee_le1_pct", (double)EELe[0], (double)ReadCount);
+	met.AddPct("ee_le2_pct", (double)EELe[1], (double)ReadCount);
+	met.AddInt("tiles", TileIdx.size());
+	met.AddInt("q_offset", enc.Offset);
+	met.AddInt("q_levels", QLevels);
+	met.AddInt("invalid_q_bases", BadQ);
+	if (Screen != NULL) // reads hitting each contaminant
+	{
+		for (size_t i=0; i<ScreenHits.size(); i++)
+		{
+			snprintf(line_buf, sizeof(line_buf), "screen_%s_pct", Screen->Names[i].c_str());
+			met.AddPct(line_buf, (double)ScreenHits[i], (double)ReadCount);
+		}
+		met.AddPct("screen_any_pct", (double)ScreenAny, (double)ReadCount);
+	}
+	if (plan.Sampling()) // counts above are extrapolated from the triage sample
+	{
+		met.AddInt("triage_blocks", Block[TB_BYTES].size());
+		met.AddPct("triage_sampled_pct", Sampled, (double)plan.FileSize);
+		const char *CIKey[] = {"reads", "avg_read_len", "gc_pct", "base_q30_pct", "high_quality_pct", "poor_quality_pct", "ee_per_read_mean"};
+		const TriageCI *CI[] = {&ciReads, &ciLen, &ciGC, &ciQ30, &ciHigh, &ciPoor, &ciEE};
+		for (int i=0; i<7; i++)
+		{
+			sprintf(line_buf, "%s_ci95_lo", CIKey[i]);
+			met.AddReal(line_buf, CI[i]->Lo);
+			sprintf(line_buf, "%s_ci95_hi", CIKey[i]);
+			met.AddReal(line_buf, CI[i]->Hi);
+		}
+	}
+	if (!met.Write(outPrjName))
+		return false;
+
+	if (!WriteHtm) // bulk mode: metrics only
+	{
+		fprintf(stdout, "OutFile: %s.metrics.json,%s.metrics.tsv\n", outPrjName, outPrjName);
+		return true;
+	}
+
+	sprintf(OutHTM, "%s.htm", outPrjName);
+	fphtm = fopen(OutHTM, "wt");
+	if (fphtm == NULL)
+	{
+		printf("Open OUT HTM File Error!\n");
+		return false;
+	}
 //	fprintf(stdout, "OutFile: %s,%s\n", OutCSV, OutHTM);
-	fprintf(stdout, "OutFile: %s\n", OutHTM);
+	fprintf(stdout, "OutFile: %s,%s.metrics.json,%s.metrics.tsv\n", OutHTM, outPrjName, outPrjName);
 /*
 	// Start outputing to files
 	fprintf(fpout, "--- Summary of FASTQ ---\n");
@@ -270,20 +887,20 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 */
 	// Output html
 	// head
-	fprintf(fphtm, "<html>\n<head>\n  <title>Pre-assembly SQUAT report</title>\n  <script type=\"text/javascript\" src=\"https://www.gstatic.com/charts/loader.js\"></script>\n");
-	fprintf(fphtm, "  <link rel=\"stylesheet\" type=\"text/css\" href=\"link/template.css\">\n  <script src=\"link/template.js\"></script>\n");
-	fprintf(fphtm, "<style>\n");
-	fprintf(fphtm, ".tabI, .tabH { width: 70%%; border-collapse: collapse; border: 1px solid black; margin-left: auto; margin-right: auto; }\n"); // info, hq table
-	fprintf(fphtm, ".tabI { text-align: center}\n");
-	fprintf(fphtm, ".tabI th, .tabI td, .tabH th, .tabH td { border: 1px solid black; padding: 5px;}\n");
-	fprintf(fphtm, ".tabI th, .tabH th { background-color: #ccc; }\n");
-	fprintf(fphtm, ".tabC { width: 95%%; border: 1px;  margin-left: auto; margin-right: auto;}\n"); // chart table
-	fprintf(fphtm, ".gchart { height: 300px; width: 100%%; }\n");
-	fprintf(fphtm, "</style>\n");
-	fprintf(fphtm, "</head>\n\n");
+	HtmHead(fphtm, "Pre-assembly SQUAT report",
+		".tabI, .tabH { width: 70%; border-collapse: collapse; border: 1px solid black; margin-left: auto; margin-right: auto; }\n" // info, hq table
+		".tabI { text-align: center}\n"
+		".tabI th, .tabI td, .tabH th, .tabH td { border: 1px solid black; padding: 5px;}\n"
+		".tabI th, .tabH th { background-color: #ccc; }\n"
+		".tabC { width: 95%; border: 1px;  margin-left: auto; margin-right: auto;}\n" // chart table
+		".gchart { width: 100%; }\n"
+		".hqf { font-family: serif; font-style: italic; font-size: 20px; color: #1f3864; }\n" // %HighQ(q) formula
+		".hqf .fr { display: inline-block; vertical-align: middle; text-align: center; margin-left: 6px; }\n"
+		".hqf .fr span { display: block; padding: 0 4px; }\n"
+		".hqf .fr span + span { border-top: 1px solid #1f3864; }\n");
 
 	// body	
-	fprintf(fphtm, "<body onresize='location.reload()'>\n");
+	fprintf(fphtm, "<body>\n");
 	fprintf(fphtm, "<div class=\"header\">\n");
 	fprintf(fphtm, "  <div id=\"header_title\">Pre-Assembly SQUAT Report</div>\n");
 	fprintf(fphtm, "  <div id=\"header_filename\">%s  </div>\n", GetCurrentTime().c_str());
@@ -320,11 +937,15 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	fprintf(fphtm, "    <div class=\"ac-sub\">\n");
 	fprintf(fphtm, "      <span class=\"ac-row\" onclick=\"link('#Fhq')\">Covergae of Reads with Sufficient High-Quality Bases</span>\n");
 	fprintf(fphtm, "    </div>\n");
+	fprintf(fphtm, "    <div class=\"ac-sub\">\n");
+	fprintf(fphtm, "      <span class=\"ac-row\" onclick=\"link('#Fee')\">Expected Errors of Reads</span>\n");
+	fprintf(fphtm, "    </div>\n");
+	fprintf(fphtm, "    <div class=\"ac-sub\">\n");
+	fprintf(fphtm, "      <span class=\"ac-row\" onclick=\"link('#Fpq')\">Quality Values along the Reads</span>\n");
+	fprintf(fphtm, "    </div>\n");
 	fprintf(fphtm, "  </article>\n");
 	fprintf(fphtm, "</div>\n");
 
-	fprintf(fphtm, "<br><br><br><br><br><br>Notes: The report requires Internet connection to show the interactive charts of distribuions made by Google chart.\n\n");
-
 	fprintf(fphtm, "</div>\n\n");
 		
 	/*<button class=\"accordion\">Basic Statistics</button>\n");
@@ -353,6 +974,24 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	fprintf(fphtm, "    <tr><td>AvgReadLen</td><td>%.2f</td></tr>\n", TotalLen/(double)ReadCount);
 	fprintf(fphtm, "    <tr><td>MinReadLen</td><td>%lu</td></tr>\n", MinSeqLen);
 	fprintf(fphtm, "    <tr><td>MaxReadLen</td><td>%lu</td></tr>\n", MaxSeqLen);
+	if (plan.Sampling())
+	{
+		fprintf(fphtm, "    <tr><td>Triage sample</td><td>%.1f of %.1f MB (%.2f%%), %lu blocks; counts extrapolated</td></tr>\n",
+			Sampled/1e6, plan.FileSize/1e6, 100.0*Sampled/plan.FileSize, Block[TB_BYTES].size());
+		fprintf(fphtm, "    <tr><td>#Read, 95%% CI</td><td>%s - %s</td></tr>\n", AddCommas((size_t)ciReads.Lo).c_str(), AddCommas((size_t)ciReads.Hi).c_str());
+		fprintf(fphtm, "    <tr><td>GC%%, 95%% CI</td><td>%.2f - %.2f</td></tr>\n", ciGC.Lo, ciGC.Hi);
+		fprintf(fphtm, "    <tr><td>Q30%%, 95%% CI</td><td>%.2f - %.2f</td></tr>\n", ciQ30.Lo, ciQ30.Hi);
+		fprintf(fphtm, "    <tr><td>High-quality reads %%, 95%% CI</td><td>%.2f - %.2f</td></tr>\n", ciHigh.Lo, ciHigh.Hi);
+		fprintf(fphtm, "    <tr><td>Poor-quality reads %%, 95%% CI</td><td>%.2f - %.2f</td></tr>\n", ciPoor.Lo, ciPoor.Hi);
+	}
+	if (Screen != NULL)
+	{
+		for (size_t i=0; i<ScreenHits.size(); i++)
+			fprintf(fphtm, "    <tr><td>Reads hitting %s</td><td>%s (%.2f%%)</td></tr>\n", Screen->Names[i].c_str(),
+				AddCommas(ScreenHits[i]).c_str(), 100.0*ScreenHits[i]/(double)ReadCount);
+		fprintf(fphtm, "    <tr><td>Reads hitting any screened contaminant</td><td>%s (%.2f%%)</td></tr>\n",
+			AddCommas(ScreenAny).c_str(), 100.0*ScreenAny/(double)ReadCount);
+	}
 	fprintf(fphtm, "  </table>\n");
 	fprintf(fphtm, "  </div><br><br><br>\n");
 
@@ -428,18 +1067,6 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	fprintf(fphtm, "  <div id=Fbq  style='page-break-before: always'>\n");
 	fprintf(fphtm, "  <h3 style='color: darkblue;'>Distribution of Bases' Quality Values</h3>\n");
 
-	size_t BQsum[4] = {0}; // <15, 15-19, 20-29, 30+
-	for (size_t i=0; i<QSCORE_SIZE; i++)
-	{
-		if (i < 15)
-			BQsum[0] += QCount[i];
-		else if (i >= 15 && i < 20)
-			BQsum[1] += QCount[i];
-		else if (i >= 20 && i < 30)
-			BQsum[2] += QCount[i];
-		else
-			BQsum[3] += QCount[i];
-	}
 	fprintf(fphtm, "  <table class=tabI><tr><th width=50%%>Name</th><th>AreaFreq</th></tr>\n");
 	fprintf(fphtm, "    <tr><td>Q30 & above</td><td>%.1f%%</td></tr>\n", 100.0*(double)BQsum[3]/(double)TotalLen);
 	fprintf(fphtm, "    <tr><td>Q20-Q29</td><td>%.1f%%</td></tr>\n", 100.0*(double)BQsum[2]/(double)TotalLen);
@@ -456,22 +1083,6 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	fprintf(fphtm, "  <div id=Fmq>\n");
 	fprintf(fphtm, "  <h3 style='color: darkblue;'>Distribution of Reads' MinimalQ Values</h3>\n");
 
-	size_t MQsum[3] = {0}; // >= 10, >=15, >=20
-	for (size_t i=0; i<QSCORE_SIZE; i++)
-	{
-		if (i >= 10)
-		{
-			MQsum[0] += MinQCount[i];
-			if (i >= 15)
-			{
-				MQsum[1] += MinQCount[i];
-				if (i >= 20)
-				{
-					MQsum[2] += MinQCount[i];
-				}
-			}
-		}
-	}
 	fprintf(fphtm, "  <table class=tabI><tr><th width=50%%>Name</th><th>AreaFreq</th></tr>\n");
 	fprintf(fphtm, "    <tr><td>%% of reads whose bases are all Q20 & above</td><td>%.1f%%</td></tr>\n", 100.0*(double)MQsum[2]/(double)ReadCount);
 	fprintf(fphtm, "    <tr><td>%% of reads whose bases are all Q15 & above</td><td>%.1f%%</td></tr>\n", 100.0*(double)MQsum[1]/(double)ReadCount);
@@ -486,66 +1097,72 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	fprintf(fphtm, "  <div id=Fhq style='page-break-before: always'>\n");
 	fprintf(fphtm, "  <h3 style='color: darkblue;'>Coverage of Reads with Sufficient High-Quality Bases</h3>\n");
 
-	double HQcov[5] = {0}; // 100-Q20, 95-Q20, 90-Q20, {90-Q15}, 1-{90-Q15}
-	for (long i=HiQCellSize, cumuCnt[HiQParamSize]={0}; i >= 0; i--)
+	fprintf(fphtm, "  <table class=tabH><tr align=center><th width=50%%>Name</th><th>Coverage of reads</th><th>Remark</th></tr>\n");
 	{
-		double cumuRatio[HiQParamSize];
-		double cov = (double)i*100.0 / (double)HiQCellSize;
-		for (int k=0; k<HiQParamSize; k++)
-		{
-			cumuCnt[k] += HiQPercentCount[k][i];
-//			printf("cov=%.1f, k=%d, cumuCnt[k]=%lu\n", cov, k, cumuCnt[k]);
-//			getchar();
-			if (cov == 100.0)
-			{
-				if (k == 1) // Q20
-					HQcov[0] = (double)cumuCnt[k] / (double)ReadCount;
-			}
-			if (cov == 95.0)
-			{
-				if (k == 1) // Q20
-					HQcov[1] = (double)cumuCnt[k] / (double)ReadCount;
-			}
-			else if (cov == 90.0)
-			{
-				if (k == 1) // Q20
-					HQcov[2] = (double)cumuCnt[k] / (double)ReadCount;
-				else if (k == 0) // Q15
-				{
-					HQcov[3] = (double)cumuCnt[k] / (double)ReadCount;
-					HQcov[4] = 1 - HQcov[3];
-				}
-			}
-		}
+		int qh = HiQ.Th.back(), ql = HiQ.Th.front();
+		double ch = HiQ.Cut.front(), cl = HiQ.Cut.back();
+		sprintf(line_buf, "%%HighQ(%d) >= %g%%", qh, ch);
+		if (ch == 100)
+			sprintf(line_buf+strlen(line_buf), "<br>(i.e., MinimaQ>=%d)", qh);
+		fprintf(fphtm, "    <tr align=center><td align=left><b>%% of High-quality reads</b><br>Coverage of reads that %s%g%% of their bases with Q%d & above</td><td>%.1f%%</td><td>%s</td></tr>\n",
+			(ch == 100 ? "" : ">= "), ch, qh, 100.0*HighCov, line_buf);
+		for (size_t j=HiQ.Th.size(); j-- > 0; )
+			for (size_t c=0; c < HiQ.Cut.size(); c++)
+				if (!(j == HiQ.Th.size()-1 && c == 0))
+					fprintf(fphtm, "    <tr align=center><td align=left>Coverage of reads that >= %g%% of their bases with Q%d & above</td><td>%.1f%%</td><td>%%HighQ(%d) >= %g%%</td></tr>\n",
+						HiQ.Cut[c], HiQ.Th[j], 100.0*HiQ.Coverage(j, c, ReadCount), HiQ.Th[j], HiQ.Cut[c]);
+		fprintf(fphtm, "    <tr align=center><td align=left><b>%% of Poor-quality reads</b><br>Coverage of reads that > %g%% of their bases with Q%d & less</td><td>%.1f%%</td><td>1 - {%%HighQ(%d) >= %g%%}</td></tr>\n",
+			100-cl, ql-1, 100.0*PoorCov, ql, cl);
 	}
-	fprintf(fphtm, "  <table class=tabH><tr align=center><th width=50%%>Name</th><th>Coverage of reads</th><th>Remark</th></tr>\n");
-	fprintf(fphtm, "    <tr align=center><td align=left><b>%% of High-quality reads</b><br>Coverage of reads that 100%% of their bases with Q20 & above</td><td>%.1f%%</td><td>%%HighQ(20) >= 100%%<br>(i.e., MinimaQ>=20)</td></tr>\n", 100.0*HQcov[0]);
-	fprintf(fphtm, "    <tr align=center><td align=left>Coverage of reads that >= 95%% of their bases with Q20 & above</td><td>%.1f%%</td><td>%%HighQ(20) >= 95%%</td></tr>\n", 100.0*HQcov[1]);
-	fprintf(fphtm, "    <tr align=center><td align=left>Coverage of reads that >= 90%% of their bases with Q20 & above</td><td>%.1f%%</td><td>%%HighQ(20) >= 90%%</td></tr>\n", 100.0*HQcov[2]);
-	fprintf(fphtm, "    <tr align=center><td align=left>Coverage of reads that >= 90%% of their bases with Q15 & above</td><td>%.1f%%</td><td>%%HighQ(15) >= 90%%</td></tr>\n", 100.0*HQcov[3]);
-	fprintf(fphtm, "    <tr align=center><td align=left><b>%% of Poor-quality reads</b><br>Coverage of reads that > 10%% of their bases with Q14 & less</td><td>%.1f%%</td><td>1 - {%%HighQ(15) >= 90%%}</td></tr>\n", 100.0*HQcov[4]);
 	fprintf(fphtm, "  </table>\n\n");
 /*
 	// Insert to sum
 	fprintf(fphtm, "<script>\n");
 	fprintf(fphtm, "  var div = document.getElementById('sum')\n");
 
-	sprintf(line_buf, "<table border=0 align=center><tr style=\"font-style: italic; font-weight: bold; font-size: 24px\"><td>Percentage of poor-quality reads:</td><td>%.1f%%</td></tr> ", 100.0*HQcov[4]);
+	sprintf(line_buf, "<table border=0 align=center><tr style=\"font-style: italic; font-weight: bold; font-size: 24px\"><td>Percentage of poor-quality reads:</td><td>%.1f%%</td></tr> ", 100.0*PoorCov);
 	string ins = line_buf;
-	sprintf(line_buf, "<tr style=\"font-style: italic; font-size: 18px\"><td>Percentage of medium-quality reads:</td><td>%.1f%%</td></tr> ", 100.0*(1-HQcov[0]-HQcov[4]) );
+	sprintf(line_buf, "<tr style=\"font-style: italic; font-size: 18px\"><td>Percentage of medium-quality reads:</td><td>%.1f%%</td></tr> ", 100.0*(1-HighCov-PoorCov) );
 	ins += line_buf;
-	sprintf(line_buf, "<tr style=\"font-style: italic; font-size: 18px\"><td>Percentage of high-quality reads:</td><td>%.1f%%</td></tr></table>", 100.0*HQcov[0]);
+	sprintf(line_buf, "<tr style=\"font-style: italic; font-size: 18px\"><td>Percentage of high-quality reads:</td><td>%.1f%%</td></tr></table>", 100.0*HighCov);
 	ins += line_buf;
 
 	fprintf(fphtm, "  div.innerHTML += '%s'\n", ins.c_str());
 	fprintf(fphtm, "</script>\n\n");
 */
 	fprintf(fphtm, "  <table class=tabC>");
-	fprintf(fphtm, "    <tr><td align=center><img src='link/HighQ.png' alt='%%HighQ(q)' style='width: 462; Height: 56'></img></td></tr>\n");
+	fprintf(fphtm, "    <tr><td align=center><span class=hqf>%%HighQ(q) = <span class=fr><span>#bases with quality value &ge; q</span><span>#bases of a read</span></span></span></td></tr>\n");
 	fprintf(fphtm, "    <tr><td id=hq class=gchart></td></tr>\n");
 	fprintf(fphtm, "  </table>\n");
 	fprintf(fphtm, "  </div><br><br><br>\n");
 
+	// expected errors
+	fprintf(fphtm, "  <div id=Fee style='page-break-before: always'>\n");
+	fprintf(fphtm, "  <h3 style='color: darkblue;'>Expected Errors of Reads</h3>\n");
+	fprintf(fphtm, "  <table class=tabI><tr><th width=50%%>Name</th><th>Value</th></tr>\n");
+	fprintf(fphtm, "    <tr><td>Mean expected errors (EE) per read</td><td>%.2f</td></tr>\n", TotalEE/(double)ReadCount);
+	fprintf(fphtm, "    <tr><td>%% of reads with EE &le; 1</td><td>%.1f%%</td></tr>\n", 100.0*(double)EELe[0]/(double)ReadCount);
+	fprintf(fphtm, "    <tr><td>%% of reads with EE &le; 2</td><td>%.1f%%</td></tr>\n", 100.0*(double)EELe[1]/(double)ReadCount);
+	fprintf(fphtm, "    <tr><td>Phred mean quality of bases</td><td>%.1f</td></tr>\n", PhredMeanAll);
+	fprintf(fphtm, "    <tr><td>Arithmetic mean of base Q values</td><td>%.1f</td></tr>\n", QMean);
+	fprintf(fphtm, "  </table>\n\n");
+	fprintf(fphtm, "  <table class=tabC>");
+	fprintf(fphtm, "    <tr><td align=center><span class=hqf>EE = &sum; 10<sup>-Q/10</sup> over the bases of a read; Phred mean = -10 log<sub>10</sub>(EE / #bases)</span></td></tr>\n");
+	fprintf(fphtm, "    <tr><td id=ee class=gchart></td></tr>\n");
+	fprintf(fphtm, "    <tr><td id=rq class=gchart></td></tr>\n");
+	fprintf(fphtm, "  </table>\n");
+	fprintf(fphtm, "  </div><br><br><br>\n");
+
+	// per-position (and per-tile) quality
+	fprintf(fphtm, "  <div id=Fpq style='page-break-before: always'>\n");
+	fprintf(fphtm, "  <h3 style='color: darkblue;'>Quality Values along the Reads</h3>\n");
+	fprintf(fphtm, "  <table class=tabC>");
+	fprintf(fphtm, "    <tr><td id=pq class=gchart></td></tr>\n");
+	if (TileIdx.size() > 1)
+		fprintf(fphtm, "    <tr><td id=tq class=gchart></td></tr>\n");
+	fprintf(fphtm, "  </table>\n");
+	fprintf(fphtm, "  </div><br><br><br>\n");
+
 	fprintf(fphtm, "</div>");
 	
 	// script
@@ -553,46 +1170,29 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	fprintf(fphtm, "function DrawDist() {\n");
 
 // --- Pie of poor/mid/high-Q reads
-	// option
-	fprintf(fphtm, "  var optP = {\n");
-	fprintf(fphtm, "    titleTextStyle: { fontSize: 22 }, title: \"Categorization of read quality\", is3D: true, colors: ['red','orange','green']\n");
-	fprintf(fphtm, "  };\n");
-	
-	fprintf(fphtm, "  var dP = google.visualization.arrayToDataTable([\n");
-	fprintf(fphtm, "    ['Type', 'Percentage'],\n"); 
-	fprintf(fphtm, "    ['Poor-quality reads', %.4f],\n", HQcov[4]); 
-	fprintf(fphtm, "    ['Medium-quality reads', %.4f],\n", 1.0-HQcov[4]-HQcov[0]); 
-	fprintf(fphtm, "    ['High-quality reads', %.4f],\n", HQcov[0]); 
-	fprintf(fphtm, "  ] );\n");
-	fprintf(fphtm, "  var chartP = new google.visualization.PieChart(document.getElementById('sum'));\n");
-	fprintf(fphtm, "  chartP.draw(dP, optP);\n");
-	fprintf(fphtm, "\n");
-
+	{
+		vector<double> x(3);
+		vector< vector<double> > y(1);
+		y[0].push_back(PoorCov);
+		y[0].push_back(1.0-PoorCov-HighCov);
+		y[0].push_back(HighCov);
+		HtmChart(fphtm, "sum", "type: 'pie', title: 'Categorization of read quality', colors: ['red','orange','green']",
+			x, y, "['Poor-quality reads', 'Medium-quality reads', 'High-quality reads']");
+	}
 
 // --- Dist of read gc 
-	// option
-	fprintf(fphtm, "  var opt1 = {\n");
-	fprintf(fphtm, "    title: \"Frequency of reads' GC%%\", hAxis: { title: 'GC%%' }, vAxis: { title: 'Freq%%', format: 'percent' }, colors: ['#76A7FA']\n");
-	fprintf(fphtm, "  };\n");
-
-	fprintf(fphtm, "  var d1 = new google.visualization.DataTable();\n");
-	fprintf(fphtm, "  d1.addColumn('number', 'GC%%');\n");
-	fprintf(fphtm, "  d1.addColumn('number', 'Freq');\n");
-	fprintf(fphtm, "  d1.addRows( [ "); 
-
-	for (char i=0; i<=100; i++)
 	{
-		double tmpf = (double)CntGCRead[i] / (double)ReadCount;
-		fprintf(fphtm, "[%d,%.4f],", i, tmpf);
-		if (i % 10 == 9)
-			fprintf(fphtm, "\n");
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (int i=0; i<=100; i++)
+		{
+			x.push_back(i);
+			y[0].push_back((double)CntGCRead[i] / (double)ReadCount);
+		}
+		HtmChart(fphtm, "gc", "type: 'column', title: \"Frequency of reads' GC%\", xTitle: 'GC%', yTitle: 'Freq%', percent: 1, colors: ['#76A7FA']",
+			x, y, "['Freq']");
 	}
 
-	fprintf(fphtm, "  ] );\n");
-	fprintf(fphtm, "  var chart1 = new google.visualization.ColumnChart(document.getElementById('gc'));\n");
-	fprintf(fphtm, "  chart1.draw(d1, opt1);\n");
-	fprintf(fphtm, "\n");
-
 // --- Base Q dist
 /*
 	fprintf(fpout, "\n--- Base Q-value Count ---\n");
@@ -607,30 +1207,18 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 	}
 */
 // --- Dist of read bq 
-	// option
-	fprintf(fphtm, "  var opt2 = {\n");
-//	fprintf(fphtm, "    title: 'Frequency of Bases Quality Values', hAxis: { title: 'Quality value' }, vAxis: { title: 'Freq%%', format: 'percent' }, colors: ['#a52714', '#097138']\n");
-	fprintf(fphtm, "    title: 'Frequency of base quality values', hAxis: { title: 'Quality value' }, vAxis: { title: 'Freq%%', format: 'percent' }, colors: ['#097138']\n");
-	fprintf(fphtm, "  };\n");
-
-	fprintf(fphtm, "  var d2 = new google.visualization.DataTable();\n");
-	fprintf(fphtm, "  d2.addColumn('number', 'Quality value');\n");
-	fprintf(fphtm, "  d2.addColumn('number', 'Freq');\n");
-	fprintf(fphtm, "  d2.addRows( [ "); 
-
-	for (size_t i=0; i<QSCORE_SIZE; i++)
 	{
-		double tmpf = (double)QCount[i] / (double)TotalLen;
-		fprintf(fphtm, "[%lu,%.4f], ", i, tmpf);
-		if (i % 10 == 9)
-			fprintf(fphtm, "\n");
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (size_t i=0; i<QSCORE_SIZE; i++)
+		{
+			x.push_back(i);
+			y[0].push_back((double)QCount[i] / (double)TotalLen);
+		}
+		HtmChart(fphtm, "bq", "type: 'area', title: 'Frequency of base quality values', xTitle: 'Quality value', yTitle: 'Freq%', percent: 1, colors: ['#097138']",
+			x, y, "['Freq']");
 	}
 
-	fprintf(fphtm, "  ] );\n");
-	fprintf(fphtm, "  var chart2 = new google.visualization.AreaChart(document.getElementById('bq'));\n");
-	fprintf(fphtm, "  chart2.draw(d2, opt2);\n");
-	fprintf(fphtm, "\n");
-
 // --- MinQ dist
 /*	fprintf(fpout, "\n--- Read MinQ-value Count ---\n");
 	fprintf(fpout, "MinQ,Count,Freq%%,cumuFreq%%\n");
@@ -647,79 +1235,145 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 */ 
 
 // --- Dist of read mq 
-	// option
-	fprintf(fphtm, "  var opt3 = {\n");
-	fprintf(fphtm, "    title: 'MinimalQ distribution', hAxis: { title: 'MinmalQ value', viewWindow: { max: 41 } }, vAxis: { title: 'Freq%%', format: 'percent' }, colors: ['#a52714']\n");
-	fprintf(fphtm, "  };\n");
-
-	fprintf(fphtm, "  var d3 = new google.visualization.DataTable();\n");
-	fprintf(fphtm, "  d3.addColumn('number', 'MinQ');\n");
-	fprintf(fphtm, "  d3.addColumn('number', 'Freq');\n");
-	fprintf(fphtm, "  d3.addRows( [ "); 
+	{
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (size_t i=0; i<QSCORE_SIZE; i++)
+		{
+			x.push_back(i);
+			y[0].push_back((double)MinQCount[i] / (double)ReadCount);
+		}
+		HtmChart(fphtm, "mq", "type: 'area', title: 'MinimalQ distribution', xTitle: 'MinmalQ value', yTitle: 'Freq%', percent: 1, xMax: 41, colors: ['#a52714']",
+			x, y, "['Freq']");
+	}
 
-	for (size_t i=0, cumuCnt=ReadCount; i<QSCORE_SIZE; i++)
+// --- Dist of read EE, up to the last non-empty cell
 	{
-		double tmpf = (double)MinQCount[i] / (double)ReadCount;
-//		double tmpf2 = (double)cumuCnt / (double)ReadCount;
-		fprintf(fphtm, "[%lu,%.4f], ", i, tmpf);
-		if (i % 10 == 9)
-			fprintf(fphtm, "\n");
-		cumuCnt -= MinQCount[i];
+		int last = 0;
+		for (int i=0; i<EE_CELLS; i++)
+			if (EECount[i])
+				last = i;
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (int i=0; i<=last; i++)
+		{
+			x.push_back(i*EE_CELL);
+			y[0].push_back((double)EECount[i] / (double)ReadCount);
+		}
+		sprintf(line_buf, "type: 'column', title: 'Expected errors (EE) distribution of reads', xTitle: 'EE (the last bin holds EE >= %g)', yTitle: 'Freq%%', percent: 1, colors: ['#a52714']",
+			(EE_CELLS-1)*EE_CELL);
+		HtmChart(fphtm, "ee", last == EE_CELLS-1 ? line_buf : "type: 'column', title: 'Expected errors (EE) distribution of reads', xTitle: 'EE', yTitle: 'Freq%', percent: 1, colors: ['#a52714']",
+			x, y, "['Freq']");
 	}
 
-	fprintf(fphtm, "  ] );\n");
-	fprintf(fphtm, "  var chart3 = new google.visualization.AreaChart(document.getElementById('mq'));\n");
-	fprintf(fphtm, "  chart3.draw(d3, opt3);\n");
-	fprintf(fphtm, "\n");
+// --- Dist of read Phred mean
+	{
+		vector<double> x;
+		vector< vector<double> > y(1);
+		for (size_t i=0; i<QSCORE_SIZE; i++)
+		{
+			x.push_back(i);
+			y[0].push_back((double)PhredCount[i] / (double)ReadCount);
+		}
+		HtmChart(fphtm, "rq", "type: 'column', title: 'Phred mean quality distribution of reads', xTitle: 'Phred mean quality', yTitle: 'Freq%', percent: 1, xMax: 41, colors: ['#097138']",
+			x, y, "['Freq']");
+	}
 
 // --- Dist of %HighQ(x) 
-	// option
-	fprintf(fphtm, "  var optH = {\n");
-	fprintf(fphtm, "    title: 'Coverage of reads with %%HighQ(q) >= X%%', hAxis: { title: 'X%% (X%% from 100 downto 50)', direction: -1, viewWindow: { max: 100, min: 50 } }, vAxis: { title: 'Coverage%%', format: 'percent' }, colors: ['#a52714', '#097138']\n");
-	fprintf(fphtm, "  };\n");
-	
-	fprintf(fphtm, "  var dH = new google.visualization.DataTable();\n");
-	fprintf(fphtm, "  dH.addColumn('number', 'X%%');\n");
-	for (int k=0; k<HiQParamSize; k++)
-		fprintf(fphtm, "  dH.addColumn('number', 'q=%d');\n", HiQTh[k]);
-	fprintf(fphtm, "  dH.addRows( [ "); 
-
 /*		fprintf(fpout, "\n--- PE %%HighQ(%d)-value Count ---\n", HiQTh[j]);
 		fprintf(fpout, "%%HighQ(%d),Count,Freq%%,CumuFreq%%\n", HiQTh[j]);
 */
-	for (long i=HiQCellSize, cumuCnt[HiQParamSize]={0}; i >= 0; i--)
 	{
-		// Output each record		
-		fprintf(fphtm, "[%.1f", (double)i*(100.0/HiQCellSize));
-		double cumuRatio[HiQParamSize];
-		for (int k=0; k<HiQParamSize; k++)
+		vector<double> x;
+		size_t NumTh = HiQ.Th.size();
+		vector< vector<double> > y(NumTh);
+		vector<size_t> cumuCnt(NumTh, 0);
+		string names = "[";
+		for (size_t k=0; k<NumTh; k++)
 		{
-			cumuCnt[k] += HiQPercentCount[k][i];
-			cumuRatio[k] = (double)cumuCnt[k] / (double)ReadCount;
-			fprintf(fphtm, ",%.4f", cumuRatio[k]);
+			sprintf(line_buf, "%s'q=%d'", (k ? ", " : ""), HiQ.Th[k]);
+			names += line_buf;
 		}
-		fprintf(fphtm, "],");
-//		double tmpf = (double)HiQPercentCount[j][i] / (double)ReadCount;
-//			fprintf(fpout, "%.1f,%lu,%.2f%%,%.2f%%\n", (double)i*(100.0/HiQCellSize), HiQPercentCount[j][i], 100.0*tmpf, 100.0*tmpf2);
+		names += "]";
 
-		if (i % 10 == 9)
-			fprintf(fphtm, "\n");
+		for (long i=HiQCellSize; i >= 0; i--)
+		{
+			// Output each record		
+			x.push_back((double)i*(100.0/HiQCellSize));
+			for (size_t k=0; k<NumTh; k++)
+			{
+				cumuCnt[k] += HiQ.PercentCount[k][i];
+				y[k].push_back((double)cumuCnt[k] / (double)ReadCount);
+			}
+		}
+		// two thresholds keep the report colors, more use the chart palette
+		HtmChart(fphtm, "hq", NumTh > 2 ? "type: 'line', title: 'Coverage of reads with %HighQ(q) >= X%', xTitle: 'X% (X% from 100 downto 50)', yTitle: 'Coverage%', percent: 1, reverse: 1, xMin: 50, xMax: 100"
+			: "type: 'line', title: 'Coverage of reads with %HighQ(q) >= X%', xTitle: 'X% (X% from 100 downto 50)', yTitle: 'Coverage%', percent: 1, reverse: 1, xMin: 50, xMax: 100, colors: ['#a52714', '#097138']",
+			x, y, names.c_str());
 	}
-	
-	fprintf(fphtm, "  [0");
-	for (int k=0; k<HiQParamSize; k++)
-		fprintf(fphtm, ",1");
-	fprintf(fphtm, "] ] );\n");
-	fprintf(fphtm, "  var chartH = new google.visualization.LineChart(document.getElementById('hq'));\n");
-	fprintf(fphtm, "  chartH.draw(dH, optH);\n");
-	fprintf(fphtm, "\n");
-//	fprintf(fpout, "\n");
 
+// --- Q along the reads: mean and percentiles per position, positions binned to at most HTM_MAX_POINTS
+	size_t NumPos = PosQCount.size() / QSCORE_SIZE;
+	size_t PosBin = (NumPos + HTM_MAX_POINTS - 1) / HTM_MAX_POINTS;
+	vector<double> PosX, PosMean;
+	{
+		vector< vector<double> > y(4); // mean, median, 25th, 10th percentile
+		for (size_t b=0; b<NumPos; b+=PosBin)
+		{
+			size_t hist[QSCORE_SIZE] = {0}, n = 0;
+			double sum = 0;
+			for (size_t i=b; i<MIN(b+PosBin, NumPos); i++)
+				for (int q=0; q<QSCORE_SIZE; q++)
+					hist[q] += PosQCount[i*QSCORE_SIZE+q];
+			for (int q=0; q<QSCORE_SIZE; q++)
+			{
+				n += hist[q];
+				sum += (double)q*hist[q];
+			}
+			PosX.push_back(b+1);
+			PosMean.push_back(sum/n);
+			y[0].push_back(sum/n);
+			y[1].push_back(HistPercentile(hist, n, 0.5));
+			y[2].push_back(HistPercentile(hist, n, 0.25));
+			y[3].push_back(HistPercentile(hist, n, 0.1));
+		}
+		HtmChart(fphtm, "pq", "type: 'line', title: 'Quality values along the reads', xTitle: 'Position in read (bp)', yTitle: 'Quality value', colors: ['#097138', '#3366cc', '#ff9900', '#a52714']",
+			PosX, y, "['Mean', 'Median', '25th percentile', '10th percentile']");
+	}
+
+// --- Q of each tile along the reads, relative to all the reads
+	if (TileIdx.size() > 1)
+	{
+		vector<double> x;
+		vector<string> rows;
+		vector< vector<double> > m;
+		for (size_t b=0, bi=0; b<MIN(NumPos, SEQ_SIZE); b+=PosBin, bi++)
+			x.push_back(PosX[bi]);
+		for (map<string, int>::iterator it=TileIdx.begin(); it != TileIdx.end(); it++)
+		{
+			vector<double> row;
+			for (size_t b=0, bi=0; b<MIN(NumPos, SEQ_SIZE); b+=PosBin, bi++)
+			{
+				double sum = 0;
+				size_t n = 0;
+				for (size_t i=b; i<MIN(b+PosBin, MIN(NumPos, SEQ_SIZE)); i++)
+				{
+					sum += TileQSum[it->second][i];
+					n += TileQCnt[it->second][i];
+				}
+				row.push_back(n ? sum/n - PosMean[bi] : 0);
+			}
+			rows.push_back(it->first);
+			m.push_back(row);
+		}
+		sprintf(line_buf, "title: 'Mean quality of each tile minus the mean of all reads', note: 'Rows: lane:tile (%lu tiles); columns: position in read, first %d bp; red: lower, blue: higher, saturated at 5', range: 5, rowTitle: 'tile', xTitle: 'position'",
+			rows.size(), SEQ_SIZE);
+		HtmHeatmap(fphtm, "tq", line_buf, x, rows, m);
+	}
 
 	// end of htm
 	fprintf(fphtm, "}\n");
-	fprintf(fphtm, "google.charts.load('current', {'packages': ['corechart', 'line']});\n");
-	fprintf(fphtm, "google.charts.setOnLoadCallback(DrawDist);"); 
+	fprintf(fphtm, "DrawDist();\n"); 
 	fprintf(fphtm, "</script>\n");
 	fprintf(fphtm, "</body>\n</html>\n");
 
@@ -735,12 +1389,50 @@ bool ProbeFASTQ(char *r1, char *outPrjName)
 int main(int argc, char **argv)
 {
 //=============================================================================
-	if(argc != 3)
+	bool WriteHtm = true;
+	const char *ThList = HiQDefaultTh, *CutList = HiQDefaultCut;
+	int Threads = (int)thread::hardware_concurrency();
+	double TriageMB = 0;
+	const char *ScreenList = NULL;
+	int Phred = 0;
+	bool ArgOK = (argc >= 3);
+	for (int i=3; ArgOK && i < argc; i++)
+	{
+		if (strcmp(argv[i], "-m") == 0)
+			WriteHtm = false;
+		else if (strcmp(argv[i], "-q") == 0 && i+1 < argc)
+			ThList = argv[++i];
+		else if (strcmp(argv[i], "-c") == 0 && i+1 < argc)
+			CutList = argv[++i];
+		else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			Threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+			TriageMB = atof(argv[++i]);
+		else if (strcmp(argv[i], "-k") == 0 && i+1 < argc)
+			ScreenList = argv[++i];
+		else if (strcmp(argv[i], "-p") == 0 && i+1 < argc)
+			Phred = atoi(argv[++i]);
+		else
+			ArgOK = false;
+	}
+	if (Phred != 0 && Phred != 33 && Phred != 64)
+		ArgOK = false;
+	if(!ArgOK)
 	{
 		printf("=== readQdist: Read a read FASTQ file and generate quality distribution and GC%% of the FASTQ file ===\n\n");
-		printf("Usage: readQdist in.fq outPrjName\n");
+		printf("Usage: readQdist in.fq outPrjName [-m] [-q QThs] [-c Cuts] [-t threads] [-s MB] [-k fa1[,fa2...]] [-p 33|64]\n");
+		printf(" -m: Optional. Write the metrics files only, no htm (bulk mode)\n");
+		printf(" -q: Optional. Comma-separated Q thresholds of %%HighQ(q) (Range: 0-41; default %s)\n", HiQDefaultTh);
+		printf(" -c: Optional. Comma-separated %%HighQ coverage cut points (Range: 100.0-0.0; default %s)\n", HiQDefaultCut);
+		printf("     High-quality reads: %%HighQ(max q) >= max cut; poor-quality reads: %%HighQ(min q) < min cut\n");
+		printf(" -t: Optional. Number of threads, default all cores\n");
+		printf(" -s: Optional. Triage: read evenly spaced blocks of about MB megabytes in all, extrapolate\n");
+		printf("     the counts to the file and give 95%% bootstrap intervals of the headline numbers\n");
+		printf(" -k: Optional. Contamination screen: %% of reads sharing minimizers (k=%d, w=%d) with each of\n", MZ_K, MZ_W);
+		printf("     these small reference FASTA files (PhiX, E. coli, vectors, ...), named after the files\n");
+		printf(" -p: Optional. Quality offset, Phred+33 or Phred+64 (default: detected, Phred+33 if the first reads fit both)\n");
 //		printf("Output: outPrjName.htm, outPrjName.csv\n");
-		printf("Output: outPrjName.htm\n");
+		printf("Output: outPrjName.htm, outPrjName.metrics.json, outPrjName.metrics.tsv\n");
 		printf("Verson: 1.0 (2018/04) \n");
 		printf("Author: Yu-Jung Chang\n\n");
 
@@ -748,7 +1440,14 @@ int main(int argc, char **argv)
 	}
 
 //=============================================================================
-	ProbeFASTQ(argv[1], argv[2]);
+	HiQStat HiQ;
+	if (!HiQ.Init(ThList, CutList))
+		return 1;
+	KScreen Screen;
+	if (ScreenList != NULL && !Screen.Load(ScreenList))
+		return 1;
+	if (!ProbeFASTQ(argv[1], argv[2], WriteHtm, HiQ, MAX(1, Threads), TriageMB, ScreenList ? &Screen : NULL, Phred))
+		return 1;
 
 //=============================================================================
 	return 0;
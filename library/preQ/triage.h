@@ -0,0 +1,136 @@
+/*
+== Triage sampling of a large FASTQ file; update: 2026/10
+Instead of the whole file, TriagePlan reads evenly spaced blocks of it within a byte budget.
+Each block starts at the first full record after its offset (FqSyncRecord), and the counts
+of all blocks are extrapolated to the file by its size over the bytes sampled. A headline
+metric is a ratio of two sums over the reads, e.g. C+G over bases; its 95% confidence
+interval comes from a percentile bootstrap over the blocks, so reads that are alike
+because they are neighbours in the file (tile, lane, run time) are resampled together.
+*/
+//=============================================================================
+#ifndef SQUAT_TRIAGE_H
+#define SQUAT_TRIAGE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h> // for NAN
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <vector>
+#include <algorithm> // for sort
+
+#define TRIAGE_MAX_BLOCKS 256
+#define TRIAGE_MIN_BLOCK (1<<16) // bytes; smaller budgets get fewer blocks
+#define TRIAGE_BOOTSTRAP 1000 // resamples
+#define TRIAGE_SYNC_SIZE (1<<16) // bytes searched for a record start, several records of FQB_LINE_MAX lines
+
+//=============================================================================
+// blocks of BlockSize bytes at Off[k]; none when the budget covers the file
+struct TriagePlan
+{
+	off_t FileSize;
+	size_t BlockSize;
+	std::vector<off_t> Off;
+
+	bool Init(int fd, double budgetMB)
+	{
+		struct stat st;
+		Off.clear();
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+			return false;
+		FileSize = st.st_size;
+		off_t budget = (off_t)(budgetMB*1e6);
+		if (budget >= FileSize)
+			return true;
+		size_t blocks = (size_t)(budget / TRIAGE_MIN_BLOCK);
+		blocks = (blocks < 1 ? 1 : (blocks > TRIAGE_MAX_BLOCKS ? TRIAGE_MAX_BLOCKS : blocks));
+		BlockSize = (size_t)(budget / blocks);
+		for (size_t k=0; k < blocks; k++)
+			Off.push_back((off_t)((double)FileSize * k / blocks));
+		return true;
+	}
+
+	bool Sampling() const
+	{
+		return !Off.empty();
+	}
+};
+
+// a line of buf[0, n) starting at p: its end ('\n' or n)
+inline size_t TriageLineEnd(const char *buf, size_t n, size_t p)
+{
+	const char *nl = (const char *)memchr(buf+p, '\n', n-p);
+	return nl ? (size_t)(nl-buf) : n;
+}
+
+// file offset of the first record starting at or after off, -1 if none within TRIAGE_SYNC_SIZE.
+// A record start is a '@' line followed by a line, a '+' line and a line of the same length as
+// the second, then a '@' line again (or the end of the file); a quality line starting with '@'
+// fails one of these
+inline off_t FqSyncRecord(int fd, off_t off, off_t fileSize)
+{
+	std::vector<char> buf(TRIAGE_SYNC_SIZE);
+	off_t base = (off > 0 ? off-1 : 0); // from the byte before, to see if off starts a line
+	ssize_t n = pread(fd, &buf[0], buf.size(), base);
+	if (n <= 0)
+		return -1;
+	size_t p = (off == 0 ? 0 : (buf[0] == '\n' ? 1 : TriageLineEnd(&buf[0], n, 0) + 1));
+	bool eof = (base + n >= fileSize);
+	while (p < (size_t)n)
+	{
+		size_t start[6], end[5];
+		int k = 0;
+		start[0] = p;
+		for (; k < 5 && start[k] < (size_t)n; k++)
+		{
+			end[k] = TriageLineEnd(&buf[0], n, start[k]);
+			start[k+1] = end[k] + 1;
+		}
+		if (k < 4 || (k == 4 && !eof)) // no full record left in the buffer
+			return -1;
+		if (buf[start[0]] == '@' && buf[start[2]] == '+' && end[1]-start[1] == end[3]-start[3]
+			&& (k == 4 || buf[start[4]] == '@'))
+			return base + (off_t)p;
+		p = end[0] + 1;
+	}
+	return -1;
+}
+
+//=============================================================================
+// percentile bootstrap of sum(Num)/sum(Den) over blocks drawn with replacement
+struct TriageCI
+{
+	double Lo, Hi;
+
+	void Bootstrap(const std::vector<double> &Num, const std::vector<double> &Den, double scale)
+	{
+		size_t n = Num.size();
+		std::vector<double> est;
+		uint64_t x = 0x9E3779B97F4A7C15ULL; // fixed seed: the same file gives the same interval
+		for (int b=0; b < TRIAGE_BOOTSTRAP; b++)
+		{
+			double num = 0, den = 0;
+			for (size_t i=0; i < n; i++)
+			{
+				x ^= x << 13; x ^= x >> 7; x ^= x << 17; // xorshift64
+				size_t k = (size_t)(x % n);
+				num += Num[k];
+				den += Den[k];
+			}
+			if (den > 0)
+				est.push_back(scale * num / den);
+		}
+		if (est.empty())
+		{
+			Lo = Hi = NAN;
+			return;
+		}
+		std::sort(est.begin(), est.end());
+		Lo = est[(size_t)(0.025 * (est.size()-1))];
+		Hi = est[(size_t)(0.975 * (est.size()-1))];
+	}
+};
+
+#endif
@@ -0,0 +1,273 @@
+/*
+== Work-stealing scheduler of FASTQ record batches; update: 2026/10
+The reading thread submits each batch as one task, a range of its records, round-robin
+to the deques of the workers. A worker takes its newest task and, while others are
+idle, splits the upper half of the range back onto its deque; idle workers steal the
+oldest task of another deque. So long reads only cost the worker that has them until
+someone is free to take half. A batch goes back to its pool when all its records are done.
+On NUMA machines (numa.h) the workers form one group per node: they are pinned there, set
+up their accumulators there, read batches from their node's pool, steal within the node
+before across nodes, and are reduced within the node before across nodes.
+*/
+//=============================================================================
+#ifndef SQUAT_WSCHED_H
+#define SQUAT_WSCHED_H
+
+#include <stdio.h>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include "fqbatch.h"
+#include "numa.h"
+
+#define WS_GRAIN 128 // records: a task is not split below twice this
+
+//=============================================================================
+// records [Begin, End) of b1 (and of its mate batch b2 for PE)
+struct WsTask
+{
+	FqBatch *b1, *b2;
+	size_t Begin, End;
+};
+
+struct WsDeque
+{
+	std::mutex m;
+	std::deque<WsTask> q;
+};
+
+// per-worker counters, a cache line each
+struct alignas(64) WsStat
+{
+	size_t Records, Bytes;
+};
+
+//=============================================================================
+struct WsScheduler
+{
+	int N; // workers
+	NumaTopo Topo;
+	std::vector<int> Node; // node of each worker
+	std::vector< std::vector<int> > Group; // workers of each node
+	std::vector<int> Busy; // nodes with workers
+	std::vector<FqBatchPool *> Pools; // batch pool of each node
+	std::vector<size_t> NextWorker; // round robin of Submit within each node
+	size_t NextNode; // round robin of NextPool
+	WsDeque *Q;
+	WsStat *Stat;
+	std::function<void(int)> Init;
+	std::function<void(int, const WsTask &)> Work;
+	std::vector<std::thread> Workers;
+	std::atomic<size_t> Queued; // tasks in the deques
+	std::atomic<int> Idle; // workers waiting for a task
+	bool Closed;
+	std::mutex WaitM;
+	std::condition_variable WaitCv;
+	std::chrono::steady_clock::time_point T0, T1;
+
+	// init(worker) once on each worker thread, then work(worker, task) for its tasks;
+	// each node's pool holds batchesPerWorker batches per worker of the node
+	WsScheduler(int n, int batchesPerWorker, std::function<void(int)> init, std::function<void(int, const WsTask &)> work)
+		: N(n < 1 ? 1 : n), NextNode(0), Init(init), Work(work), Queued(0), Idle(0), Closed(false)
+	{
+		Topo.Detect();
+		Group.resize(Topo.Nodes());
+		for (int w=0; w < N; w++)
+		{
+			Node.push_back(Topo.NodeOf(w, N));
+			Group[Node[w]].push_back(w);
+		}
+		NextWorker.assign(Topo.Nodes(), 0);
+		for (int k=0; k < Topo.Nodes(); k++)
+		{
+			Pools.push_back(new FqBatchPool(batchesPerWorker*Group[k].size() + 2, &Topo, k));
+			if (!Group[k].empty())
+				Busy.push_back(k);
+		}
+
+		Q = new WsDeque[N];
+		Stat = new WsStat[N];
+		T0 = std::chrono::steady_clock::now();
+		for (int w=0; w < N; w++)
+		{
+			Stat[w].Records = Stat[w].Bytes = 0;
+			Workers.push_back(std::thread(&WsScheduler::Loop, this, w));
+		}
+	}
+
+	~WsScheduler()
+	{
+		Close();
+		delete[] Q;
+		delete[] Stat;
+		for (size_t k=0; k < Pools.size(); k++)
+			delete Pools[k];
+	}
+
+	// the pool of the next node with workers, for the batches of the next submit
+	FqBatchPool &NextPool()
+	{
+		return *Pools[Busy[NextNode++ % Busy.size()]];
+	}
+
+	// all records of b1 (and b2), to a worker of the node of its pool
+	void Submit(FqBatch *b1, FqBatch *b2 = NULL)
+	{
+		int k = b1->Home->Node;
+		b1->Pending.store(b1->Count);
+		WsTask t = {b1, b2, 0, b1->Count};
+		Push(Group[k][NextWorker[k]++ % Group[k].size()], t);
+	}
+
+	// wait for every task, then stop the workers
+	void Close()
+	{
+		{
+			std::lock_guard<std::mutex> lk(WaitM);
+			if (Closed)
+				return;
+			Closed = true;
+		}
+		WaitCv.notify_all();
+		for (size_t w=0; w < Workers.size(); w++)
+			Workers[w].join();
+		Workers.clear();
+		T1 = std::chrono::steady_clock::now();
+	}
+
+	// after Close: merge(dst, src) of all workers into worker 0, within each node on a
+	// thread of that node first, then the nodes
+	void Reduce(std::function<void(int, int)> merge)
+	{
+		std::vector<std::thread> reducers;
+		for (size_t i=0; i < Busy.size(); i++)
+			reducers.push_back(std::thread([this, &merge](int k) {
+				Topo.Pin(k);
+				for (size_t j=1; j < Group[k].size(); j++)
+					merge(Group[k][0], Group[k][j]);
+			}, Busy[i]));
+		for (size_t i=0; i < reducers.size(); i++)
+			reducers[i].join();
+		for (size_t i=1; i < Busy.size(); i++)
+			merge(0, Group[Busy[i]][0]);
+	}
+
+	// per-node throughput over the time the workers ran
+	void Report(FILE *fp) const
+	{
+		double sec = std::chrono::duration<double>(T1 - T0).count();
+		for (size_t i=0; i < Busy.size(); i++)
+		{
+			int k = Busy[i];
+			size_t records = 0, bytes = 0;
+			for (size_t j=0; j < Group[k].size(); j++)
+			{
+				records += Stat[Group[k][j]].Records;
+				bytes += Stat[Group[k][j]].Bytes;
+			}
+			fprintf(fp, "Node %d: %lu threads, %lu records, %.1f MB, %.1f MB/s\n", Topo.Id[k], Group[k].size(),
+				records, bytes/1e6, sec > 0 ? bytes/1e6/sec : 0.0);
+		}
+	}
+
+private:
+	void Push(int w, const WsTask &t)
+	{
+		{
+			std::lock_guard<std::mutex> lk(Q[w].m);
+			Q[w].q.push_back(t);
+		}
+		Queued++;
+		{
+			std::lock_guard<std::mutex> lk(WaitM);
+		}
+		WaitCv.notify_one();
+	}
+
+	bool TakeFrom(int v, bool newest, WsTask &t)
+	{
+		std::lock_guard<std::mutex> lk(Q[v].m);
+		if (Q[v].q.empty())
+			return false;
+		if (newest)
+		{
+			t = Q[v].q.back();
+			Q[v].q.pop_back();
+		}
+		else
+		{
+			t = Q[v].q.front();
+			Q[v].q.pop_front();
+		}
+		Queued--;
+		return true;
+	}
+
+	// own newest task, or the oldest task of another worker of the node, then of any node
+	bool Take(int w, WsTask &t)
+	{
+		if (TakeFrom(w, true, t))
+			return true;
+		const std::vector<int> &g = Group[Node[w]];
+		for (size_t j=0; j < g.size(); j++)
+			if (g[j] != w && TakeFrom(g[j], false, t))
+				return true;
+		for (int k=1; k < N; k++)
+		{
+			int v = (w+k) % N;
+			if (Node[v] != Node[w] && TakeFrom(v, false, t))
+				return true;
+		}
+		return false;
+	}
+
+	void Loop(int w)
+	{
+		Topo.Pin(Node[w]);
+		if (Init)
+			Init(w);
+		for (;;)
+		{
+			WsTask t;
+			if (Take(w, t))
+			{
+				// split on demand: the upper half for an idle worker to steal
+				while (t.End - t.Begin >= 2*WS_GRAIN && Idle.load() > 0)
+				{
+					WsTask upper = {t.b1, t.b2, t.Begin + (t.End-t.Begin)/2, t.End};
+					t.End = upper.Begin;
+					Push(w, upper);
+				}
+				Work(w, t);
+				size_t n = t.End - t.Begin;
+				Stat[w].Records += n;
+				Stat[w].Bytes += t.b1->QualOff[t.End-1] + t.b1->QualLen[t.End-1] + 1 - t.b1->NameOff[t.Begin];
+				if (t.b2 != NULL)
+					Stat[w].Bytes += t.b2->QualOff[t.End-1] + t.b2->QualLen[t.End-1] + 1 - t.b2->NameOff[t.Begin];
+				if (t.b1->Pending.fetch_sub(n) == n)
+				{
+					if (t.b2 != NULL)
+						t.b2->Home->Put(t.b2);
+					t.b1->Home->Put(t.b1);
+				}
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lk(WaitM);
+			if (Queued.load() > 0)
+				continue;
+			if (Closed)
+				return;
+			Idle++;
+			WaitCv.wait(lk);
+			Idle--;
+		}
+	}
+};
+
+#endif
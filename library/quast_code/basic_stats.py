@@ -7,12 +7,33 @@
 
 import os
 import re
+import json
+import subprocess
 from os.path import join
 
 from quast_libs import fastaparser, qconfig, qutils, reporting, plotter
 from quast_libs.log import get_logger
 logger = get_logger(qconfig.LOGGER_DEFAULT_NAME)
 
+# native GC/contig statistics of SQUAT (library/asmQ), found relative to quast/quast_libs
+ASMSTATS_FPATH = join(os.path.dirname(os.path.abspath(__file__)), os.pardir, os.pardir, 'library', 'asmQ', 'asmStats')
+
+
+def native_asm_stats(contigs_fpath):
+    """
+       Returns the JSON statistics of asmStats for the assembly, or None if the tool is not built or fails
+    """
+    if not os.access(ASMSTATS_FPATH, os.X_OK):
+        return None
+    threads = getattr(qconfig, 'max_threads', None) or 1
+    cmd = [ASMSTATS_FPATH, contigs_fpath, '-t', str(threads),
+           '-b', str(qconfig.GC_bin_size), '-B', str(qconfig.GC_contig_bin_size)]
+    try:
+        return json.loads(subprocess.check_output(cmd).decode())
+    except (OSError, ValueError, subprocess.CalledProcessError):
+        logger.warning('  asmStats failed on ' + contigs_fpath + ', falling back to Python GC statistics')
+        return None
+
 def GC_content(contigs_fpath, skip=False):
     """
        Returns percent of GC for assembly and GC distribution: (list of GC%, list of # windows)
@@ -30,6 +51,10 @@ def GC_content(contigs_fpath, skip=False):
     if skip:
         return total_GC, (GC_distribution_x, GC_distribution_y), (GC_contigs_distribution_x, GC_contigs_distribution_y)
 
+    stats = native_asm_stats(contigs_fpath)
+    if stats is not None and len(stats['GC_windows']) == GC_bin_num and len(stats['GC_contigs']) == GC_contigs_bin_num:
+        return stats['GC_percent'], (GC_distribution_x, stats['GC_windows']), (GC_contigs_distribution_x, stats['GC_contigs'])
+
     for name, seq_full in fastaparser.read_fasta(contigs_fpath): # in tuples: (name, seq)
         contig_ACGT_len = len(seq_full) - seq_full.count("N")
         if not contig_ACGT_len:
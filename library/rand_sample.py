@@ -6,6 +6,8 @@ output_file, input_file, readsize, num_sample, seed = sys.argv[1], sys.argv[2],
 random.seed(seed)
 num_sample = readsize if num_sample > readsize else num_sample
 ids_file = '{0}.ids'.format(os.path.splitext(output_file)[0])
+#byte offset of each record in the output, for the subset extractor
+index_file = '{0}.fqi'.format(os.path.splitext(output_file)[0])
 
 #print("sampling {0} out of {1} records".format(num_sample, readsize))
 id_list = random.sample(range(readsize), num_sample)
@@ -13,16 +15,20 @@ id_list.sort()
 
 with open(input_file) as infile:
     with open(output_file, 'w') as w1:
-        with open(ids_file, 'w') as w2:
+        with open(ids_file, 'w') as w2, open(index_file, 'w') as w3:
             cnt = 0
             crt_idx = 0
+            offset = 0
             for line in infile:
                 if cnt == id_list[crt_idx]:
-                    w1.write('@{}\n'.format(crt_idx))
+                    w3.write('{}\n'.format(offset))
+                    record = '@{}\n'.format(crt_idx)
                     #w1.write(line)
-                    w1.write(infile.readline())
-                    w1.write(infile.readline())
-                    w1.write(infile.readline())
+                    record += infile.readline()
+                    record += infile.readline()
+                    record += infile.readline()
+                    w1.write(record)
+                    offset += len(record.encode())
                     
                     identifier = line.strip()
                     w2.write('@{0}\t{1}\n'.format(crt_idx, identifier))
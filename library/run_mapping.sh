@@ -13,7 +13,8 @@ while getopts ":h" opt; do
       echo -e "arg5: path of reference genome"
       echo -e "arg6: path of reads fastq file" 
       echo -e "arg7: number of threads" 
-      echo -e "arg8(optional): bwaOnly or bowtie2Only\n" >&2
+      echo -e "arg8(optional): bwaOnly, bowtie2Only, bwa-mem or bwa-backtrack (run a single aligner)"
+      echo -e "arg9(optional): directory of a prebuilt bwa index of the assembly (prefix scaffolds)\n" >&2
       ;;
     :)
       echo "Option -$OPTARG requires an argument." >&2
@@ -23,7 +24,7 @@ while getopts ":h" opt; do
 done
 
 if [ "$#" -lt "7" ]; then
-	echo "Using:" $0 " [SRCDIR] [OUTDIR] [dataname] [READSIZE] [REFLOC] [ECVLOC] [MAXPROCESS] [bwaOnly|bowtie2Only]"
+	echo "Using:" $0 " [SRCDIR] [OUTDIR] [dataname] [READSIZE] [REFLOC] [ECVLOC] [MAXPROCESS] [bwaOnly|bowtie2Only|bwa-mem|bwa-backtrack] [INDEXDIR]"
 	exit 1
 fi
 
@@ -47,6 +48,18 @@ READSIZE=$4
 REFLOC=$5
 ECVLOC=$6
 MAXPROCESS=$7
+ALIGNER=$8
+INDEXDIR=$9
+
+#link the shared index instead of building one per aligner
+#(index_cache.sh takes the cache of squat.sh --index-cache from SQUAT_INDEX_CACHE)
+if [[ -z "${INDEXDIR}" || ! -f "${INDEXDIR}/scaffolds.bwt" ]]; then
+	INDEXDIR=$( bash ${EXECDIR}/index_cache.sh ${SRCDIR} ${REFLOC} )
+fi
+
+function link_index {
+	ln -s "${INDEXDIR}" index
+}
 
 #mkdir -p ${OUTDIR}/imgs
 
@@ -87,7 +100,7 @@ MAXPROCESS=$7
 	#rm ${DATA}.fastq scaffolds.fasta &> /dev/null
 #fi
 
-if [[ $8 != "bowtie2Only" ]]; then
+if [[ ${ALIGNER} != "bowtie2Only" && ${ALIGNER} != "bwa-backtrack" ]]; then
 	#bwa-mem
 	echo 'BWA - MEM'
 	BWADIR=${OUTDIR}/bwa-mem
@@ -95,13 +108,16 @@ if [[ $8 != "bowtie2Only" ]]; then
 	if [ -d  ${BWADIR} ]; then
 		rm -rf ${BWADIR} &> /dev/null
 	fi
-	mkdir -p ${BWADIR}/index &> /dev/null
+	mkdir -p ${BWADIR} &> /dev/null
 	cd ${BWADIR};
+	link_index
 	ln -s ${ECVLOC} . 2>&1 > /dev/null
 	ln -s ${REFLOC} scaffolds.fasta 2>&1 > /dev/null
 	bash ${SCRIPTDIR}/bwa_mem_v1.sh ${DATA} scaffolds auto ${SRCDIR} P ${MAXPROCESS} > /dev/null 2>&1
 	#rm ${DATA}.fastq scaffolds.fasta &> /dev/null
+fi
 
+if [[ ${ALIGNER} != "bowtie2Only" && ${ALIGNER} != "bwa-mem" ]]; then
 	#bwa-end to end
 	echo 'BWA - backtrack'
 	BWADIR=${OUTDIR}/bwa-backtrack
@@ -109,8 +125,9 @@ if [[ $8 != "bowtie2Only" ]]; then
 	if [ -d  ${BWADIR} ]; then
 		rm -rf ${BWADIR}
 	fi
-	mkdir -p ${BWADIR}/index &> /dev/null
+	mkdir -p ${BWADIR} &> /dev/null
 	cd ${BWADIR};
+	link_index
 	ln -s ${ECVLOC} . 2>&1 > /dev/null
 	ln -s ${REFLOC} scaffolds.fasta 2>&1 > /dev/null
 	bash ${SCRIPTDIR}/bwa_backtrack_v4.sh ${DATA} scaffolds auto ${SRCDIR} P ${MAXPROCESS} 2>&1 > /dev/null
@@ -9,6 +9,7 @@ usage()
     echo -e "Usage: $0 seq1 seq2 ...  seqN [-o <output_dir>] [-r <ref_asm>]\n"
     echo "Optional args:"
     echo "-t    --thread    <int>   Number of threads to use" 
+    echo "-j    --jobs    <int>   Number of samples processed at the same time, sharing the thread budget, default 1" 
     echo "-f    --flush  flush The sam file after alignment" 
     echo "-s    --subset    <str>   Return the subset of sequencing reads according to labels (in capitals, e.g. PSCO)" 
     echo "-g   <str>   Path to the reference genome file for GAGE benchmark tool" 
@@ -21,23 +22,36 @@ usage()
     echo "--ot   --others-thre    <float>   Threshold for reads with other errors. Above threshold = poor quality reads, default 0.1" 
     echo "--nt   --n-thre   <float>   Threshold for reads containing N. Above threshold = poor quality reads, default 0.1" 
     echo "--seed   <int>   Specify the seed for random sampling, default 0" 
+    echo "--highq   <list>   Q thresholds of %HighQ(q) in the pre-assembly report, default 15,20" 
+    echo "--highq-cut   <list>   %HighQ coverage cut points in the pre-assembly report, default 100,95,90" 
+    echo "--screen   <list>   Comma-separated small FASTA files (PhiX, E. coli, vectors, ...) to screen the sampled reads against in the pre-assembly report" 
+    echo "--index-cache   <str>   Directory of the persistent assembly index cache, default \$SQUAT_INDEX_CACHE or SQUAT/index_cache" 
+    echo "--force    Ignore the stage checkpoints of a previous run and redo every stage" 
+    echo "--pdf    Also write report.pdf (drawn with matplotlib); the html report does not need it" 
+    echo "--fastmap    Label the reads with the built-in minimizer mapper instead of bwa, for a quick P/S/C/O/M/F/N split (fastmap_report.metrics.tsv); no quast and no post-assembly report" 
+    echo "--bulk    Only write the metrics files (pre_report/post_report.metrics.json/.tsv and <output_dir>/metrics.tsv), no html, pdf or zip" 
 }
 
 function change_id {
     cat $2 | \
-    awk -v OUT=$1 \
+    LC_ALL=C awk -v OUT=$1 \
         -v MATCH=$(dirname "$1")/$3.ids \
+        -v INDEX=$(dirname "$1")/$3.fqi \
     'BEGIN{
         id = 0
+        offset = 0
     }
     {
         if(NR%4==1){
+            print offset > INDEX
             print "@"id > OUT
             print id"\t@"$0 > MATCH
+            offset += length(id) + 2
             id+=1
         }
         else{
             print $0 > OUT
+            offset += length($0) + 1
         }
     }
     END{
@@ -55,6 +69,36 @@ function to_abs {
     echo $absolute
 }
 
+#stage checkpoints: a finished stage leaves a marker whose first line is the signature
+#of its parameters and inputs; a rerun skips the stage while the signature is unchanged
+function file_sig {
+    #cheap fingerprint of a (large) input: size, mtime and the hash of its first MB
+    echo "$( stat -L -c '%s:%Y' $1 ):$( head -c 1048576 $1 | md5sum | cut -d ' ' -f 1 )"
+}
+
+function stage_sig {
+    echo "$@" | md5sum | cut -d ' ' -f 1
+}
+
+#stage_done <ckpt_dir> <stage> <sig>
+function stage_done {
+    [[ "$FORCE" != "YES" && -f $1/$2 && "$( head -n 1 $1/$2 )" == "$3" ]]
+}
+
+#stage_mark <ckpt_dir> <stage> <sig> [VAR=value ...]
+function stage_mark {
+    local dir=$1 stage=$2
+    shift 2
+    mkdir -p ${dir} &> /dev/null
+    printf "%s\n" "$@" > ${dir}/${stage}.tmp
+    mv ${dir}/${stage}.tmp ${dir}/${stage}
+}
+
+#stage_value <ckpt_dir> <stage> <VAR>
+function stage_value {
+    sed -n "s/^$3=//p" $1/$2
+}
+
 
 if [[ $# -eq 0 ]]; then
     usage
@@ -63,6 +107,7 @@ fi
 
 #default parameter value
 MAXPROC=$(($(grep -c ^processor /proc/cpuinfo)/3))
+JOBS=1
 FLUSH_SAM=NO
 NUM_SAMPLE=1000000
 SUBSET=NONE
@@ -73,6 +118,13 @@ CR_THRE=0.3
 O_THRE=0.1
 N_THRE=0.1
 SEED=0
+FORCE=NO
+PDF=NO
+BULK=NO
+FASTMAP=NO
+HIQ_TH=15,20
+HIQ_CUT=100,95,90
+SCREEN=
 
 SEQ_LIST=()
 NUM_SEQ=0
@@ -117,6 +169,11 @@ case $key in
     shift # past argument
     shift # past value
     ;;
+    -j|--jobs)
+    JOBS="$2"
+    shift # past argument
+    shift # past value
+    ;;
     -s|--subset)
     SUBSET="$2"
     shift # past argument
@@ -170,6 +227,42 @@ case $key in
     shift # past argument
     shift # past argument
     ;;
+    --highq)
+    HIQ_TH=$2
+    shift # past argument
+    shift # past value
+    ;;
+    --highq-cut)
+    HIQ_CUT=$2
+    shift # past argument
+    shift # past value
+    ;;
+    --screen)
+    SCREEN=$( for f in ${2//,/ }; do to_abs $f; done | paste -sd, )
+    shift # past argument
+    shift # past value
+    ;;
+    --index-cache)
+    INDEXCACHE="$( to_abs "$2" )"
+    shift # past argument
+    shift # past value
+    ;;
+    --force)
+    FORCE=YES
+    shift # past argument
+    ;;
+    --pdf)
+    PDF=YES
+    shift # past argument
+    ;;
+    --bulk)
+    BULK=YES
+    shift # past argument
+    ;;
+    --fastmap)
+    FASTMAP=YES
+    shift # past argument
+    ;;
     *)    # unknown option
     echo "Unknown option: "$1 >&2
     exit 1
@@ -182,6 +275,13 @@ if [[ -z "$OUTDIR" || -z "$REFLOC" ]]; then
     exit 1
 fi
 
+for f in ${SCREEN//,/ }; do
+    if [[ ! -f $f ]]; then
+        echo "Screen reference not found: "$f >&2
+        exit 1
+    fi
+done
+
 EXECDIR="$( cd "$(dirname "$0")" ; pwd)"
 
 #write config file
@@ -192,85 +292,283 @@ echo "CR%: ${CR_THRE}" >> ${OUTDIR}/config
 echo "OR%: ${O_THRE}" >> ${OUTDIR}/config
 echo "NR%: ${N_THRE}" >> ${OUTDIR}/config
 
+#the reference index and the assembly evaluation are shared by all samples
+SHAREDDIR=${OUTDIR}/_shared
+
+#the index comes from the persistent cache keyed by the assembly content; run_mapping.sh
+#falls back to the same cache (through the environment) if the shared index is missing
+if [ -n "${INDEXCACHE}" ]; then
+    export SQUAT_INDEX_CACHE="${INDEXCACHE}"
+fi
+function build_index {
+    INDEXDIR=$( bash ${EXECDIR}/library/index_cache.sh ${EXECDIR} ${REFLOC} "${INDEXCACHE}" )
+    ln -sfn "${INDEXDIR}" ${SHAREDDIR}/index
+}
+
+function do_quast {
+    if [[ -z "$GAGELOC" && -z "$GAGE" ]]; then
+        python3 ${EXECDIR}/quast/quast.py ${REFLOC} -o ${SHAREDDIR}/quast --min-contig 200 -t ${MAXPROC} -s 2>&1 > /dev/null
+    else
+        python3 ${EXECDIR}/quast/quast.py ${REFLOC} -o ${SHAREDDIR}/quast --min-contig 200 -t ${MAXPROC} -s -R ${GAGELOC} --gage 2>&1 > /dev/null 
+    fi
+}
+
 
 function do_squat {
     ORGECV="$( to_abs $1 )"
+    SEQPROC=$2
     #echo $ECVLOC
     xbase=${ORGECV##*/}
     DATA=${xbase%.*}
     SEQDIR=${OUTDIR}/${DATA}
     ECVLOC=${SEQDIR}/${DATA}.fastq
+    CKPT=${SEQDIR}/.checkpoints
     #ECVLOC=$(dirname "$0")/${DATA}_ecv.fastq
 
-    #delete if output dir already exists
-    if [ -d ${SEQDIR} ]; then
-        rm -r ${SEQDIR} &> /dev/null
-    fi
-    mkdir ${SEQDIR} &> /dev/null
+    #sampled reads: everything in the output dir derives from them, so it is only
+    #deleted when the reads or the sampling parameters changed
+    SIG_SAMPLE=$( stage_sig sample $( file_sig ${ORGECV} ) ${FULLSET} ${NUM_SAMPLE} ${SEED} )
+    if stage_done ${CKPT} sample ${SIG_SAMPLE}; then
+        READSIZE=$( stage_value ${CKPT} sample READSIZE )
+        NUM_SAMPLE=$( stage_value ${CKPT} sample NUM_SAMPLE )
+        echo "Resume examining ${DATA}" | tee -a ${SEQDIR}/${DATA}.log
+    else
+        if [ -d ${SEQDIR} ]; then
+            rm -r ${SEQDIR} &> /dev/null
+        fi
+        mkdir ${SEQDIR} &> /dev/null
 
-    touch ${SEQDIR}/${DATA}.log
-    echo "Start examining ${DATA}" | tee -a ${SEQDIR}/${DATA}.log
+        touch ${SEQDIR}/${DATA}.log
+        echo "Start examining ${DATA}" | tee -a ${SEQDIR}/${DATA}.log
 
-    #echo "Calculate number of reads"  | tee -a ${SEQDIR}/${DATA}.log
-    if [ "$FULLSET" == "YES" ]; then
-        READSIZE=$( change_id ${ECVLOC} ${ORGECV} ${DATA} )
-        NUM_SAMPLE=${READSIZE}
-        echo "No. of reads: ${READSIZE}" | tee -a ${SEQDIR}/${DATA}.log
-    else
-        READSIZE=$(($(wc -l $ORGECV | cut -d ' ' -f 1)/4))
-        if [ "$NUM_SAMPLE" -gt "$READSIZE" ]; then
-            NUM_SAMPLE=$( change_id ${ECVLOC} ${ORGECV} ${DATA} )
-            echo "No. of reads: ${NUM_SAMPLE}" | tee -a ${SEQDIR}/${DATA}.log
+        #echo "Calculate number of reads"  | tee -a ${SEQDIR}/${DATA}.log
+        if [ "$FULLSET" == "YES" ]; then
+            READSIZE=$( change_id ${ECVLOC} ${ORGECV} ${DATA} )
+            NUM_SAMPLE=${READSIZE}
+            echo "No. of reads: ${READSIZE}" | tee -a ${SEQDIR}/${DATA}.log
         else
-            echo "sampling ${NUM_SAMPLE} out of ${READSIZE} records" | tee -a  ${SEQDIR}/${DATA}.log
-            python3 ${EXECDIR}/library/rand_sample.py ${ECVLOC} ${ORGECV} ${READSIZE} ${NUM_SAMPLE} ${SEED}
+            READSIZE=$(($(wc -l $ORGECV | cut -d ' ' -f 1)/4))
+            if [ "$NUM_SAMPLE" -gt "$READSIZE" ]; then
+                NUM_SAMPLE=$( change_id ${ECVLOC} ${ORGECV} ${DATA} )
+                echo "No. of reads: ${NUM_SAMPLE}" | tee -a ${SEQDIR}/${DATA}.log
+            else
+                echo "sampling ${NUM_SAMPLE} out of ${READSIZE} records" | tee -a  ${SEQDIR}/${DATA}.log
+                python3 ${EXECDIR}/library/rand_sample.py ${ECVLOC} ${ORGECV} ${READSIZE} ${NUM_SAMPLE} ${SEED}
+            fi
         fi
+        stage_mark ${CKPT} sample ${SIG_SAMPLE} READSIZE=${READSIZE} NUM_SAMPLE=${NUM_SAMPLE}
     fi
 
     #map reads to genome using alignment tools
-    echo "BWA read mapping" | tee -a ${SEQDIR}/${DATA}.log
-    bash ${EXECDIR}/library/run_mapping.sh ${EXECDIR} ${SEQDIR} ${DATA} ${READSIZE} ${REFLOC} ${ECVLOC} ${MAXPROC} | tee -a ${SEQDIR}/${DATA}.log
-
-    #quast evaluation
-    echo "Evaluate genome assemblies" | tee -a ${SEQDIR}/${DATA}.log
-    if [[ -z "$GAGELOC" && -z "$GAGE" ]]; then
-        python3 ${EXECDIR}/quast/quast.py ${REFLOC} -o ${SEQDIR}/quast --min-contig 200 -t ${MAXPROC} -s 2>&1 > /dev/null
+    #bwa-mem, bwa-backtrack and the pre-Q report are independent, so they run side by side
+    #within the thread budget of the sample; the index dir name is the assembly content key
+    SIG_SCREEN=$( for f in ${SCREEN//,/ }; do file_sig $f; done )
+    SIG_PREQ=$( stage_sig preQ ${SIG_SAMPLE} $( file_sig ${EXECDIR}/library/preQ/readQdist ) ${BULK} ${HIQ_TH} ${HIQ_CUT} ${SIG_SCREEN} )
+    #readQdist streams the reads and needs few threads: beside the mappers it gets a
+    #quarter of the budget and they share the rest, so the stages stay within SEQPROC
+    MAPPROC=${SEQPROC}
+    PREQPROC=${SEQPROC}
+    if ! stage_done ${CKPT} preQ ${SIG_PREQ}; then
+        PREQPROC=$(( SEQPROC/4 > 0 ? SEQPROC/4 : 1 ))
+        MAPPROC=$(( SEQPROC-PREQPROC > 0 ? SEQPROC-PREQPROC : 1 ))
+    fi
+    PIDS=()
+    if [[ "$FASTMAP" == "YES" ]]; then
+        #quick labels of the built-in mapper, in the same ids files as the bwa scripts
+        SIG_FASTMAP=$( stage_sig fastmap ${SIG_SAMPLE} $( file_sig ${REFLOC} ) $( file_sig ${EXECDIR}/library/map_proc/utils/fastMap ) )
+        echo "Built-in read mapping" | tee -a ${SEQDIR}/${DATA}.log
+        if stage_done ${CKPT} fastmap ${SIG_FASTMAP}; then
+            echo "fastmap: up to date" | tee -a ${SEQDIR}/${DATA}.log
+        else
+            mkdir -p ${SEQDIR}/fastmap/ids &> /dev/null
+            ( ${EXECDIR}/library/map_proc/utils/fastMap ${REFLOC} ${ECVLOC} ${SEQDIR}/fastmap/ids/${DATA} -t ${MAPPROC} -m ${SEQDIR}/fastmap_report >> ${SEQDIR}/${DATA}.log 2>&1 && \
+                stage_mark ${CKPT} fastmap ${SIG_FASTMAP} ) &
+            PIDS+=($!)
+        fi
     else
-        python3 ${EXECDIR}/quast/quast.py ${REFLOC} -o ${SEQDIR}/quast --min-contig 200 -t ${MAXPROC} -s -R ${GAGELOC} --gage 2>&1 > /dev/null 
+        REFKEY=$( basename $( readlink -f ${SHAREDDIR}/index ) )
+        #a run with -f deletes the sam files, so the flag is part of the mapping signatures
+        SIG_MEM=$( stage_sig bwa-mem ${SIG_SAMPLE} ${REFKEY} ${FLUSH_SAM} )
+        SIG_BT=$( stage_sig bwa-backtrack ${SIG_SAMPLE} ${REFKEY} ${FLUSH_SAM} )
+        MEMPROC=$(( (MAPPROC+1)/2 ))
+        BTPROC=$(( MAPPROC/2 > 0 ? MAPPROC/2 : 1 ))
+        echo "BWA read mapping" | tee -a ${SEQDIR}/${DATA}.log
+        if stage_done ${CKPT} bwa-mem ${SIG_MEM}; then
+            echo "bwa-mem: up to date" | tee -a ${SEQDIR}/${DATA}.log
+        else
+            ( bash ${EXECDIR}/library/run_mapping.sh ${EXECDIR} ${SEQDIR} ${DATA} ${READSIZE} ${REFLOC} ${ECVLOC} ${MEMPROC} bwa-mem ${SHAREDDIR}/index >> ${SEQDIR}/${DATA}.log 2>&1 && \
+                stage_mark ${CKPT} bwa-mem ${SIG_MEM} ) &
+            PIDS+=($!)
+        fi
+        if stage_done ${CKPT} bwa-backtrack ${SIG_BT}; then
+            echo "bwa-backtrack: up to date" | tee -a ${SEQDIR}/${DATA}.log
+        else
+            ( bash ${EXECDIR}/library/run_mapping.sh ${EXECDIR} ${SEQDIR} ${DATA} ${READSIZE} ${REFLOC} ${ECVLOC} ${BTPROC} bwa-backtrack ${SHAREDDIR}/index >> ${SEQDIR}/${DATA}.log 2>&1 && \
+                stage_mark ${CKPT} bwa-backtrack ${SIG_BT} ) &
+            PIDS+=($!)
+        fi
     fi
 
     #pre-Q report
     echo "Generate pre-assembly reports" | tee -a ${SEQDIR}/${DATA}.log
-    ${EXECDIR}/library/preQ/readQdist ${ECVLOC} ${SEQDIR}/pre_report 2>&1 > /dev/null
-    cp -r ${EXECDIR}/library/preQ/link ${SEQDIR}/
+    #all of the budget if no mapper runs
+    if [ ${#PIDS[@]} -eq 0 ]; then
+        PREQPROC=${SEQPROC}
+    fi
+    PREQ_OPT="-q ${HIQ_TH} -c ${HIQ_CUT} -t ${PREQPROC}"
+    if [[ "$BULK" == "YES" ]]; then
+        PREQ_OPT="${PREQ_OPT} -m"
+    fi
+    if [[ -n "$SCREEN" ]]; then
+        PREQ_OPT="${PREQ_OPT} -k ${SCREEN}"
+    fi
+    if ! stage_done ${CKPT} preQ ${SIG_PREQ}; then
+        ( ${EXECDIR}/library/preQ/readQdist ${ECVLOC} ${SEQDIR}/pre_report ${PREQ_OPT} 2>&1 > /dev/null && \
+            stage_mark ${CKPT} preQ ${SIG_PREQ} ) &
+        PIDS+=($!)
+    fi
+
+    #every stage is reaped before a failure ends the sample
+    RC=0
+    for pid in ${PIDS[@]}; do
+        wait ${pid} || RC=$?
+    done
+    if [ "$RC" -ne 0 ]; then
+        echo "A mapping or pre-Q stage of ${DATA} failed" | tee -a ${SEQDIR}/${DATA}.log
+        return ${RC}
+    fi
+
+    if [[ "$FASTMAP" == "YES" ]]; then
+        if [ ! -f ${SEQDIR}/fastmap_report.metrics.tsv ]; then
+            echo "Built-in read mapping of ${DATA} failed" | tee -a ${SEQDIR}/${DATA}.log
+            return 1
+        fi
+        grep "^fastmap_" ${SEQDIR}/fastmap_report.metrics.tsv | tee -a ${SEQDIR}/${DATA}.log
+        return 0
+    fi
+
+    #label concordance of the two aligners, with the ids of the reads they disagree on
+    SIG_CONCORD=$( stage_sig concordance ${SIG_MEM} ${SIG_BT} )
+    if [[ -x ${EXECDIR}/library/map_proc/utils/samConcord ]] && ! stage_done ${CKPT} concordance ${SIG_CONCORD}; then
+        echo "Compare the labels of the aligners" | tee -a ${SEQDIR}/${DATA}.log
+        mkdir -p ${SEQDIR}/concordance &> /dev/null
+        ${EXECDIR}/library/map_proc/utils/samConcord ${SEQDIR}/bwa-mem/${DATA}_ecv_all.sam ${SEQDIR}/bwa-backtrack/${DATA}_ecv_all.sam \
+            -1 mem -2 backtrack -o ${SEQDIR}/concordance/${DATA} | tee -a ${SEQDIR}/${DATA}.log
+        #tee is the status of the pipe; the stage is only done if samConcord was
+        if [ ${PIPESTATUS[0]} -ne 0 ]; then
+            echo "Label concordance of ${DATA} failed" | tee -a ${SEQDIR}/${DATA}.log
+            return 1
+        fi
+        stage_mark ${CKPT} concordance ${SIG_CONCORD}
+    fi
+
+    #quast evaluation of the assembly is shared
+    ln -sfn ${SHAREDDIR}/quast ${SEQDIR}/quast
     
-    #analysis modules
+    #analysis modules; the alignment info is cached next to the sam files, so new
+    #thresholds or subset labels only redo the labeling-derived plots and the report
+    SIG_REPORT=$( stage_sig report ${SIG_MEM} ${SIG_BT} ${SIG_PREQ} ${SIG_QUAST} ${CRITERIA} ${NM_THRE} ${CR_THRE} ${O_THRE} ${N_THRE} ${SUBSET} ${PDF} ${BULK} )
+    if stage_done ${CKPT} report ${SIG_REPORT}; then
+        echo "Reports of ${DATA}: up to date" | tee -a ${SEQDIR}/${DATA}.log
+        return 0
+    fi
     echo "Generate post-assembly reports" | tee -a ${SEQDIR}/${DATA}.log
     if [[ "$SUBSET" != "NONE" ]]; then
         mkdir -p ${SEQDIR}/subset &> /dev/null
     fi
-    mkdir -p ${SEQDIR}/images &> /dev/null
-    python3 ${EXECDIR}/library/gen_report.py -o ${OUTDIR} -i ${ECVLOC} -d ${DATA} -n ${NUM_SAMPLE} -t ${READSIZE} -s ${SUBSET} -r ${REFLOC} -e ${EXECDIR} | tee -a ${SEQDIR}/${DATA}.log
+    REPORT_OPT=""
+    if [[ "$BULK" == "YES" ]]; then
+        REPORT_OPT="--bulk"
+    elif [[ "$PDF" == "YES" ]]; then
+        REPORT_OPT="--pdf"
+    fi
+    python3 ${EXECDIR}/library/gen_report.py -o ${OUTDIR} -i ${ECVLOC} -d ${DATA} -n ${NUM_SAMPLE} -t ${READSIZE} -s ${SUBSET} -r ${REFLOC} -e ${EXECDIR} ${REPORT_OPT} | tee -a ${SEQDIR}/${DATA}.log
+    if [ ${PIPESTATUS[0]} -ne 0 ]; then
+        echo "Reports of ${DATA} failed" | tee -a ${SEQDIR}/${DATA}.log
+        return 1
+    fi
 
     #flush sam files
     if [ "$FLUSH_SAM" == "YES" ]; then
         echo "Flushing sam files" | tee -a ${SEQDIR}/${DATA}.log
         for tool in bwa-mem bwa-backtrack; do
-            rm ${SEQDIR}/${tool}/${DATA}_ecv_all.sam
+            rm -f ${SEQDIR}/${tool}/${DATA}_ecv_all.sam
         done
     fi
 
+    if [[ "$BULK" == "YES" ]]; then
+        stage_mark ${CKPT} report ${SIG_REPORT}
+        return 0
+    fi
+
     echo "Compress reports into zip"
     cd ${OUTDIR}
     if [ -d ${DATA}_report.zip ]; then
         rm ${DATA}_report.zip &> /dev/null
     fi
     mkdir -p ${DATA}_report/${DATA}; cp ${DATA}.html ${DATA}_report/
-    cp -r ${DATA}/*report.htm* ${DATA}/link ${DATA}_report/${DATA}/ 2>&1 > /dev/null
+    cp -r ${DATA}/*report.htm* ${DATA}_report/${DATA}/ 2>&1 > /dev/null
     zip ${DATA}_report.zip -r9 ${DATA}_report &> /dev/null
     rm -r ${DATA}_report &> /dev/null
+
+    stage_mark ${CKPT} report ${SIG_REPORT}
 }
 
+#shared stages first: the index build is single-threaded, so quast runs alongside it;
+#the built-in mapper indexes the assembly itself and has no report for quast
+mkdir -p ${SHAREDDIR} &> /dev/null
+if [[ "$FASTMAP" != "YES" ]]; then
+    echo "Build reference index and evaluate genome assemblies"
+    build_index &
+    INDEX_PID=$!
+    SIG_QUAST=$( stage_sig quast $( file_sig ${REFLOC} ) ${GAGELOC} ${GAGE} )
+    if stage_done ${SHAREDDIR}/.checkpoints quast ${SIG_QUAST}; then
+        echo "quast: up to date"
+    else
+        ( do_quast && stage_mark ${SHAREDDIR}/.checkpoints quast ${SIG_QUAST} ) &
+        QUAST_PID=$!
+    fi
+    wait ${INDEX_PID}
+    if [ -n "$QUAST_PID" ]; then
+        wait ${QUAST_PID}
+    fi
+fi
+
+#sample scheduler: at most JOBS samples at a time, each with an equal share of the threads
+SEQPROC=$(( MAXPROC/JOBS > 0 ? MAXPROC/JOBS : 1 ))
+RUNNING=0
+FAILED=0
 for ((i=0;i<$NUM_SEQ;i++)); do
-    do_squat ${SEQ_LIST[$i]}
-done
\ No newline at end of file
+    if [ "$RUNNING" -ge "$JOBS" ]; then
+        wait -n || FAILED=$(($FAILED+1))
+        RUNNING=$(($RUNNING-1))
+    fi
+    ( do_squat ${SEQ_LIST[$i]} ${SEQPROC} ) &
+    RUNNING=$(($RUNNING+1))
+done
+while [ "$RUNNING" -gt 0 ]; do
+    wait -n || FAILED=$(($FAILED+1))
+    RUNNING=$(($RUNNING-1))
+done
+
+#one long table of all samples for monitoring: sample, metric, value
+echo -e "sample\tmetric\tvalue" > ${OUTDIR}/metrics.tsv
+for ((i=0;i<$NUM_SEQ;i++)); do
+    xbase=${SEQ_LIST[$i]##*/}
+    for report in post_report fastmap_report; do
+        if [ -f ${OUTDIR}/${xbase%.*}/${report}.metrics.tsv ]; then
+            tail -n +2 ${OUTDIR}/${xbase%.*}/${report}.metrics.tsv | awk -v S=${xbase%.*} '{ print S"\t"$0 }' >> ${OUTDIR}/metrics.tsv
+        fi
+    done
+    #the post-assembly report carries the pre-Q numbers as preq_*; without it (--fastmap)
+    #they come from the pre-Q report itself, under the same names
+    if [[ ! -f ${OUTDIR}/${xbase%.*}/post_report.metrics.tsv && -f ${OUTDIR}/${xbase%.*}/pre_report.metrics.tsv ]]; then
+        awk -F '\t' -v S=${xbase%.*} 'NR > 1 && $1 !~ /^(format|version|tool|input)$/ { print S"\tpreq_"$0 }' \
+            ${OUTDIR}/${xbase%.*}/pre_report.metrics.tsv >> ${OUTDIR}/metrics.tsv
+    fi
+done
+
+if [ "$FAILED" -gt 0 ]; then
+    echo "${FAILED} of ${NUM_SEQ} samples failed, see the log of each sample" >&2
+    exit 1
+fi